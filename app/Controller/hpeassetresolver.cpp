@@ -0,0 +1,200 @@
+/**
+ * @file hpeassetresolver.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-25
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpeassetresolver.h"
+
+#include <QFileInfo>
+#include <QUrl>
+
+#include "hpelinkscanner.h"
+
+HPEAssetResolver::HPEAssetResolver(QObject *parent)
+    : QObject{parent}, m_watcher(this)
+{
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString& path){
+        {
+            QMutexLocker locker(&m_mutex);
+            ++m_revisions[path];
+        }
+        invalidate(path);
+        emit assetsChanged(path);
+    });
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& path){
+        invalidate(path);
+        //the folders may get created or removed
+        watchFolders();
+        emit assetsChanged(path);
+    });
+}
+
+void HPEAssetResolver::setFilePath(const QString &filePath)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(filePath == m_filePath)
+            return;
+
+        QFileInfo fileInfo(filePath);
+        m_filePath = filePath;
+        m_assetDir = QDir(fileInfo.absolutePath() + "/" + fileInfo.baseName());
+        m_sourceDir = fileInfo.absoluteDir();
+        if(m_sourceDir.dirName() != "source")
+            m_sourceDir.cdUp();
+        m_assets.clear();
+        ++m_generation;
+    }
+
+    if(!m_watcher.files().isEmpty())
+        m_watcher.removePaths(m_watcher.files());
+    if(!m_watcher.directories().isEmpty())
+        m_watcher.removePaths(m_watcher.directories());
+    watchFolders();
+}
+
+HPEAssetResolver::Asset HPEAssetResolver::resolve(const QString &imagePath)
+{
+    Asset asset;
+    //if it's url, remain the same
+    if(HPELinkScanner::isUrl(imagePath))
+    {
+        asset.url = imagePath;
+        return asset;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    //not against the working directory
+    if(m_filePath.isEmpty())
+    {
+        asset.url = imagePath;
+        return asset;
+    }
+    auto it = m_assets.constFind(imagePath);
+    if(it != m_assets.constEnd())
+        return *it;
+
+    const quint64 generation = m_generation;
+    QFileInfo fileInfo(absolutePathOf(imagePath));
+    locker.unlock();
+
+    //the file system is accessed without the lock, the getters called from the GUI thread don't wait for it
+    asset.filePath = fileInfo.absoluteFilePath();
+    asset.url = QUrl::fromLocalFile(asset.filePath).toString();
+    asset.exists = fileInfo.isFile();
+    asset.size = asset.exists ? fileInfo.size() : 0;
+
+    locker.relock();
+    asset.revision = m_revisions.value(asset.filePath);
+    if(asset.revision > 0)
+        asset.url += QString("?v=%1").arg(asset.revision);
+    //not cached if it may be stale already
+    if(m_generation == generation)
+        m_assets.insert(imagePath, asset);
+    locker.unlock();
+
+    //m_watcher lives in the thread of the resolver
+    if(asset.exists)
+        QMetaObject::invokeMethod(this, [this, filePath = asset.filePath]{
+            if(!m_watcher.files().contains(filePath))
+                m_watcher.addPath(filePath);
+        });
+    return asset;
+}
+
+bool HPEAssetResolver::hasFilePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_filePath.isEmpty();
+}
+
+QFileInfoList HPEAssetResolver::images() const
+{
+    QFileInfoList imageFiles;
+    if(!hasFilePath())
+        return imageFiles;
+
+    const QStringList filters = { "*.jpeg", "*.jpg", "*.png", "*.tiff" };
+    QDir dir = assetDir();
+    if(dir.exists())
+        imageFiles.append(dir.entryInfoList(filters, QDir::Files));
+    dir = imagesDir();
+    if(sourceDir().dirName() == "source" && dir.exists())
+        imageFiles.append(dir.entryInfoList(filters, QDir::Files));
+    return imageFiles;
+}
+
+QDir HPEAssetResolver::assetDir() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_assetDir;
+}
+
+QDir HPEAssetResolver::sourceDir() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sourceDir;
+}
+
+QDir HPEAssetResolver::imagesDir() const
+{
+    QMutexLocker locker(&m_mutex);
+    return QDir(m_sourceDir.absoluteFilePath("images"));
+}
+
+bool HPEAssetResolver::isAsset(const QString &filePath) const
+{
+    if(!hasFilePath())
+        return false;
+
+    const QString canonicalPath = QFileInfo(filePath).canonicalFilePath();
+    if(canonicalPath.isEmpty())
+        return false;
+    for(const QDir& dir : { assetDir(), imagesDir() })
+    {
+        const QString canonicalDir = dir.canonicalPath();
+        if(!canonicalDir.isEmpty() && canonicalPath.startsWith(canonicalDir + "/"))
+            return true;
+    }
+    return false;
+}
+
+QString HPEAssetResolver::absolutePathOf(const QString &imagePath) const
+{
+    if(imagePath.startsWith("/images"))
+        return m_sourceDir.absolutePath() + imagePath;
+    return m_assetDir.absolutePath() + "/" + imagePath;
+}
+
+void HPEAssetResolver::watchFolders()
+{
+    const QStringList directories = m_watcher.directories();
+    for(const QDir& dir : { assetDir(), imagesDir() })
+    {
+        //watch the parent folder to know when the folder gets created
+        QString path = dir.exists() ? dir.absolutePath() : QFileInfo(dir.absolutePath()).absolutePath();
+        if(QFileInfo(path).isDir() && !directories.contains(path))
+            m_watcher.addPath(path);
+    }
+}
+
+void HPEAssetResolver::invalidate(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    const QString folder = path + "/";
+    for(auto it = m_assets.begin(); it != m_assets.end();)
+    {
+        if(it->filePath == path || it->filePath.startsWith(folder))
+            it = m_assets.erase(it);
+        else
+            ++it;
+    }
+}
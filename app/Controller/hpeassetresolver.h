@@ -0,0 +1,214 @@
+/**
+ * @file hpeassetresolver.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-25
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEASSETRESOLVER_H
+#define HPEASSETRESOLVER_H
+
+#include <QObject>
+#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QFileSystemWatcher>
+
+/**
+ * @class HPEAssetResolver
+ * @brief An HPEAssetResolver resolves images' paths of the current post and caches the results
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * Hexo posts refer to images in two ways:
+ * @code
+ *      ![](image.png)              // in the assets folder, <post dir>/<post name>/image.png
+ *      ![](/images/image.png)      // in <source>/images/image.png
+ * @endcode
+ * 
+ * resolve() maps such a path to a local URL, and also tells whether the file exists and its size.
+ * The results are cached by the path, so converting the same images again never touches the filesystem.
+ * URLs (scheme://...) remain the same and are not cached.
+ * 
+ * A QFileSystemWatcher watches the assets folder, the images folder (or their parents if they don't exist),
+ * and every resolved file.
+ * When any of them changes, the entries under it are dropped and assetsChanged() is emitted.
+ * A changed file gets a new revision, which is appended to its URL (?v=), so the web page
+ * doesn't show the copy it has cached.
+ * 
+ * Nothing is resolved until setFilePath() is called: resolve() returns the path as it is,
+ * and images() returns no files.
+ * 
+ * resolve() and the getters are thread-safe, HPEMarkdownConverter calls resolve() in its worker thread.
+ * setFilePath() must be called in the thread the resolver lives in.
+*/
+class HPEAssetResolver : public QObject
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief The result of resolve()
+     * 
+    */
+    struct Asset
+    {
+        /**
+         * @brief The local URL of the image, or the path itself if it is a URL
+         * 
+        */
+        QString url;
+
+        /**
+         * @brief The absolute path of the image, empty for URLs
+         * 
+        */
+        QString filePath;
+
+        bool exists = false;
+        qint64 size = 0;
+
+        /**
+         * @brief How many times the file has changed, 0 if it hasn't
+         * 
+        */
+        int revision = 0;
+    };
+
+    /**
+     * @brief Construct an HPEAssetResolver with parent
+     * 
+     * @param[in] parent 
+    */
+    explicit HPEAssetResolver(QObject *parent = nullptr);
+
+    /**
+     * @brief Set the path of the current post.
+     * The cache is cleared and the folders of the post are watched.
+     * 
+     * @param[in] filePath 
+    */
+    void setFilePath(const QString& filePath);
+
+    /**
+     * @brief Resolve an image path in Hexo's style
+     * 
+     * @param[in] imagePath The path written in the post
+     * @return The resolved Asset
+    */
+    Asset resolve(const QString& imagePath);
+
+    /**
+     * @brief Returns whether setFilePath() has been called, the folders below are meaningless before it
+     * 
+    */
+    bool hasFilePath() const;
+
+    /**
+     * @brief Returns the image files in the assets folder and the images folder,
+     * empty before setFilePath() is called
+     * 
+    */
+    QFileInfoList images() const;
+
+    /**
+     * @brief Returns the assets folder of the current post, <post dir>/<post name>
+     * 
+    */
+    QDir assetDir() const;
+
+    /**
+     * @brief Returns the 'source' folder of the current Hexo project
+     * 
+    */
+    QDir sourceDir() const;
+
+    /**
+     * @brief Returns the 'source/images' folder of the current Hexo project
+     * 
+    */
+    QDir imagesDir() const;
+
+    /**
+     * @brief Returns whether filePath is a file in the assets folder or the images folder,
+     * after resolving symbolic links and '..'. Always false before setFilePath() is called.
+     * 
+     * @param[in] filePath An absolute path
+    */
+    bool isAsset(const QString& filePath) const;
+
+private:
+
+    /**
+     * @brief Returns the absolute path of imagePath (not a URL), without the lock
+     * 
+    */
+    QString absolutePathOf(const QString& imagePath) const;
+
+    /**
+     * @brief Watch the assets folder and the images folder, or their parents if they don't exist
+     * 
+    */
+    void watchFolders();
+
+    /**
+     * @brief Drop the entries of path, or of the files under it if it is a folder
+     * 
+    */
+    void invalidate(const QString& path);
+
+    /**
+     * @brief Guards all members below, except m_watcher
+     * 
+    */
+    mutable QMutex m_mutex;
+
+    QHash<QString, Asset> m_assets;
+
+    /**
+     * @brief The revisions of the changed files, by absolute path
+     * 
+    */
+    QHash<QString, int> m_revisions;
+
+    /**
+     * @brief Increased whenever entries are dropped, resolve() doesn't cache an entry
+     * it stat()ed while the generation changed
+     * 
+    */
+    quint64 m_generation = 0;
+
+    QString m_filePath;
+    QDir m_assetDir;
+    QDir m_sourceDir;
+
+    /**
+     * @brief Only used in the thread the resolver lives in
+     * 
+    */
+    QFileSystemWatcher m_watcher;
+
+signals:
+/**
+ * @defgroup signals
+ * @{
+*/
+
+    /**
+     * @brief This signal is emitted when a watched file or folder changes
+     * 
+     * @param[in] path The changed file or folder
+    */
+    void assetsChanged(const QString& path);
+/**
+ * @}
+*/
+};
+
+#endif // HPEASSETRESOLVER_H
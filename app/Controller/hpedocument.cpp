@@ -12,15 +12,493 @@
 
 #include "hpedocument.h"
 
+#include "hpesettings.h"
+#include "hpedocumentschemehandler.h"
+#include "hpemarkdownrenderer.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+#include "QsLog.h"
+
 HPEDocument::HPEDocument(QObject *parent)
-    : QObject{parent} { }
+    : QObject{parent}
+{
+    m_lines.append(QString());
+    m_blockLineCounts.append(1);
+    m_blockStarts.append(0);
+    m_deltaMode = HPESettings::config()->value("preview/deltaUpdates", true).toBool();
+
+    m_scrollTimer.setSingleShot(true);
+    m_scrollTimer.setInterval(SCROLL_INTERVAL);
+    connect(&m_scrollTimer, &QTimer::timeout, this, [this]{
+        int line  = qBound(0, m_scrollLine, int(m_lines.size()) - 1);
+        int block = blockOfLine(line);
+        emit scrollRequested(block, line - firstLineOfBlock(block) + m_scrollLineOffset, m_blockLineCounts.at(block),
+                             (line + m_scrollLineOffset) / m_lines.size());
+    });
+}
 
 void HPEDocument::setText(const QString &text)
 {
-    if (text == m_text)
+    if (text == this->text())
+        return;
+
+    int lastOldBlock;
+    m_lines = text.split('\n');
+    m_blockLineCounts = splitBlocks(0, 0, m_lines.size(), 0, &lastOldBlock);
+    updateBlockStarts(0);
+    m_linkDefinitions = collectLinkDefinitions();
+    ++m_version;
+    //qDebug() << text;
+    m_pendingResync = true;
+    emit pendingChanged();
+    if(m_autoPublish)
+        publish();
+}
+
+void HPEDocument::applyChange(int from, int to, const QStringList &lines)
+{
+    if(from < 0 || to < from || to > m_lines.size())
+        return;
+
+    //the block boundary at 'from' depends on the line before it
+    int firstBlock = blockOfLine(qMax(from - 1, 0));
+    int startLine  = firstLineOfBlock(firstBlock);
+
+    bool definitionsTouched = containsLinkDefinition(m_lines.mid(from, to - from)) || containsLinkDefinition(lines);
+
+    int lineDelta = lines.size() - (to - from);
+    if(lineDelta > 0)
+        m_lines.insert(from, lineDelta, QString());
+    else if(lineDelta < 0)
+        m_lines.remove(from, -lineDelta);
+    for(int i = 0; i < lines.size(); ++i)
+        m_lines[from + i] = lines.at(i);
+    if(m_lines.isEmpty())
+        m_lines.append(QString());
+    ++m_version;
+
+    int lastOldBlock;
+    QList<int> lineCounts = splitBlocks(startLine, firstBlock, from + lines.size(), lineDelta, &lastOldBlock);
+    recordChange(firstBlock, lastOldBlock);
+    int blockDelta = lineCounts.size() - (lastOldBlock - firstBlock);
+    if(blockDelta > 0)
+        m_blockLineCounts.insert(firstBlock, blockDelta, 0);
+    else if(blockDelta < 0)
+        m_blockLineCounts.remove(firstBlock, -blockDelta);
+    for(int i = 0; i < lineCounts.size(); ++i)
+        m_blockLineCounts[firstBlock + i] = lineCounts.at(i);
+    updateBlockStarts(firstBlock);
+
+    //blocks elsewhere may refer to the changed definitions
+    if(definitionsTouched)
+    {
+        QMap<QString, QString> linkDefinitions = collectLinkDefinitions();
+        if(linkDefinitions != m_linkDefinitions)
+        {
+            m_linkDefinitions = linkDefinitions;
+            m_pendingResync = true;
+        }
+    }
+
+    emit pendingChanged();
+    if(m_autoPublish)
+        publish();
+}
+
+void HPEDocument::publish()
+{
+    if(!hasPendingChanges())
         return;
-    m_text = text;
-    //qDebug() << m_text;
-    emit textChanged(m_text);
+
+    if(!m_deltaMode)
+    {
+        QString text = this->text();
+        if(isPayload(text.size()))
+            emit textStored(storePayload(m_version, text.toUtf8(), "text/markdown;charset=utf-8"));
+        else
+            emit textChanged(text);
+    }
+    else if(m_pendingResync)
+        emitPatch(0, m_publishedBlockCount, blockTexts(0, m_blockLineCounts), true);
+    else
+    {
+        int to = m_blockLineCounts.size() - m_pendingTail;
+        emitPatch(m_pendingFrom, m_publishedBlockCount - m_pendingTail,
+                  blockTexts(firstLineOfBlock(m_pendingFrom), m_blockLineCounts.mid(m_pendingFrom, to - m_pendingFrom)));
+    }
+
+    m_publishedVersion = m_version;
+    m_publishedBlockCount = m_blockLineCounts.size();
+    m_pendingFrom = -1;
+    m_pendingTail = 0;
+    m_pendingResync = false;
+    m_pendingInline = false;
+}
+
+bool HPEDocument::hasPendingChanges() const
+{
+    return m_pendingResync || m_pendingFrom >= 0;
+}
+
+void HPEDocument::setAutoPublish(bool autoPublish)
+{
+    m_autoPublish = autoPublish;
+}
+
+int HPEDocument::publishedVersion() const
+{
+    return m_publishedVersion;
+}
+
+void HPEDocument::setHtmlRenderer(const std::function<QString (const QString &)> &renderer)
+{
+    m_htmlRenderer = renderer;
+}
+
+void HPEDocument::setRenderContext(const QString &context)
+{
+    size_t renderContext = qHash(context);
+    if(renderContext == m_renderContext)
+        return;
+
+    if(m_htmlCache.hits() + m_htmlCache.misses() > 0)
+        QLOG_DEBUG() << QString("HPEDocument: HTML cache %1 hits, %2 misses (%3%)")
+                       .arg(m_htmlCache.hits()).arg(m_htmlCache.misses()).arg(m_htmlCache.hitRate() * 100, 0, 'f', 1);
+    m_htmlCache.resetCounters();
+    m_renderContext = renderContext;
+}
+
+const HPEHtmlCache &HPEDocument::htmlCache() const
+{
+    return m_htmlCache;
+}
+
+QString HPEDocument::text() const
+{
+    return m_lines.join('\n');
+}
+
+QStringList HPEDocument::lines(int from, int to) const
+{
+    from = qBound(0, from, int(m_lines.size()));
+    return m_lines.mid(from, qBound(from, to, int(m_lines.size())) - from);
+}
+
+int HPEDocument::version() const
+{
+    return m_version;
+}
+
+void HPEDocument::requestResync()
+{
+    m_pendingResync = true;
+    publish();
+}
+
+void HPEDocument::requestInlineResync()
+{
+    m_pendingInline = true;
+    requestResync();
+}
+
+QStringList HPEDocument::renderHtml(const QStringList &texts)
+{
+    QStringList html;
+    if(!m_htmlRenderer)
+        return html;
+
+    html.reserve(texts.size());
+    for(const QString& text : texts)
+        html.append(m_htmlCache.html(text, m_renderContext, m_htmlRenderer));
+    return html;
 }
 
+void HPEDocument::setFocusLine(int line)
+{
+    m_focusLine = qMax(line, 0);
+    int focusBlock = blockOfLine(m_focusLine);
+    if(focusBlock != m_focusBlock)
+    {
+        m_focusBlock = focusBlock;
+        emit focusChanged(focusBlock);
+    }
+}
+
+void HPEDocument::scrollToLine(int line, double lineOffset)
+{
+    setFocusLine(line);
+    m_scrollLine = line;
+    m_scrollLineOffset = qBound(0.0, lineOffset, 1.0);
+    //throttled rather than debounced, so the page follows the editor while scrolling
+    if(!m_scrollTimer.isActive())
+        m_scrollTimer.start();
+}
+
+bool HPEDocument::takePayload(int version, QByteArray &data, QByteArray &contentType)
+{
+    auto it = m_payloads.find(version);
+    if(it == m_payloads.end())
+        return false;
+
+    data = it->data;
+    contentType = it->contentType;
+    m_payloads.erase(it);
+    return true;
+}
+
+void HPEDocument::acknowledge(int version, double renderTime)
+{
+    emit acknowledged(version, renderTime);
+}
+
+void HPEDocument::recordChange(int fromBlock, int toBlock)
+{
+    if(m_pendingResync)
+        return;
+
+    //the blocks after the changed ones are the same as the published ones
+    int tail = m_blockLineCounts.size() - toBlock;
+    if(m_pendingFrom < 0)
+    {
+        m_pendingFrom = fromBlock;
+        m_pendingTail = tail;
+    }
+    else
+    {
+        m_pendingFrom = qMin(m_pendingFrom, fromBlock);
+        m_pendingTail = qMin(m_pendingTail, tail);
+    }
+}
+
+QList<int> HPEDocument::splitBlocks(int startLine, int firstOldBlock, int stopLine, int lineDelta, int *lastOldBlock) const
+{
+    QList<int> lineCounts;
+    QString fence;
+    int blockStart = startLine;
+    int oldBlock = firstOldBlock;
+    int oldBlockStart = startLine;
+    for(int i = startLine; i < m_lines.size(); ++i)
+    {
+        const QString& line = m_lines.at(i);
+        if(i > blockStart && fence.isEmpty() && isBlankLine(m_lines.at(i - 1)) && !isBlankLine(line)
+                && !line.startsWith(' ') && !line.startsWith('\t'))
+        {
+            if(i >= stopLine)
+            {
+                //stop if the boundary is also an old one, the following blocks stay the same
+                int oldLine = i - lineDelta;
+                while(oldBlock < m_blockLineCounts.size() && oldBlockStart < oldLine)
+                    oldBlockStart += m_blockLineCounts.at(oldBlock++);
+                if(oldBlockStart == oldLine && oldBlock < m_blockLineCounts.size())
+                {
+                    lineCounts.append(i - blockStart);
+                    *lastOldBlock = oldBlock;
+                    return lineCounts;
+                }
+            }
+            lineCounts.append(i - blockStart);
+            blockStart = i;
+        }
+        updateFence(line, fence);
+    }
+    lineCounts.append(m_lines.size() - blockStart);
+    *lastOldBlock = m_blockLineCounts.size();
+    return lineCounts;
+}
+
+void HPEDocument::updateBlockStarts(int fromBlock)
+{
+    m_blockStarts.resize(m_blockLineCounts.size());
+    int line = fromBlock > 0 ? m_blockStarts.at(fromBlock - 1) + m_blockLineCounts.at(fromBlock - 1) : 0;
+    for(int i = qMax(fromBlock, 0); i < m_blockLineCounts.size(); ++i)
+    {
+        m_blockStarts[i] = line;
+        line += m_blockLineCounts.at(i);
+    }
+}
+
+int HPEDocument::firstLineOfBlock(int block) const
+{
+    if(block <= 0)
+        return 0;
+    return block < m_blockStarts.size() ? m_blockStarts.at(block) : int(m_lines.size());
+}
+
+int HPEDocument::blockOfLine(int line) const
+{
+    //the last block starting at or before line
+    auto it = std::upper_bound(m_blockStarts.cbegin(), m_blockStarts.cend(), line);
+    return qMax(int(it - m_blockStarts.cbegin()) - 1, 0);
+}
+
+QMap<QString, QString> HPEDocument::collectLinkDefinitions() const
+{
+    QMap<QString, QString> definitions;
+    QString fence;
+    for(const QString& line : m_lines)
+    {
+        QString label;
+        if(fence.isEmpty() && HPEMarkdownRenderer::linkDefinition(line, &label))
+        {
+            //the first definition of a label wins
+            QString key = HPEMarkdownRenderer::normalizedLabel(label);
+            if(!definitions.contains(key))
+                definitions.insert(key, line.trimmed());
+        }
+        updateFence(line, fence);
+    }
+    return definitions;
+}
+
+bool HPEDocument::containsLinkDefinition(const QStringList &lines)
+{
+    for(const QString& line : lines)
+        if(HPEMarkdownRenderer::linkDefinition(line))
+            return true;
+    return false;
+}
+
+QStringList HPEDocument::blockTexts(int firstLine, const QList<int> &lineCounts) const
+{
+    QStringList texts;
+    texts.reserve(lineCounts.size());
+    int line = firstLine;
+    for(int lineCount : lineCounts)
+    {
+        QString text = m_lines.mid(line, lineCount).join('\n');
+        line += lineCount;
+
+        QStringList definitions;
+        if(!m_linkDefinitions.isEmpty() && text.contains(']'))
+            for(auto it = m_linkDefinitions.cbegin(); it != m_linkDefinitions.cend(); ++it)
+                if(text.contains(it.key(), Qt::CaseInsensitive) && !text.contains(it.value()))
+                    definitions.append(it.value());
+        if(!definitions.isEmpty())
+        {
+            //not if the block ends in an unclosed fence, they would become codes
+            QString fence;
+            for(int i = line - lineCount; i < line; ++i)
+                updateFence(m_lines.at(i), fence);
+            if(fence.isEmpty())
+                text += "\n\n" + definitions.join('\n');
+        }
+        texts.append(text);
+    }
+    return texts;
+}
+
+QString HPEDocument::storePayload(int version, const QByteArray &data, const QByteArray &contentType)
+{
+    m_payloads.insert(version, { data, contentType });
+    while(m_payloads.size() > MAX_PAYLOADS)
+        m_payloads.erase(m_payloads.begin());
+    return HPEDocumentSchemeHandler::urlOfVersion(version);
+}
+
+bool HPEDocument::isPayload(qsizetype size) const
+{
+    return PAYLOADS_ENABLED && !m_pendingInline && size > PAYLOAD_THRESHOLD;
+}
+
+void HPEDocument::emitPatch(int fromBlock, int toBlock, const QStringList &replacementText, bool resync)
+{
+    QVariantMap patch;
+    patch["fromBlock"] = fromBlock;
+    patch["toBlock"] = toBlock;
+    patch["replacementText"] = replacementText;
+    patch["version"] = m_version;
+    patch["baseVersion"] = m_publishedVersion;
+    patch["resync"] = resync;
+
+    QVariantList hasMath;
+    hasMath.reserve(replacementText.size());
+    for(const QString& text : replacementText)
+        hasMath.append(containsMath(text));
+    patch["hasMath"] = hasMath;
+
+    //progressive rendering: only the new blocks around the focus are rendered at once,
+    //the page fills in the others when idle
+    int focusBlock = blockOfLine(m_focusLine);
+    int eagerFrom = fromBlock;
+    int eagerTo   = fromBlock + replacementText.size();
+    if(replacementText.size() > PROGRESSIVE_THRESHOLD)
+    {
+        eagerFrom = qBound(fromBlock, focusBlock - EAGER_BLOCKS_BEFORE, eagerTo);
+        eagerTo   = qBound(eagerFrom, focusBlock + EAGER_BLOCKS_AFTER, eagerTo);
+    }
+    patch["focusBlock"] = focusBlock;
+    patch["eagerFrom"] = eagerFrom;
+    patch["eagerTo"] = eagerTo;
+
+    if(m_htmlRenderer)
+    {
+        QVariantList replacementHtml;
+        replacementHtml.reserve(replacementText.size());
+        for(int i = 0; i < replacementText.size(); ++i)
+        {
+            int block = fromBlock + i;
+            if(block >= eagerFrom && block < eagerTo)
+                replacementHtml.append(m_htmlCache.html(replacementText.at(i), m_renderContext, m_htmlRenderer));
+            else
+                replacementHtml.append(QVariant());     //rendered later by renderHtml()
+        }
+        patch["replacementHtml"] = replacementHtml;
+    }
+
+    qsizetype patchSize = 0;
+    for(const QString& text : replacementText)
+        patchSize += text.size();
+    if(isPayload(patchSize))
+    {
+        //the page fetches the patch, only its URL goes through QWebChannel
+        QByteArray data = QJsonDocument(QJsonObject::fromVariantMap(patch)).toJson(QJsonDocument::Compact);
+        QVariantMap notification;
+        notification["version"] = m_version;
+        notification["url"] = storePayload(m_version, data, "application/json");
+        emit textPatched(notification);
+        return;
+    }
+    emit textPatched(patch);
+}
+
+bool HPEDocument::containsMath(const QString &text)
+{
+    //$...$, $$...$$, \(...\) or \[...\], see mathOptions in index.html
+    return text.contains('$') || text.contains(QLatin1String("\\(")) || text.contains(QLatin1String("\\["));
+}
+
+bool HPEDocument::isBlankLine(const QString &line)
+{
+    for(const QChar& c : line)
+        if(!c.isSpace())
+            return false;
+    return true;
+}
+
+void HPEDocument::updateFence(const QString &line, QString &fence)
+{
+    QString trimmed = line.trimmed();
+    if(fence.isEmpty())
+    {
+        if(trimmed.startsWith("```") || trimmed.startsWith("~~~"))
+        {
+            int length = 3;
+            while(length < trimmed.size() && trimmed.at(length) == trimmed.at(0))
+                ++length;
+            fence = trimmed.left(length);
+        }
+        else if(trimmed == "$$" || (trimmed.startsWith("$$") && !trimmed.endsWith("$$")))
+            fence = "$$";
+    }
+    else if(fence == "$$")
+    {
+        if(trimmed.endsWith("$$"))
+            fence.clear();
+    }
+    else if(trimmed.size() >= fence.size() && trimmed.count(fence.at(0)) == trimmed.size())
+        fence.clear();
+}
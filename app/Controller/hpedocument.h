@@ -14,6 +14,14 @@
 #define HPEDOCUMENT_H
 
 #include <QObject>
+#include <QMap>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <functional>
+
+#include "hpehtmlcache.h"
 
 /**
  * @class HPEDocument
@@ -26,19 +34,94 @@
  * Visit {https://doc.qt.io/qt-6/qtwebengine-webenginewidgets-markdowneditor-example.html}{Qt WebEngine Markdown Editor Example}
  * for more information.
  * 
+ * @par Delta updates
+ * 
+ * HPEDocument splits the converted Markdown into preview blocks.
+ * A preview block is a run of lines which can be rendered independently,
+ * that is, a new block starts at a non-indented line following a blank line
+ * (except in fenced codes and math blocks).
+ * 
+ * Instead of sending the whole text, applyChange() re-splits only the lines around the change
+ * and emits textPatched() with a patch as following:
+ * @code
+ *      {
+ *          fromBlock: 3,               // the first replaced block
+ *          toBlock: 4,                 // the block after the last replaced block
+ *          replacementText: [ "..." ], // the Markdown of each new block
+ *          version: 42,
+ *          baseVersion: 40,            // the version the patch applies to
+ *          hasMath: [ false ],         // whether each new block may contain math for KaTeX
+ *          focusBlock: 3,              // the block at the top of the editor
+ *          eagerFrom: 3,               // the new blocks [eagerFrom, eagerTo) should be rendered at once
+ *          eagerTo: 4,
+ *          resync: false               // true if the patch replaces all blocks
+ *      }
+ * @endcode
+ * The web page keeps one DOM element per preview block so that only the changed blocks
+ * get parsed and rendered again.
+ * 
+ * As blocks are parsed on their own, the link reference definitions ([label]: url) are collected
+ * from the whole text, and the definitions a block refers to are appended to its Markdown.
+ * Changing a definition replaces all blocks. If the page misses a version, it calls requestResync()
+ * to get a patch replacing all blocks.
+ * 
+ * If "preview/deltaUpdates" is disabled in HPESettings, HPEDocument falls back to
+ * emitting textChanged() with the whole text.
+ * 
+ * @par Large payloads
+ * 
+ * A patch or a text larger than PAYLOAD_THRESHOLD characters isn't pushed through QWebChannel.
+ * It is stored as a UTF-8 payload, and only its URL is sent (as { version, url } by textPatched(),
+ * or by textStored()). The web page fetches it from HPEDocumentSchemeHandler.
+ * If the fetch fails, the page calls requestInlineResync(), whose patch goes through QWebChannel
+ * whatever its size, so a payload that can't be fetched isn't stored again and again.
+ * Before Qt 6.6 the page can't fetch from a custom scheme, and everything goes through QWebChannel.
+ * 
+ * @par Publishing
+ * 
+ * By default, every change is sent to the web page at once. If auto publishing is disabled
+ * (HPEPreviewScheduler does this, and it also coalesces the edits before they reach the document),
+ * changes are only recorded and pendingChanged() is emitted,
+ * and the next publish() merges all of them into one patch. A patch carries 'baseVersion',
+ * the version of the last published patch, so the page can tell whether it misses one.
+ * After rendering, the page calls acknowledge() with the version it shows.
+ * 
+ * @par Native rendering
+ * 
+ * If an HTML renderer is set by setHtmlRenderer(), every patch also carries
+ * 'replacementHtml', the HTML of each new block, and the web page uses it
+ * instead of parsing Markdown by marked.js. The HTML of blocks is memoised in an HPEHtmlCache,
+ * whose context is set by setRenderContext().
+ * 
+ * @par Progressive rendering
+ * 
+ * When a patch carries many blocks (for example, a resync of a long post), only the blocks
+ * around the focus (the block at the top of the editor, see setFocusLine()) are rendered at once.
+ * The page shows them first and fills in the others in idle time, asking renderHtml()
+ * for their HTML in native rendering.
+ * 
+ * @see HPEMarkdownRenderer
+ * 
  * @note The corresponding web page is app/resources/index.html
+ * 
+ * @par Scroll synchronization
+ * 
+ * Preview blocks and the elements on the page share their indices, so they are the source map
+ * of the preview: scrollToLine() maps a line of the converted text to a block
+ * and a line in it, and emits scrollRequested() at most once a frame.
+ * Inside a block, the page scrolls between the line anchors (data-line) of its elements,
+ * which HPEMarkdownRenderer records in native rendering, and proportionally without them.
 */
 class HPEDocument : public QObject
 {
     Q_OBJECT
-    Q_PROPERTY(QString text MEMBER m_text NOTIFY textChanged FINAL)
 
 public:
 
     /**
      * @brief Construct an HPEDocument object with parent
      * 
-     * @param[in] parent 
+     * @param[in] parent
     */
     explicit HPEDocument(QObject *parent = nullptr);
 
@@ -47,6 +130,8 @@ public:
      * As the HPEDocument object always serves as a QObject for QWebChannel,
      * the signal will be captured by QWebChannel, and sent to web page for further process.
      * 
+     * In delta mode, a patch replacing all blocks will be emitted by textPatched() instead.
+     * 
      * Visit {https://doc.qt.io/qt-6/qtwebengine-webenginewidgets-markdowneditor-example.html}{Qt WebEngine Markdown Editor Example}
      * for more information.
      * 
@@ -56,6 +141,245 @@ public:
     */
     void setText(const QString &text);
 
+    /**
+     * @brief Replace the lines [from, to) with lines and emit textPatched()
+     * for the preview blocks involved.
+     * 
+     * @param[in] from The first replaced line
+     * @param[in] to The line after the last replaced line
+     * @param[in] lines New lines
+    */
+    void applyChange(int from, int to, const QStringList& lines);
+
+    /**
+     * @brief Send the changes since the last publishing to the web page.
+     * Do nothing if there are no changes.
+     * 
+    */
+    void publish();
+
+    /**
+     * @brief Returns whether there are changes not published yet
+     * 
+    */
+    bool hasPendingChanges() const;
+
+    /**
+     * @brief If autoPublish is true (by default), publish() is called after every change
+     * 
+     * @param[in] autoPublish 
+    */
+    void setAutoPublish(bool autoPublish);
+
+    /**
+     * @brief Returns the version sent to the web page last time
+     * 
+    */
+    int publishedVersion() const;
+
+    /**
+     * @brief Set the function used to render the Markdown of preview blocks to HTML.
+     * Pass nullptr to let the web page parse Markdown.
+     * 
+     * @param[in] renderer 
+    */
+    void setHtmlRenderer(const std::function<QString(const QString&)>& renderer);
+
+    /**
+     * @brief Set the context the HTML of blocks depends on (the path of current file),
+     * cached HTML is only reused within the same context.
+     * 
+     * @param[in] context 
+    */
+    void setRenderContext(const QString& context);
+
+    /**
+     * @brief Returns the cache of the rendered HTML, which has the hit/miss counters
+     * 
+    */
+    const HPEHtmlCache& htmlCache() const;
+
+    /**
+     * @brief Returns the whole text
+     * 
+    */
+    QString text() const;
+
+    /**
+     * @brief Returns the lines [from, to) of the text
+     * 
+    */
+    QStringList lines(int from, int to) const;
+
+    /**
+     * @brief Returns the version of the text, which increases after every change
+     * 
+    */
+    int version() const;
+
+    /**
+     * @brief Called by the web page when it misses a patch.
+     * Emit textPatched() with a patch replacing all blocks.
+     * 
+    */
+    Q_INVOKABLE void requestResync();
+
+    /**
+     * @brief Called by the web page when it can't fetch a payload.
+     * Like requestResync(), but the patch is sent through QWebChannel whatever its size.
+     * 
+    */
+    Q_INVOKABLE void requestInlineResync();
+
+    /**
+     * @brief Called by the web page to render the blocks left out of a patch
+     * 
+     * @param[in] texts The Markdown of blocks
+     * @return The HTML of each block, empty if there is no HTML renderer
+    */
+    Q_INVOKABLE QStringList renderHtml(const QStringList& texts);
+
+    /**
+     * @brief Set the line of the converted text shown at the top of the editor.
+     * Emit focusChanged() if the block containing it changes.
+     * 
+     * @param[in] line 
+    */
+    void setFocusLine(int line);
+
+    /**
+     * @brief Scroll the web page to a line of the converted text, and set the focus to it.
+     * scrollRequested() is emitted at most once a frame with the latest line.
+     * 
+     * @param[in] line 
+     * @param[in] lineOffset How much of the line is scrolled out, from 0.0 to 1.0
+    */
+    void scrollToLine(int line, double lineOffset = 0.0);
+
+    /**
+     * @brief Take the payload stored for version, a payload can be taken only once
+     * 
+     * @param[in] version
+     * @param[out] data UTF-8 data
+     * @param[out] contentType
+     * @return false if there is no payload for version
+     * @see HPEDocumentSchemeHandler
+    */
+    bool takePayload(int version, QByteArray& data, QByteArray& contentType);
+
+    /**
+     * @brief Called by the web page after it renders a version.
+     * Emit acknowledged().
+     * 
+     * @param[in] version The rendered version, -1 for the whole text in textChanged()
+     * @param[in] renderTime The time (ms) the page took to render it
+    */
+    Q_INVOKABLE void acknowledge(int version, double renderTime);
+
+private:
+
+    /**
+     * @brief Split lines from startLine into preview blocks.
+     * The splitting stops at the first block boundary which is not before stopLine
+     * and is also a boundary in the old blocks (lineDelta is the number of lines
+     * added by the change), or at the end of m_lines.
+     * 
+     * @param[in] startLine Should be the first line of a preview block
+     * @param[in] firstOldBlock The old block starting at startLine
+     * @param[in] stopLine
+     * @param[in] lineDelta
+     * @param[out] lastOldBlock The block after the last old block replaced
+     * @return The line counts of new blocks
+    */
+    QList<int> splitBlocks(int startLine, int firstOldBlock, int stopLine, int lineDelta, int* lastOldBlock) const;
+
+    /**
+     * @brief Returns the first line of block
+     * 
+    */
+    int firstLineOfBlock(int block) const;
+
+    /**
+     * @brief Returns the block containing line
+     * 
+    */
+    int blockOfLine(int line) const;
+
+    /**
+     * @brief Recompute m_blockStarts from fromBlock after m_blockLineCounts changes
+     * 
+    */
+    void updateBlockStarts(int fromBlock);
+
+    /**
+     * @brief Returns the link reference definitions outside fences, by normalized label
+     * 
+     * @see HPEMarkdownRenderer::linkDefinition()
+    */
+    QMap<QString, QString> collectLinkDefinitions() const;
+
+    /**
+     * @brief Returns whether any of lines is a link reference definition
+     * 
+    */
+    static bool containsLinkDefinition(const QStringList& lines);
+
+    /**
+     * @brief Returns the Markdown texts of blocks [from, from + lineCounts.size())
+     * whose first line is firstLine, followed by the link reference definitions they refer to
+     * 
+    */
+    QStringList blockTexts(int firstLine, const QList<int>& lineCounts) const;
+
+    /**
+     * @brief Merge the replaced blocks [fromBlock, toBlock) into the pending changes.
+     * Should be called before m_blockLineCounts is updated.
+     * 
+    */
+    void recordChange(int fromBlock, int toBlock);
+
+    /**
+     * @brief Store a payload for version, and drop the oldest ones
+     * if there are more than MAX_PAYLOADS
+     * 
+     * @return The URL of the payload
+    */
+    QString storePayload(int version, const QByteArray& data, const QByteArray& contentType);
+
+    /**
+     * @brief Returns whether an update of size characters is sent as a payload
+     * 
+    */
+    bool isPayload(qsizetype size) const;
+
+    /**
+     * @brief Emit textPatched() with the replaced blocks
+     * 
+    */
+    void emitPatch(int fromBlock, int toBlock, const QStringList& replacementText, bool resync = false);
+
+    /**
+     * @brief Returns whether text may contain math delimiters.
+     * The web page runs KaTeX only on the blocks containing math.
+     * 
+    */
+    static bool containsMath(const QString& text);
+
+    /**
+     * @brief Returns whether line is a blank line
+     * 
+    */
+    static bool isBlankLine(const QString& line);
+
+    /**
+     * @brief Update the fence marker (``` , ~~~ or $$) with line.
+     * The fence is empty if line is outside fenced codes and math blocks.
+     * 
+     * @param[in] line
+     * @param[in, out] fence
+    */
+    static void updateFence(const QString& line, QString& fence);
+
 signals:
 /**
  * @defgroup signals
@@ -72,20 +396,196 @@ signals:
      * @see QWebChannel
     */
     void textChanged(const QString &text);
+
+    /**
+     * @brief This signal is emitted instead of textChanged() when the text is too large,
+     * the text is fetched from url.
+     * 
+     * @see takePayload()
+    */
+    void textStored(const QString &url);
+
+    /**
+     * @brief This signal is emitted in delta mode when the text changes,
+     * transferring a patch of preview blocks.
+     * 
+     * @see applyChange()
+    */
+    void textPatched(const QVariantMap &patch);
+
+    /**
+     * @brief This signal is emitted after the text changes without being published
+     * 
+     * @see setAutoPublish()
+    */
+    void pendingChanged();
+
+    /**
+     * @brief This signal is emitted when the web page acknowledges a rendered version
+     * 
+     * @see acknowledge()
+    */
+    void acknowledged(int version, double renderTime);
+
+    /**
+     * @brief This signal is emitted when the block at the top of the editor changes
+     * 
+     * @see setFocusLine()
+    */
+    void focusChanged(int block);
+
+    /**
+     * @brief This signal is emitted when the web page should scroll
+     * 
+     * @param[in] block The preview block at the top
+     * @param[in] blockLine The line in the block at the top, with the fraction scrolled out
+     * @param[in] blockLineCount The number of lines of the block
+     * @param[in] documentOffset The same position in the whole text, from 0.0 to 1.0, used without preview blocks
+     * @see scrollToLine()
+    */
+    void scrollRequested(int block, double blockLine, int blockLineCount, double documentOffset);
 /**
  * @}
 */
 private:
 
     /**
-     * @brief This property is exposed as 'text' by using Q_PROPERTY.
-     * This property will be set by setText().
+     * @brief Stores the lines of the text
      * 
-     * Visit {https://doc.qt.io/qt-6/qtwebengine-webenginewidgets-markdowneditor-example.html}{Qt WebEngine Markdown Editor Example}
-     * for more information.
+    */
+    QStringList m_lines;
+
+    /**
+     * @brief Stores the line count of each preview block
+     * 
+    */
+    QList<int> m_blockLineCounts;
+
+    /**
+     * @brief Stores the first line of each preview block, the prefix sums of m_blockLineCounts
+     * 
+    */
+    QList<int> m_blockStarts;
+
+    /**
+     * @brief The link reference definition lines of the text, by normalized label
+     * 
+    */
+    QMap<QString, QString> m_linkDefinitions;
+
+    /**
+     * @brief The version of the text
+     * 
+    */
+    int m_version = 0;
+
+    /**
+     * @brief If patches are sent instead of the whole text
+     * 
+    */
+    bool m_deltaMode = true;
+
+    /**
+     * @brief If publish() is called after every change
+     * 
+    */
+    bool m_autoPublish = true;
+
+    /**
+     * @brief The version and the block count sent to the web page last time
+     * 
+    */
+    int m_publishedVersion = 0;
+    int m_publishedBlockCount = 0;
+
+    /**
+     * @brief The pending changes: the blocks from m_pendingFrom
+     * to the last m_pendingTail blocks (excluded) have changed since the last publishing.
+     * m_pendingFrom is -1 if there are no changes.
+     * If m_pendingResync is true, all blocks will be replaced.
+     * 
+    */
+    int  m_pendingFrom = -1;
+    int  m_pendingTail = 0;
+    bool m_pendingResync = false;
+
+    /**
+     * @brief Whether the next publishing goes through QWebChannel whatever its size
+     * 
+     * @see requestInlineResync()
+    */
+    bool m_pendingInline = false;
+
+    /**
+     * @brief Renders Markdown of preview blocks to HTML, can be empty
+     * 
+     * @see setHtmlRenderer()
+    */
+    std::function<QString(const QString&)> m_htmlRenderer;
+
+    /**
+     * @brief Memoises the HTML rendered by m_htmlRenderer
+     * 
+    */
+    HPEHtmlCache m_htmlCache;
+    size_t m_renderContext = 0;
+
+    /**
+     * @brief The line and the block at the top of the editor
+     * 
+     * @see setFocusLine()
+    */
+    int m_focusLine = 0;
+    int m_focusBlock = 0;
+
+    struct Payload
+    {
+        QByteArray data;
+        QByteArray contentType;
+    };
+
+    /**
+     * @brief The payloads not fetched yet, by version
+     * 
+     * @see takePayload()
+    */
+    QMap<int, Payload> m_payloads;
+
+    /**
+     * @brief The latest position passed to scrollToLine(), sent when m_scrollTimer times out
+     * 
+    */
+    int    m_scrollLine = 0;
+    double m_scrollLineOffset = 0.0;
+    QTimer m_scrollTimer;
+
+    /**
+     * @brief A patch with more blocks than it is rendered progressively,
+     * the blocks [focus - EAGER_BLOCKS_BEFORE, focus + EAGER_BLOCKS_AFTER) are rendered at once
+     * 
+    */
+    static constexpr int PROGRESSIVE_THRESHOLD = 64;
+    static constexpr int EAGER_BLOCKS_BEFORE   = 8;
+    static constexpr int EAGER_BLOCKS_AFTER    = 32;
+
+    /**
+     * @brief The interval of scrollRequested(), about a frame
+     * 
+    */
+    static constexpr int SCROLL_INTERVAL = 16;
+
+    /**
+     * @brief Texts and patches larger than it (in characters) are sent as payloads
+     * 
+    */
+    static constexpr int PAYLOAD_THRESHOLD = 4096;
+    static constexpr int MAX_PAYLOADS      = 8;
+
+    /**
+     * @brief Whether the web page can fetch payloads, which needs QWebEngineUrlScheme::FetchApiAllowed
      * 
     */
-    QString m_text;
+    static constexpr bool PAYLOADS_ENABLED = QT_VERSION >= QT_VERSION_CHECK(6, 6, 0);
 };
 
 #endif // HPEDOCUMENT_H
@@ -0,0 +1,65 @@
+/**
+ * @file hpedocumentschemehandler.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-24
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpedocumentschemehandler.h"
+
+#include <QBuffer>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+
+#include "hpedocument.h"
+
+const QByteArray HPEDocumentSchemeHandler::SCHEME = "hpe";
+
+HPEDocumentSchemeHandler::HPEDocumentSchemeHandler(HPEDocument *document, QObject *parent)
+    : QWebEngineUrlSchemeHandler{parent}, m_document(document) { }
+
+void HPEDocumentSchemeHandler::registerUrlScheme()
+{
+    QWebEngineUrlScheme scheme(SCHEME);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    //the page is loaded from 'file', fetching from it is cross-origin
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme
+                    | QWebEngineUrlScheme::LocalAccessAllowed | QWebEngineUrlScheme::CorsEnabled
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+                    | QWebEngineUrlScheme::FetchApiAllowed
+#endif
+                    );
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+QString HPEDocumentSchemeHandler::urlOfVersion(int version)
+{
+    return QString("%1://doc/%2").arg(QString::fromLatin1(SCHEME)).arg(version);
+}
+
+void HPEDocumentSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    bool isVersion = false;
+    int version = url.path().mid(1).toInt(&isVersion);
+
+    QByteArray data, contentType;
+    if(url.host() != "doc" || !isVersion || !m_document->takePayload(version, data, contentType))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    //the page's origin is 'file', which is opaque
+    job->setAdditionalResponseHeaders({ { "Access-Control-Allow-Origin", "*" } });
+#endif
+    QBuffer* buffer = new QBuffer(job);
+    buffer->setData(data);
+    job->reply(contentType, buffer);
+}
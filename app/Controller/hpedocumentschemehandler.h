@@ -0,0 +1,83 @@
+/**
+ * @file hpedocumentschemehandler.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-24
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEDOCUMENTSCHEMEHANDLER_H
+#define HPEDOCUMENTSCHEMEHANDLER_H
+
+#include <QWebEngineUrlSchemeHandler>
+
+class HPEDocument;
+
+/**
+ * @class HPEDocumentSchemeHandler
+ * @brief An HPEDocumentSchemeHandler serves the payloads of HPEDocument to the web page
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * Large updates of the preview are not pushed through QWebChannel, which encodes,
+ * escapes and copies them as JSON on both sides. HPEDocument stores them as UTF-8 payloads
+ * and only sends their URLs, which the web page fetches:
+ * @code
+ *      hpe://doc/<version>
+ * @endcode
+ * 
+ * A payload can be fetched only once. Unknown versions fail with UrlNotFound,
+ * and the web page asks for a resync sent over QWebChannel (HPEDocument::requestInlineResync()).
+ * 
+ * The page is loaded from 'file', so the fetch is cross-origin: the replies allow any origin.
+ * The Fetch API can load a custom scheme only since Qt 6.6 (QWebEngineUrlScheme::FetchApiAllowed),
+ * HPEDocument doesn't store payloads before it.
+ * 
+ * @attention registerUrlScheme() must be called before QApplication is constructed.
+ * 
+ * @see HPEDocument::takePayload()
+*/
+class HPEDocumentSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct an HPEDocumentSchemeHandler serving the payloads of document
+     * 
+     * @param[in] document 
+     * @param[in] parent 
+    */
+    explicit HPEDocumentSchemeHandler(HPEDocument* document, QObject *parent = nullptr);
+
+    /**
+     * @brief Register the 'hpe' scheme
+     * 
+     * @see QWebEngineUrlScheme::registerScheme()
+    */
+    static void registerUrlScheme();
+
+    /**
+     * @brief Returns the URL of the payload of version
+     * 
+    */
+    static QString urlOfVersion(int version);
+
+    void requestStarted(QWebEngineUrlRequestJob* job) override;
+
+    /**
+     * @brief The name of the scheme
+     * 
+    */
+    static const QByteArray SCHEME;
+
+private:
+    HPEDocument* m_document;
+};
+
+#endif // HPEDOCUMENTSCHEMEHANDLER_H
@@ -0,0 +1,195 @@
+/**
+ * @file hpefrontmatter.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-20
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpefrontmatter.h"
+
+#include <QFile>
+#include <QTextStream>
+
+/**
+ * @brief Returns value as a list, a single string becomes a list with one item
+ * 
+*/
+static QStringList toList(const QVariant& value)
+{
+    if(value.typeId() == QMetaType::QStringList)
+        return value.toStringList();
+    QString string = value.toString();
+    return string.isEmpty() ? QStringList() : QStringList({ string });
+}
+
+HPEFrontMatter::HPEFrontMatter()
+{
+    m_range.setRange(-1, -1);
+}
+
+bool HPEFrontMatter::parse(const LineReader &lineAt, int lineCount)
+{
+    HPEFrontMatter previous = *this;
+
+    m_opened = lineCount > 0 && lineAt(0) == "---";
+    m_range.setRange(-1, -1);
+    m_values.clear();
+    if(m_opened)
+    {
+        for(int i = 1; i < lineCount; ++i)
+            if(lineAt(i) == "---")
+            {
+                m_range.setRange(0, i);
+                parseValues(lineAt, 0, i);
+                break;
+            }
+    }
+
+    m_title      = m_values.value("title").toString();
+    m_date       = m_values.value("date").toString();
+    m_tags       = toList(m_values.value("tags"));
+    m_categories = toList(m_values.value("categories"));
+    return *this != previous;
+}
+
+bool HPEFrontMatter::parse(const QStringList &lines)
+{
+    return parse([&lines](int i){ return lines.at(i); }, lines.size());
+}
+
+bool HPEFrontMatter::isTouchedBy(int firstLine, const QStringList &newLines) const
+{
+    if(isValid())
+        return firstLine <= m_range.getTo();
+    //the first line may become '---', or Front-Matter may get closed
+    return firstLine == 0 || (m_opened && newLines.contains("---"));
+}
+
+HPEFrontMatter HPEFrontMatter::fromFile(const QString &filePath)
+{
+    HPEFrontMatter frontMatter;
+    QFile file(filePath);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return frontMatter;
+
+    QTextStream stream(&file);
+    QStringList lines;
+    QString line;
+    while(stream.readLineInto(&line))
+    {
+        lines.append(line);
+        if(lines.size() == 1 ? line != "---" : line == "---")
+            break;
+    }
+    frontMatter.parse(lines);
+    return frontMatter;
+}
+
+bool HPEFrontMatter::isValid() const
+{
+    return m_range.getFrom() >= 0;
+}
+
+const BlockRange &HPEFrontMatter::range() const
+{
+    return m_range;
+}
+
+int HPEFrontMatter::bodyStart() const
+{
+    return m_range.getTo() + 1;
+}
+
+QString HPEFrontMatter::title() const
+{
+    return m_title;
+}
+
+QString HPEFrontMatter::date() const
+{
+    return m_date;
+}
+
+QStringList HPEFrontMatter::tags() const
+{
+    return m_tags;
+}
+
+QStringList HPEFrontMatter::categories() const
+{
+    return m_categories;
+}
+
+QVariant HPEFrontMatter::value(const QString &key) const
+{
+    return m_values.value(key);
+}
+
+const QVariantMap &HPEFrontMatter::values() const
+{
+    return m_values;
+}
+
+bool HPEFrontMatter::operator==(const HPEFrontMatter &other) const
+{
+    return m_opened == other.m_opened && m_range == other.m_range && m_values == other.m_values;
+}
+
+void HPEFrontMatter::parseValues(const LineReader &lineAt, int from, int to)
+{
+    //the key of the block sequence being parsed
+    QString listKey;
+    for(int i = from + 1; i < to; ++i)
+    {
+        QString trimmed = lineAt(i).trimmed();
+        if(trimmed.isEmpty() || trimmed.startsWith('#'))
+            continue;
+
+        if(trimmed == "-" || trimmed.startsWith("- "))
+        {
+            if(!listKey.isEmpty())
+            {
+                QStringList list = m_values.value(listKey).toStringList();
+                list.append(unquote(trimmed.mid(1).trimmed()));
+                m_values[listKey] = list;
+            }
+            continue;
+        }
+
+        listKey.clear();
+        int colon = trimmed.indexOf(':');
+        if(colon <= 0)
+            continue;
+        QString key   = trimmed.left(colon).trimmed();
+        QString value = trimmed.mid(colon + 1).trimmed();
+        if(value.isEmpty() || value.startsWith('#'))
+        {
+            listKey = key;
+            m_values[key] = QStringList();
+        }
+        else if(value.startsWith('[') && value.endsWith(']'))
+        {
+            QStringList list;
+            for(const QString& item : value.mid(1, value.size() - 2).split(','))
+                if(!item.trimmed().isEmpty())
+                    list.append(unquote(item.trimmed()));
+            m_values[key] = list;
+        }
+        else
+            m_values[key] = unquote(value);
+    }
+}
+
+QString HPEFrontMatter::unquote(const QString &value)
+{
+    if(value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front())
+        return value.mid(1, value.size() - 2);
+
+    int comment = value.indexOf(" #");
+    return comment < 0 ? value : value.left(comment).trimmed();
+}
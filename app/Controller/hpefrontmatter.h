@@ -0,0 +1,187 @@
+/**
+ * @file hpefrontmatter.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-20
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEFRONTMATTER_H
+#define HPEFRONTMATTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include <functional>
+
+struct BlockRange
+{
+private:
+    int from = 0;
+    int to = 0;
+public:
+    void setRange(int from, int to)
+    {
+        if(from > to) return;
+        this->from = from;
+        this->to = to;
+    }
+
+    bool contains(int number) const { return number >= from && number <= to; }
+    int getFrom() const { return from; }
+    int getTo()   const { return to; }
+    int length()  const { return to - from; }
+
+    bool operator==(const BlockRange& other) const { return from == other.from && to == other.to; }
+    bool operator!=(const BlockRange& other) const { return !(*this == other); }
+};
+
+
+/**
+ * @class HPEFrontMatter
+ * @brief An HPEFrontMatter holds the parsed Front-Matter of a Hexo post
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * Front-Matter is the YAML block between the '---' on the first line and the next '---'.
+ * HPEFrontMatter keeps its block range and the parsed keys, so the readers
+ * (the preview, the file selector, ...) get title, date, tags and categories in O(1).
+ * 
+ * @par Keeping in sync
+ * 
+ * The owner calls isTouchedBy() with every edit, and calls parse() only if it returns true,
+ * that is, when the edit may change Front-Matter. Parsing reads only the lines of Front-Matter.
+ * 
+ * @par Supported YAML
+ * 
+ * @code
+ *      title: "Hello World"    # scalars, quotes are removed
+ *      tags: [Qt, C++]         # flow sequences
+ *      categories:             # block sequences
+ *        - Diary
+ * @endcode
+ * 
+ * @note Visit https://hexo.io/docs/front-matter for more info
+*/
+class HPEFrontMatter
+{
+public:
+
+    /**
+     * @brief A function returning the text of a line by its number
+     * 
+    */
+    typedef std::function<QString(int)> LineReader;
+
+    /**
+     * @brief Construct an empty (invalid) HPEFrontMatter
+     * 
+    */
+    HPEFrontMatter();
+
+    /**
+     * @brief Parse Front-Matter from the first lines of a document
+     * 
+     * @param[in] lineAt Reads a line of the document
+     * @param[in] lineCount The number of lines in the document
+     * @return true if anything changed
+    */
+    bool parse(const LineReader& lineAt, int lineCount);
+
+    /**
+     * @brief Parse Front-Matter from lines
+     * 
+     * @return true if anything changed
+    */
+    bool parse(const QStringList& lines);
+
+    /**
+     * @brief Returns whether an edit replacing lines from firstLine with newLines
+     * may change Front-Matter, and parse() is needed.
+     * 
+     * @param[in] firstLine The first line changed by the edit
+     * @param[in] newLines The lines after the edit, starting from firstLine
+    */
+    bool isTouchedBy(int firstLine, const QStringList& newLines) const;
+
+    /**
+     * @brief Read Front-Matter of the file at filePath, the rest of the file is not read
+     * 
+    */
+    static HPEFrontMatter fromFile(const QString& filePath);
+
+    /**
+     * @brief Returns whether Front-Matter exists and is closed
+     * 
+    */
+    bool isValid() const;
+
+    /**
+     * @brief Returns the lines of Front-Matter, both '---' included.
+     * (-1, -1) if it is invalid.
+     * 
+    */
+    const BlockRange& range() const;
+
+    /**
+     * @brief Returns the first line after Front-Matter, 0 if it is invalid
+     * 
+    */
+    int bodyStart() const;
+
+    QString title() const;
+    QString date() const;
+    QStringList tags() const;
+    QStringList categories() const;
+
+    /**
+     * @brief Returns the value of key, a QString or a QStringList
+     * 
+    */
+    QVariant value(const QString& key) const;
+
+    /**
+     * @brief Returns all the parsed values
+     * 
+    */
+    const QVariantMap& values() const;
+
+    bool operator==(const HPEFrontMatter& other) const;
+    bool operator!=(const HPEFrontMatter& other) const { return !(*this == other); }
+
+private:
+
+    /**
+     * @brief Parse the YAML lines between from and to (both excluded)
+     * 
+    */
+    void parseValues(const LineReader& lineAt, int from, int to);
+
+    /**
+     * @brief Remove the quotes around value and the trailing comment
+     * 
+    */
+    static QString unquote(const QString& value);
+
+    /**
+     * @brief Whether the first line is '---'
+     * 
+    */
+    bool m_opened = false;
+
+    BlockRange m_range;
+    QVariantMap m_values;
+
+    QString m_title;
+    QString m_date;
+    QStringList m_tags;
+    QStringList m_categories;
+};
+
+#endif // HPEFRONTMATTER_H
@@ -0,0 +1,66 @@
+/**
+ * @file hpehtmlcache.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-22
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpehtmlcache.h"
+
+#include <QHash>
+
+HPEHtmlCache::HPEHtmlCache(qsizetype maxCost)
+    : m_entries(maxCost) { }
+
+QString HPEHtmlCache::html(const QString &source, size_t context, const std::function<QString (const QString &)> &render)
+{
+    size_t key = qHash(source, context);
+    Entry* entry = m_entries.object(key);
+    if(entry && entry->context == context && entry->source == source)
+    {
+        ++m_hits;
+        return entry->html;
+    }
+
+    ++m_misses;
+    QString html = render(source);
+    m_entries.insert(key, new Entry{ source, context, html }, source.size() + html.size());
+    return html;
+}
+
+void HPEHtmlCache::clear()
+{
+    m_entries.clear();
+}
+
+void HPEHtmlCache::resetCounters()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+qint64 HPEHtmlCache::hits() const
+{
+    return m_hits;
+}
+
+qint64 HPEHtmlCache::misses() const
+{
+    return m_misses;
+}
+
+double HPEHtmlCache::hitRate() const
+{
+    qint64 lookups = m_hits + m_misses;
+    return lookups == 0 ? 0 : double(m_hits) / lookups;
+}
+
+qsizetype HPEHtmlCache::size() const
+{
+    return m_entries.size();
+}
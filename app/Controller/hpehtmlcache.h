@@ -0,0 +1,107 @@
+/**
+ * @file hpehtmlcache.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-22
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEHTMLCACHE_H
+#define HPEHTMLCACHE_H
+
+#include <QCache>
+#include <QString>
+
+#include <functional>
+
+/**
+ * @class HPEHtmlCache
+ * @brief A cache of the rendered HTML of preview blocks
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPEHtmlCache memoises the HTML rendered from the Markdown of a preview block,
+ * so that the unchanged blocks are not rendered again when they are sent to the web page
+ * (for example, when all blocks are resent after the title changes).
+ * 
+ * An entry is keyed by the hash of the block's source and its rendering context.
+ * The context covers everything else the HTML depends on, that is, the directory
+ * images are resolved against (HPEDocument passes the hash of the file path).
+ * Nothing about the blocks around is needed: a preview block never starts inside a fence,
+ * and the link reference definitions it refers to are part of its source.
+ * The source is stored as well, so a hash collision never returns wrong HTML.
+ * 
+ * Entries are evicted in LRU order once the total size (in characters) exceeds the max cost.
+ * hits() and misses() tell how effective the cache is.
+ * 
+ * @see HPEDocument::setHtmlRenderer()
+*/
+class HPEHtmlCache
+{
+public:
+
+    /**
+     * @brief Construct an HPEHtmlCache holding about maxCost characters
+     * 
+     * @param[in] maxCost 
+    */
+    explicit HPEHtmlCache(qsizetype maxCost = 8 * 1024 * 1024);
+
+    /**
+     * @brief Returns the HTML of source in context from the cache,
+     * or renders it by render() and caches it.
+     * 
+     * @param[in] source The Markdown of a block
+     * @param[in] context The hash of the rendering context
+     * @param[in] render Renders source to HTML on misses
+     * @return HTML
+    */
+    QString html(const QString& source, size_t context, const std::function<QString(const QString&)>& render);
+
+    /**
+     * @brief Remove all the entries, the counters are kept
+     * 
+    */
+    void clear();
+
+    /**
+     * @brief Reset hits and misses to 0
+     * 
+    */
+    void resetCounters();
+
+    qint64 hits() const;
+    qint64 misses() const;
+
+    /**
+     * @brief Returns hits / (hits + misses), 0 if nothing is looked up
+     * 
+    */
+    double hitRate() const;
+
+    /**
+     * @brief Returns the number of entries
+     * 
+    */
+    qsizetype size() const;
+
+private:
+
+    struct Entry
+    {
+        QString source;
+        size_t  context;
+        QString html;
+    };
+
+    QCache<size_t, Entry> m_entries;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+};
+
+#endif // HPEHTMLCACHE_H
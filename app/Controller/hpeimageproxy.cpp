@@ -0,0 +1,211 @@
+/**
+ * @file hpeimageproxy.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-26
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpeimageproxy.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QEvent>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMimeDatabase>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtMath>
+#include <QWebEngineUrlRequestJob>
+#include <QWebEngineUrlScheme>
+#include <QWidget>
+
+const QByteArray HPEImageProxy::SCHEME = "hpe-image";
+
+HPEImageProxy::HPEImageProxy(HPEAssetResolver *assetResolver, QObject *parent)
+    : QWebEngineUrlSchemeHandler{parent}, m_assetResolver(assetResolver)
+{
+    //64 MB of downscaled copies in memory
+    m_images.setMaxCost(64 * 1024 * 1024);
+    m_cacheDir.setPath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/images");
+    m_cacheDir.mkpath(".");
+    startPruning();
+}
+
+void HPEImageProxy::registerUrlScheme()
+{
+    QWebEngineUrlScheme scheme(SCHEME);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    //<img> doesn't need CORS, and scripts must not read local files through the scheme
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme | QWebEngineUrlScheme::LocalScheme);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+QString HPEImageProxy::urlOf(const HPEAssetResolver::Asset &asset)
+{
+    //animations and vector images are not proxied
+    static const QStringList suffixes = { "jpg", "jpeg", "png", "tif", "tiff", "bmp", "webp" };
+    if(!asset.exists || asset.size < MIN_PROXIED_SIZE
+            || !suffixes.contains(QFileInfo(asset.filePath).suffix().toLower()))
+        return asset.url;
+
+    QString url = QString("%1://image/%2").arg(QString::fromLatin1(SCHEME),
+                                               QString::fromLatin1(QUrl::toPercentEncoding(asset.filePath)));
+    return asset.revision > 0 ? url + QString("?v=%1").arg(asset.revision) : url;
+}
+
+void HPEImageProxy::watchWidth(QWidget *widget)
+{
+    widget->installEventFilter(this);
+}
+
+bool HPEImageProxy::eventFilter(QObject *watched, QEvent *event)
+{
+    if(event->type() == QEvent::Resize)
+    {
+        QWidget* widget = static_cast<QWidget*>(watched);
+        int width = qCeil(widget->width() * widget->devicePixelRatioF() / WIDTH_STEP) * WIDTH_STEP;
+        m_width = qMax(m_width, width);
+    }
+    return QWebEngineUrlSchemeHandler::eventFilter(watched, event);
+}
+
+void HPEImageProxy::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QUrl url = job->requestUrl();
+    const QString filePath = QUrl::fromPercentEncoding(url.path(QUrl::FullyEncoded).mid(1).toLatin1());
+    if(url.host() != "image" || !m_assetResolver->isAsset(filePath))
+    {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    const QString key = keyOf(filePath, m_width);
+    if(Image* image = m_images.object(key))
+    {
+        QBuffer* buffer = new QBuffer(job);
+        buffer->setData(image->data);
+        job->reply(image->contentType, buffer);
+        return;
+    }
+
+    //decode in the pool, and reply in this thread if the job is still alive
+    QPointer<QWebEngineUrlRequestJob> pendingJob(job);
+    QPointer<HPEImageProxy> self(this);
+    QString cacheFile = m_cacheDir.absoluteFilePath(key);
+    int width = m_width;
+    QThreadPool::globalInstance()->start([self, pendingJob, filePath, width, key, cacheFile]{
+        Image image = load(filePath, width, cacheFile);
+        if(!self)
+            return;
+        QMetaObject::invokeMethod(self, [self, pendingJob, key, image]{
+            if(!self)
+                return;
+            if(!image.data.isEmpty())
+                self->m_images.insert(key, new Image(image), image.data.size());
+            if(image.saved)
+            {
+                self->m_savedSize += image.data.size();
+                if(self->m_savedSize > MAX_DISK_CACHE_SIZE / 4)
+                    self->startPruning();
+            }
+            if(!pendingJob)
+                return;
+            if(image.data.isEmpty())
+            {
+                pendingJob->fail(QWebEngineUrlRequestJob::UrlNotFound);
+                return;
+            }
+            QBuffer* buffer = new QBuffer(pendingJob);
+            buffer->setData(image.data);
+            pendingJob->reply(image.contentType, buffer);
+        }, Qt::QueuedConnection);
+    });
+}
+
+HPEImageProxy::Image HPEImageProxy::load(const QString &filePath, int width, const QString &cacheFile)
+{
+    Image image;
+    QFile cached(cacheFile);
+    if(cached.open(QIODevice::ReadOnly))
+    {
+        image.data = cached.readAll();
+        image.contentType = QMimeDatabase().mimeTypeForData(image.data).name().toLatin1();
+        return image;
+    }
+
+    //anything that isn't an image is not served
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+    QSize size = reader.size();
+    if(!reader.canRead() || !size.isValid())
+        return image;
+    if(size.width() <= width)
+    {
+        //small enough, the original one is served
+        QFile file(filePath);
+        if(file.open(QIODevice::ReadOnly))
+        {
+            image.data = file.readAll();
+            image.contentType = QMimeDatabase().mimeTypeForFile(filePath).name().toLatin1();
+        }
+        return image;
+    }
+
+    reader.setScaledSize(size.scaled(width, size.height(), Qt::KeepAspectRatio));
+    QImage decoded = reader.read();
+    if(decoded.isNull())
+        return image;
+
+    QBuffer buffer(&image.data);
+    buffer.open(QIODevice::WriteOnly);
+    bool hasAlpha = decoded.hasAlphaChannel();
+    decoded.save(&buffer, hasAlpha ? "PNG" : "JPG", hasAlpha ? -1 : 85);
+    image.contentType = hasAlpha ? "image/png" : "image/jpeg";
+
+    QSaveFile saved(cacheFile);
+    if(saved.open(QIODevice::WriteOnly))
+    {
+        saved.write(image.data);
+        image.saved = saved.commit();
+    }
+    return image;
+}
+
+void HPEImageProxy::pruneDiskCache(const QString &cacheDir)
+{
+    qint64 size = 0;
+    //the most recently modified first
+    const QFileInfoList copies = QDir(cacheDir).entryInfoList(QDir::Files, QDir::Time);
+    for(const QFileInfo& copy : copies)
+    {
+        size += copy.size();
+        if(size > MAX_DISK_CACHE_SIZE)
+            QFile::remove(copy.absoluteFilePath());
+    }
+}
+
+void HPEImageProxy::startPruning()
+{
+    m_savedSize = 0;
+    QString cacheDir = m_cacheDir.absolutePath();
+    QThreadPool::globalInstance()->start([cacheDir]{
+        pruneDiskCache(cacheDir);
+    });
+}
+
+QString HPEImageProxy::keyOf(const QString &filePath, int width)
+{
+    QFileInfo fileInfo(filePath);
+    QByteArray source = QString("%1|%2|%3|%4").arg(fileInfo.absoluteFilePath()).arg(fileInfo.size())
+            .arg(fileInfo.lastModified().toMSecsSinceEpoch()).arg(width).toUtf8();
+    return QString::fromLatin1(QCryptographicHash::hash(source, QCryptographicHash::Sha1).toHex());
+}
@@ -0,0 +1,178 @@
+/**
+ * @file hpeimageproxy.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-26
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEIMAGEPROXY_H
+#define HPEIMAGEPROXY_H
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QCache>
+#include <QDir>
+
+#include "hpeassetresolver.h"
+
+/**
+ * @class HPEImageProxy
+ * @brief An HPEImageProxy serves downscaled copies of large local images to the preview
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * Photos in the assets folder may be tens of MB. Instead of letting the web page decode them
+ * at full resolution every time a block is rendered, urlOf() rewrites the URL of a large local image to
+ * @code
+ *      hpe-image://image/<percent-encoded absolute path>
+ * @endcode
+ * and HPEImageProxy replies a copy no wider than the preview (see watchWidth()).
+ * The image is downscaled while decoding by QImageReader::setScaledSize().
+ * 
+ * Decoding runs in QThreadPool. The copies are cached in memory (LRU, by bytes)
+ * and on disk under the cache location, keyed by the path, the size and the modified time
+ * of the image, and the width. The disk cache is pruned to MAX_DISK_CACHE_SIZE,
+ * the least recently modified copies first.
+ * 
+ * Only files that HPEAssetResolver::isAsset() accepts and that decode as images are served,
+ * any other request fails with QWebEngineUrlRequestJob::UrlNotFound. The scheme is not CORS-enabled,
+ * so a script in a post can't read the replies.
+ * 
+ * @attention registerUrlScheme() must be called before QApplication is constructed.
+*/
+class HPEImageProxy : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct an HPEImageProxy with parent
+     * 
+     * @param[in] assetResolver Decides which files are served
+     * @param[in] parent 
+    */
+    explicit HPEImageProxy(HPEAssetResolver* assetResolver, QObject *parent = nullptr);
+
+    /**
+     * @brief Register the 'hpe-image' scheme
+     * 
+     * @see QWebEngineUrlScheme::registerScheme()
+    */
+    static void registerUrlScheme();
+
+    /**
+     * @brief Returns the URL the preview should load asset from:
+     * the proxy's URL for large local raster images, otherwise asset.url.
+     * This method is thread-safe.
+     * 
+     * @param[in] asset 
+    */
+    static QString urlOf(const HPEAssetResolver::Asset& asset);
+
+    /**
+     * @brief Size the copies to the width of widget (in device pixels).
+     * The width only grows, so the cached copies stay valid.
+     * 
+     * @param[in] widget 
+    */
+    void watchWidth(QWidget* widget);
+
+    void requestStarted(QWebEngineUrlRequestJob* job) override;
+
+    /**
+     * @brief The name of the scheme
+     * 
+    */
+    static const QByteArray SCHEME;
+
+protected:
+
+    /**
+     * @brief Update the width when the watched widget is resized
+     * 
+    */
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+
+    /**
+     * @brief A downscaled copy
+     * 
+    */
+    struct Image
+    {
+        QByteArray data;
+        QByteArray contentType;
+
+        /**
+         * @brief Whether the copy was just written to the disk cache
+         * 
+        */
+        bool saved = false;
+    };
+
+    /**
+     * @brief Returns the copy of filePath no wider than width from the disk cache,
+     * or decodes it and saves it to the disk cache. Runs in QThreadPool.
+     * 
+     * @return An Image with empty data if the file can't be decoded as an image
+    */
+    static Image load(const QString& filePath, int width, const QString& cacheFile);
+
+    /**
+     * @brief Remove the least recently modified copies in cacheDir until
+     * they take no more than MAX_DISK_CACHE_SIZE. Runs in QThreadPool.
+     * 
+    */
+    static void pruneDiskCache(const QString& cacheDir);
+
+    /**
+     * @brief Queue pruneDiskCache()
+     * 
+    */
+    void startPruning();
+
+    /**
+     * @brief Returns the key of the copy of filePath no wider than width,
+     * which changes if the file is modified
+     * 
+    */
+    static QString keyOf(const QString& filePath, int width);
+
+    HPEAssetResolver* m_assetResolver;
+    QCache<QString, Image> m_images;
+    QDir m_cacheDir;
+    int m_width = MIN_WIDTH;
+
+    /**
+     * @brief The bytes written to the disk cache since it was last pruned
+     * 
+    */
+    qint64 m_savedSize = 0;
+
+    /**
+     * @brief The disk cache is pruned when MAX_DISK_CACHE_SIZE / 4 bytes have been written since the last time
+     * 
+    */
+    static constexpr qint64 MAX_DISK_CACHE_SIZE = 256 * 1024 * 1024;
+
+    /**
+     * @brief Images smaller than it (in bytes) are not proxied
+     * 
+    */
+    static constexpr qint64 MIN_PROXIED_SIZE = 512 * 1024;
+
+    /**
+     * @brief The width is rounded up to a multiple of WIDTH_STEP
+     * 
+    */
+    static constexpr int MIN_WIDTH  = 512;
+    static constexpr int WIDTH_STEP = 256;
+};
+
+#endif // HPEIMAGEPROXY_H
@@ -0,0 +1,327 @@
+/**
+ * @file hpelinkscanner.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-18
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpelinkscanner.h"
+
+#include <cstring>
+
+/**
+ * @brief Returns a word whose lane has its highest bit set if the lane of word equals c.
+ * The result is not zero if and only if any of the four UTF-16 lanes equals c.
+ * 
+*/
+static inline quint64 lanesEqual(quint64 word, char16_t c)
+{
+    const quint64 ones = Q_UINT64_C(0x0001000100010001);
+    quint64 x = word ^ (quint64(c) * ones);
+    return (x - ones) & ~x & Q_UINT64_C(0x8000800080008000);
+}
+
+static inline bool isCandidate(char16_t c)
+{
+    return c == u'[' || c == u'<' || c == u'`';
+}
+
+static inline bool isLineBreak(char16_t c)
+{
+    return c == u'\n' || c == u'\r' || c == 0x2028 || c == 0x2029;
+}
+
+static inline bool isSpace(char16_t c)
+{
+    return c == u' ' || c == u'\t' || isLineBreak(c);
+}
+
+static inline bool isAsciiLetter(char16_t c)
+{
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z');
+}
+
+static inline char16_t toLowerAscii(char16_t c)
+{
+    return (c >= u'A' && c <= u'Z') ? char16_t(c + (u'a' - u'A')) : c;
+}
+
+HPELinkScanner::HPELinkScanner(QStringView text)
+    : m_text(text) { }
+
+bool HPELinkScanner::next(Match &match)
+{
+    const qsizetype size = m_text.size();
+    while(true)
+    {
+        m_position = findCandidate();
+        if(m_position >= size)
+            return false;
+
+        qsizetype pos = m_position;
+        char16_t c = m_text.utf16()[pos];
+        if(isEscaped(pos))
+        {
+            ++m_position;
+            continue;
+        }
+        if(c == u'`')
+        {
+            m_position = skipCodeSpan(pos);
+            continue;
+        }
+
+        if(c == u'[' ? parseLink(pos, match) : parseHtmlImage(pos, match))
+        {
+            //images may be nested in the text of a link
+            m_position = match.kind == Link ? match.textStart : match.start + match.length;
+            return true;
+        }
+        ++m_position;
+    }
+}
+
+bool HPELinkScanner::isUrl(QStringView text)
+{
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    if(size == 0 || !isAsciiLetter(text.utf16()[0]))
+        return false;
+    while(i < size && isAsciiLetter(text.utf16()[i]))
+        ++i;
+    if(!text.mid(i).startsWith(u"://") || i + 3 >= size)
+        return false;
+    for(i += 3; i < size; ++i)
+        if(isSpace(text.utf16()[i]))
+            return false;
+    return true;
+}
+
+qsizetype HPELinkScanner::findCandidate() const
+{
+    const char16_t* data = m_text.utf16();
+    const qsizetype size = m_text.size();
+    qsizetype pos = m_position;
+
+    //check four code units at a time until a word contains a candidate
+    for(; pos + 4 <= size; pos += 4)
+    {
+        quint64 word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        if(lanesEqual(word, u'[') | lanesEqual(word, u'<') | lanesEqual(word, u'`'))
+            break;
+    }
+    for(; pos < size; ++pos)
+        if(isCandidate(data[pos]))
+            return pos;
+    return size;
+}
+
+bool HPELinkScanner::parseLink(qsizetype pos, Match &match) const
+{
+    const char16_t* data = m_text.utf16();
+    const qsizetype size = m_text.size();
+    bool isImage = pos > 0 && data[pos - 1] == u'!' && !isEscaped(pos - 1);
+
+    //the closing ']', brackets can be nested
+    qsizetype i = pos + 1;
+    int depth = 1;
+    while(i < size)
+    {
+        char16_t c = data[i];
+        if(isLineBreak(c))
+            return false;
+        if(c == u'\\')
+            i += 2;
+        else if(c == u'`')
+            i = skipCodeSpan(i);
+        else
+        {
+            if(c == u'[')
+                ++depth;
+            else if(c == u']' && --depth == 0)
+                break;
+            ++i;
+        }
+    }
+    if(i + 1 >= size || data[i + 1] != u'(')
+        return false;
+
+    match.kind = isImage ? Image : Link;
+    match.start = isImage ? pos - 1 : pos;
+    match.textStart = pos + 1;
+    match.textLength = i - pos - 1;
+
+    //the destination
+    qsizetype j = i + 2;
+    while(j < size && (data[j] == u' ' || data[j] == u'\t'))
+        ++j;
+    if(j < size && data[j] == u'<')
+    {
+        match.urlStart = ++j;
+        while(j < size && data[j] != u'>')
+        {
+            if(data[j] == u'<' || isLineBreak(data[j]))
+                return false;
+            j += data[j] == u'\\' ? 2 : 1;
+        }
+        if(j >= size)
+            return false;
+        match.urlLength = j++ - match.urlStart;
+    }
+    else
+    {
+        match.urlStart = j;
+        int parentheses = 0;
+        while(j < size && !isSpace(data[j]))
+        {
+            if(data[j] == u'\\')
+            {
+                j += 2;
+                continue;
+            }
+            if(data[j] == u'(')
+                ++parentheses;
+            else if(data[j] == u')' && parentheses-- == 0)
+                break;
+            ++j;
+        }
+        j = qMin(j, size);
+        match.urlLength = j - match.urlStart;
+    }
+
+    //the optional title
+    while(j < size && (data[j] == u' ' || data[j] == u'\t'))
+        ++j;
+    if(j < size && (data[j] == u'"' || data[j] == u'\'' || data[j] == u'(') && j > match.urlStart + match.urlLength)
+    {
+        char16_t closing = data[j] == u'(' ? u')' : data[j];
+        for(++j; j < size && data[j] != closing; j += data[j] == u'\\' ? 2 : 1)
+            if(isLineBreak(data[j]))
+                return false;
+        if(j >= size)
+            return false;
+        ++j;
+        while(j < size && (data[j] == u' ' || data[j] == u'\t'))
+            ++j;
+    }
+    if(j >= size || data[j] != u')')
+        return false;
+
+    match.length = j + 1 - match.start;
+    return true;
+}
+
+bool HPELinkScanner::parseHtmlImage(qsizetype pos, Match &match) const
+{
+    const char16_t* data = m_text.utf16();
+    const qsizetype size = m_text.size();
+    if(pos + 5 > size || toLowerAscii(data[pos + 1]) != u'i' || toLowerAscii(data[pos + 2]) != u'm'
+            || toLowerAscii(data[pos + 3]) != u'g' || !isSpace(data[pos + 4]))
+        return false;
+
+    bool hasSource = false;
+    qsizetype i = pos + 4;
+    while(true)
+    {
+        while(i < size && isSpace(data[i]))
+            ++i;
+        if(i >= size)
+            return false;
+        if(data[i] == u'>' || (data[i] == u'/' && i + 1 < size && data[i + 1] == u'>'))
+            break;
+
+        //attribute name
+        qsizetype nameStart = i;
+        while(i < size && !isSpace(data[i]) && data[i] != u'=' && data[i] != u'>' && data[i] != u'/')
+            ++i;
+        if(i == nameStart)
+            return false;
+        bool isSource = i - nameStart == 3 && toLowerAscii(data[nameStart]) == u's'
+                && toLowerAscii(data[nameStart + 1]) == u'r' && toLowerAscii(data[nameStart + 2]) == u'c';
+
+        while(i < size && isSpace(data[i]))
+            ++i;
+        if(i >= size || data[i] != u'=')
+            continue;
+        ++i;
+        while(i < size && isSpace(data[i]))
+            ++i;
+        if(i >= size)
+            return false;
+
+        //attribute value
+        qsizetype valueStart, valueEnd;
+        if(data[i] == u'"' || data[i] == u'\'')
+        {
+            char16_t quote = data[i];
+            valueStart = ++i;
+            while(i < size && data[i] != quote)
+                ++i;
+            if(i >= size)
+                return false;
+            valueEnd = i++;
+        }
+        else
+        {
+            valueStart = i;
+            while(i < size && !isSpace(data[i]) && data[i] != u'>')
+                ++i;
+            valueEnd = i;
+        }
+        if(isSource && !hasSource)
+        {
+            hasSource = true;
+            match.urlStart = valueStart;
+            match.urlLength = valueEnd - valueStart;
+        }
+    }
+    if(!hasSource)
+        return false;
+
+    match.kind = HtmlImage;
+    match.start = pos;
+    match.length = (data[i] == u'>' ? i + 1 : i + 2) - pos;
+    match.textStart = pos;
+    match.textLength = 0;
+    return true;
+}
+
+qsizetype HPELinkScanner::skipCodeSpan(qsizetype pos) const
+{
+    const char16_t* data = m_text.utf16();
+    const qsizetype size = m_text.size();
+    qsizetype i = pos;
+    while(i < size && data[i] == u'`')
+        ++i;
+    const qsizetype length = i - pos;
+
+    //a closing run of backticks with the same length
+    while(i < size)
+    {
+        if(data[i] != u'`')
+        {
+            ++i;
+            continue;
+        }
+        qsizetype runStart = i;
+        while(i < size && data[i] == u'`')
+            ++i;
+        if(i - runStart == length)
+            return i;
+    }
+    return pos + length;
+}
+
+bool HPELinkScanner::isEscaped(qsizetype pos) const
+{
+    qsizetype backslashes = 0;
+    while(pos - backslashes > 0 && m_text.utf16()[pos - backslashes - 1] == u'\\')
+        ++backslashes;
+    return backslashes % 2 == 1;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file hpelinkscanner.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-18
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPELINKSCANNER_H
+#define HPELINKSCANNER_H
+
+#include <QStringView>
+
+/**
+ * @class HPELinkScanner
+ * @brief A single-pass scanner finding inline links, images and raw <img> tags in Markdown text
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPELinkScanner walks the UTF-16 data of a text once and reports every
+ *  - inline link:  [text](url "title")
+ *  - image:        ![alt](url "title")
+ *  - raw image:    <img src="url">
+ * 
+ * as offsets into the text, so scanning allocates nothing. It is shared by
+ * HPEMarkdownConverter (to resolve images' paths) and HPEMarkdownEditor (to list links).
+ * 
+ * The scanner jumps between candidate characters ('[', '<' and '`') by checking
+ * four UTF-16 code units at a time in a 64-bit word. Brackets never cross a line break,
+ * and nothing inside code spans is reported.
+ * 
+ * @code
+ *      HPELinkScanner scanner(text);
+ *      HPELinkScanner::Match match;
+ *      while(scanner.next(match))
+ *          qDebug() << text.mid(match.urlStart, match.urlLength);
+ * @endcode
+*/
+class HPELinkScanner
+{
+public:
+
+    /**
+     * @brief The kind of a match
+     * 
+    */
+    enum Kind
+    {
+        Link,
+        Image,
+        HtmlImage
+    };
+
+    /**
+     * @brief A match found by next(), all positions are offsets into the scanned text
+     * 
+    */
+    struct Match
+    {
+        Kind kind = Link;
+
+        /**
+         * @brief The whole link, image or tag
+         * 
+        */
+        qsizetype start = 0;
+        qsizetype length = 0;
+
+        /**
+         * @brief The text of a link or the alt of an image, empty for HtmlImage
+         * 
+        */
+        qsizetype textStart = 0;
+        qsizetype textLength = 0;
+
+        /**
+         * @brief The destination of a link or the source of an image (without '<' '>' or quotes)
+         * 
+        */
+        qsizetype urlStart = 0;
+        qsizetype urlLength = 0;
+    };
+
+    /**
+     * @brief Construct an HPELinkScanner scanning text.
+     * The text must outlive the scanner.
+     * 
+     * @param[in] text
+    */
+    explicit HPELinkScanner(QStringView text);
+
+    /**
+     * @brief Find the next match
+     * 
+     * @param[out] match
+     * @return false if there are no more matches
+    */
+    bool next(Match& match);
+
+    /**
+     * @brief Returns whether text is an absolute URL (scheme://...) without spaces
+     * 
+    */
+    static bool isUrl(QStringView text);
+
+private:
+
+    /**
+     * @brief Returns the position of the next '[', '<' or '`' from m_position, or the size of the text
+     * 
+    */
+    qsizetype findCandidate() const;
+
+    /**
+     * @brief Try to parse an inline link or image whose '[' is at pos
+     * 
+    */
+    bool parseLink(qsizetype pos, Match& match) const;
+
+    /**
+     * @brief Try to parse an <img> tag whose '<' is at pos
+     * 
+    */
+    bool parseHtmlImage(qsizetype pos, Match& match) const;
+
+    /**
+     * @brief Returns the position after the code span whose first '`' is at pos,
+     * or the position after the backticks if the span isn't closed
+     * 
+    */
+    qsizetype skipCodeSpan(qsizetype pos) const;
+
+    /**
+     * @brief Returns whether the character at pos is escaped by backslashes
+     * 
+    */
+    bool isEscaped(qsizetype pos) const;
+
+    QStringView m_text;
+    qsizetype m_position = 0;
+};
+
+#endif // HPELINKSCANNER_H
@@ -0,0 +1,184 @@
+/**
+ * @file hpemarkdownconverter.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-16
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpemarkdownconverter.h"
+
+#include "hpelinkscanner.h"
+#include "hpeassetresolver.h"
+#include "hpeimageproxy.h"
+
+/**
+ * @brief Replace list[from, from + count) with items
+ * 
+*/
+static void replaceRange(QStringList& list, int from, int count, const QStringList& items)
+{
+    int diff = items.size() - count;
+    if(diff > 0)
+        list.insert(from, diff, QString());
+    else if(diff < 0)
+        list.remove(from, -diff);
+    for(int i = 0; i < items.size(); ++i)
+        list[from + i] = items.at(i);
+}
+
+HPEMarkdownConverter::HPEMarkdownConverter(QObject *parent)
+    : QObject{parent} { }
+
+void HPEMarkdownConverter::setAssetResolver(HPEAssetResolver *resolver)
+{
+    m_assetResolver = resolver;
+}
+
+void HPEMarkdownConverter::setImageProxyEnabled(bool enabled)
+{
+    m_imageProxyEnabled = enabled;
+}
+
+void HPEMarkdownConverter::invalidateBefore(int version)
+{
+    m_validVersion.storeRelease(version);
+}
+
+bool HPEMarkdownConverter::isStale(int version) const
+{
+    return version < m_validVersion.loadAcquire();
+}
+
+void HPEMarkdownConverter::reset(int version, const QStringList &sourceLines)
+{
+    if(isStale(version))
+        return;
+
+    m_sourceLines = sourceLines;
+    m_convertedBlocks.clear();
+    m_convertedBlocks.reserve(sourceLines.size());
+    for(const QString& line : sourceLines)
+    {
+        //a newer reset is queued, give up
+        if(isStale(version))
+            return;
+        m_convertedBlocks.append(convertBlock(line));
+    }
+
+    m_frontMatter.parse(m_sourceLines);
+    emit convertedAll(version, joinConvertedBlocks());
+}
+
+void HPEMarkdownConverter::applyChange(int version, int firstBlock, int removedCount, const QStringList &sourceLines)
+{
+    if(isStale(version))
+        return;
+    if(firstBlock < 0 || removedCount < 1 || sourceLines.isEmpty()
+            || firstBlock + removedCount > m_sourceLines.size())
+    {
+        emit syncLost(version);
+        return;
+    }
+
+    QStringList convertedLines;
+    convertedLines.reserve(sourceLines.size());
+    for(const QString& line : sourceLines)
+        convertedLines.append(convertBlock(line));
+    bool frontMatterTouched = m_frontMatter.isTouchedBy(firstBlock, sourceLines);
+
+    const int previousSize = m_sourceLines.size();
+    replaceRange(m_sourceLines, firstBlock, removedCount, sourceLines);
+    replaceRange(m_convertedBlocks, firstBlock, removedCount, convertedLines);
+
+    if(frontMatterTouched)
+    {
+        BlockRange previousRange = m_frontMatter.range();
+        QString previousTitle = m_frontMatter.title();
+        int previousBodyStart = firstOutputBlockNumber();
+        int previousHeadLines = previousTitle.isEmpty() ? 0 : 1;
+        m_frontMatter.parse(m_sourceLines);
+        if(previousRange != m_frontMatter.range() || previousTitle != m_frontMatter.title()
+                || firstBlock < firstOutputBlockNumber())
+        {
+            //the head of the output changes: replace the output up to the first block after the change
+            //that is in the body both before and after it, the lines after it are unchanged
+            int previousEnd = firstBlock + removedCount;
+            int end = firstBlock + sourceLines.size();
+            int shift = qMax(0, qMax(previousBodyStart - previousEnd, firstOutputBlockNumber() - end));
+            shift = qMin(shift, previousSize - previousEnd);
+            previousEnd += shift;
+            end += shift;
+
+            int removedLines = previousHeadLines + qMax(0, previousEnd - previousBodyStart);
+            QStringList head = outputLines(end);
+            if(removedLines == 0 && head.isEmpty())
+                return;
+            if(removedLines == 0 || head.isEmpty())
+                emit convertedAll(version, joinConvertedBlocks());
+            else
+                emit convertedChanged(version, 0, removedLines, head);
+            return;
+        }
+    }
+
+    int from = outputLineOfBlock(firstBlock);
+    emit convertedChanged(version, from, from + removedCount, convertedLines);
+}
+
+QString HPEMarkdownConverter::convertBlock(const QString &text) const
+{
+    if(!m_assetResolver)
+        return text;
+
+    //the text is copied only if there are images
+    QString targetText;
+    qsizetype copied = 0;
+    HPELinkScanner scanner(text);
+    HPELinkScanner::Match match;
+    while(scanner.next(match))
+    {
+        if(match.kind == HPELinkScanner::Link || match.urlLength == 0 || match.urlStart < copied)
+            continue;
+        if(copied == 0)
+            targetText.reserve(text.size() + 64);
+        targetText.append(QStringView(text).mid(copied, match.urlStart - copied));
+        HPEAssetResolver::Asset asset = m_assetResolver->resolve(text.mid(match.urlStart, match.urlLength));
+        targetText.append(m_imageProxyEnabled ? HPEImageProxy::urlOf(asset) : asset.url);
+        copied = match.urlStart + match.urlLength;
+    }
+    if(copied == 0)
+        return text;
+
+    targetText.append(QStringView(text).mid(copied));
+    return targetText;
+}
+
+int HPEMarkdownConverter::firstOutputBlockNumber() const
+{
+    return m_frontMatter.bodyStart();
+}
+
+int HPEMarkdownConverter::outputLineOfBlock(int blockNumber) const
+{
+    return blockNumber - firstOutputBlockNumber() + (m_frontMatter.title().isEmpty() ? 0 : 1);
+}
+
+QStringList HPEMarkdownConverter::outputLines(int endBlock) const
+{
+    QStringList lines;
+    if(!m_frontMatter.title().isEmpty())
+        lines.append(QString("# %1").arg(m_frontMatter.title()));
+    if(endBlock > firstOutputBlockNumber())
+        lines.append(m_convertedBlocks.mid(firstOutputBlockNumber(), endBlock - firstOutputBlockNumber()));
+    return lines;
+}
+
+QString HPEMarkdownConverter::joinConvertedBlocks() const
+{
+    return outputLines(m_convertedBlocks.size()).join('\n');
+}
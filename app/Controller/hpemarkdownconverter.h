@@ -0,0 +1,235 @@
+/**
+ * @file hpemarkdownconverter.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-16
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEMARKDOWNCONVERTER_H
+#define HPEMARKDOWNCONVERTER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QAtomicInt>
+
+#include "hpefrontmatter.h"
+
+class HPEAssetResolver;
+
+/**
+ * @class HPEMarkdownConverter
+ * @brief An HPEMarkdownConverter converts Hexo document to standard Markdown text in a worker thread.
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPEMarkdownConverter is designed to live in a worker thread (see QObject::moveToThread()).
+ * HPEConvertedMarkdownPreview sends it snapshots of the source lines by queued signals,
+ * and receives the converted Markdown by queued signals as well,
+ * so that the GUI thread never waits for converting.
+ * 
+ * @par Converting rules
+ * 
+ * 1. analyze Hexo's Front-Matter and extract some useful information, such as
+ * title, date, classification and tags.
+ * 
+ * @note Visit https://hexo.io/docs/front-matter for more info
+ * 
+ * @todo in this version, only title will be analyzed.
+ * 
+ * 2. analyze Hexo's assets folder links and convert it
+ * to local path (by the shared HPEAssetResolver, see setAssetResolver()).
+ * 
+ * @note Visit https://hexo.io/docs/asset-folders for more info
+ * 
+ * 3. analyze Hexo's tag plugin.
+ * 
+ * @todo in this version, tag plugins are not processed.
+ * 
+ * @note Visit https://hexo.io/docs/tag-plugins for more info
+ * 
+ * @par Jobs and versions
+ * 
+ * Every job carries a version. reset() converts a whole snapshot of the source,
+ * while applyChange() replaces some blocks of the last snapshot and re-converts only them.
+ * Front-Matter is re-parsed only when the change touches it (see HPEFrontMatter::isTouchedBy()). If its range or the title changes,
+ * convertedChanged() replaces the head of the output, up to the first block after the change, without re-converting any block.
+ * The whole output is joined only by reset().
+ * 
+ * Before queuing a reset, the GUI thread calls invalidateBefore() with its version,
+ * then the jobs queued before it are skipped as soon as the worker reaches them.
+*/
+class HPEMarkdownConverter : public QObject
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct an HPEMarkdownConverter with parent
+     * 
+     * @param[in] parent
+    */
+    explicit HPEMarkdownConverter(QObject *parent = nullptr);
+
+    /**
+     * @brief Set the resolver of images' paths, which must outlive the converter.
+     * Images' paths remain the same without a resolver.
+     * 
+     * @param[in] resolver
+    */
+    void setAssetResolver(HPEAssetResolver* resolver);
+
+    /**
+     * @brief Set whether large local images are loaded from HPEImageProxy.
+     * Should be called before the converter is moved to the worker thread.
+     * 
+     * @see HPEImageProxy::urlOf()
+    */
+    void setImageProxyEnabled(bool enabled);
+
+    /**
+     * @brief Mark the jobs with a version less than version as stale.
+     * This method is thread-safe.
+     * 
+     * @param[in] version
+    */
+    void invalidateBefore(int version);
+
+public slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Convert all the source lines of the post.
+     * Emit convertedAll() after converting.
+     * 
+     * @param[in] version
+     * @param[in] sourceLines The text of each block
+    */
+    void reset(int version, const QStringList& sourceLines);
+
+    /**
+     * @brief Replace the blocks [firstBlock, firstBlock + removedCount) with sourceLines
+     * and convert them. Emit convertedChanged() (or convertedAll() if Front-Matter changes).
+     * 
+     * @param[in] version
+     * @param[in] firstBlock
+     * @param[in] removedCount
+     * @param[in] sourceLines The text of each new block
+    */
+    void applyChange(int version, int firstBlock, int removedCount, const QStringList& sourceLines);
+/**
+ * @}
+*/
+
+signals:
+/**
+ * @defgroup signals
+ * @{
+*/
+
+    /**
+     * @brief Transfer the whole converted Markdown document
+     * 
+    */
+    void convertedAll(int version, const QString& markdown);
+
+    /**
+     * @brief Lines [from, to) of the last converted Markdown document are replaced by lines.
+     * 
+    */
+    void convertedChanged(int version, int from, int to, const QStringList& lines);
+
+    /**
+     * @brief Emitted when a change doesn't match the blocks held by the converter.
+     * A reset() is needed.
+     * 
+    */
+    void syncLost(int version);
+/**
+ * @}
+*/
+
+private:
+
+    /**
+     * @brief Handle and convert text in one block.
+     * This method will find images by HPELinkScanner and convert assets folder links. (and tag plugins)
+     * 
+     * @param[in] text The text of the block to be processed
+     * @return Converted Markdown text in a block
+    */
+    QString convertBlock(const QString& text) const;
+
+    /**
+     * @brief Returns the number of the first block converted into the output,
+     * which is the block after Front-Matter.
+     * 
+    */
+    int firstOutputBlockNumber() const;
+
+    /**
+     * @brief Returns the line number in the converted text of the block with blockNumber
+     * 
+     * @param[in] blockNumber Should not be less than firstOutputBlockNumber()
+    */
+    int outputLineOfBlock(int blockNumber) const;
+
+    /**
+     * @brief Returns the title and m_convertedBlocks from the body to endBlock (excluded), one string per output line
+     * 
+    */
+    QStringList outputLines(int endBlock) const;
+
+    /**
+     * @brief Returns the title and m_convertedBlocks (except Front-Matter) joined
+     * 
+    */
+    QString joinConvertedBlocks() const;
+
+    /**
+     * @brief Returns whether the job with version is stale
+     * 
+    */
+    bool isStale(int version) const;
+
+    /**
+     * @brief Stores the snapshot of the source, one string per block
+     * 
+    */
+    QStringList m_sourceLines;
+
+    /**
+     * @brief Stores the converted text of every source block (Front-Matter blocks included)
+     * 
+    */
+    QStringList m_convertedBlocks;
+
+    /**
+     * @brief Front-Matter of the snapshot, the title is added as a heading to the output
+     * 
+    */
+    HPEFrontMatter m_frontMatter;
+
+    /**
+     * @brief Resolves images' paths, shared with the GUI thread
+     * 
+    */
+    HPEAssetResolver* m_assetResolver = nullptr;
+    bool m_imageProxyEnabled = false;
+
+    /**
+     * @brief Jobs with a version less than it are stale, written by the GUI thread
+     * 
+    */
+    QAtomicInt m_validVersion;
+};
+
+#endif // HPEMARKDOWNCONVERTER_H
@@ -0,0 +1,1178 @@
+/**
+ * @file hpemarkdownrenderer.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-12
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpemarkdownrenderer.h"
+
+#include <algorithm>
+
+void HPEMarkdownRenderer::setImageResolver(const UrlResolver &resolver)
+{
+    m_imageResolver = resolver;
+}
+
+void HPEMarkdownRenderer::setLineAnchors(bool enabled)
+{
+    m_lineAnchors = enabled;
+}
+
+QString HPEMarkdownRenderer::render(const QString &markdown) const
+{
+    return render(markdown.split('\n'));
+}
+
+QString HPEMarkdownRenderer::render(const QStringList &lines) const
+{
+    QString html;
+    html.reserve(lines.size() * 64);
+    collectDefinitions(lines);
+    renderBlocks(lines, html, false, m_lineAnchors);
+    return html;
+}
+
+void HPEMarkdownRenderer::collectDefinitions(const QStringList &lines) const
+{
+    m_definitions.clear();
+    QString fence;
+    bool inParagraph = false;
+    for(const QString& line : lines)
+    {
+        //definitions in block quotes count, too
+        QString text = line;
+        int indent = indentation(text);
+        while(indent < 4 && removeIndentation(text, indent).startsWith('>'))
+        {
+            text = removeIndentation(text, indent).mid(1);
+            indent = indentation(text);
+        }
+
+        if(!fence.isEmpty())
+        {
+            QString closing = text.trimmed();
+            if(indent < 4 && closing.startsWith(fence) && closing.count(fence.at(0)) == closing.size())
+                fence.clear();
+            continue;
+        }
+        if(indent < 4)
+            fence = openingFence(removeIndentation(text, indent));
+        if(!fence.isEmpty())
+        {
+            inParagraph = false;
+            continue;
+        }
+
+        //a definition can't interrupt a paragraph
+        QString label;
+        LinkDefinition definition;
+        if(!inParagraph && linkDefinition(text, &label, &definition.destination, &definition.title))
+        {
+            QString key = normalizedLabel(label);
+            if(!m_definitions.contains(key))
+                m_definitions.insert(key, definition);
+            continue;
+        }
+        inParagraph = !isBlank(text) && indent < 4 && atxHeadingLevel(removeIndentation(text, indent)) == 0
+                && !isThematicBreak(text);
+    }
+}
+
+void HPEMarkdownRenderer::renderBlocks(const QStringList &lines, QString &html, bool tight, bool anchors) const
+{
+    int i = 0;
+    const int n = lines.size();
+    //the line and the HTML position of the last block
+    int anchorLine = -1;
+    int anchorStart = 0;
+    while(i < n)
+    {
+        if(anchorLine >= 0)
+        {
+            addLineAnchor(html, anchorStart, anchorLine);
+            anchorLine = -1;
+        }
+
+        const QString& line = lines.at(i);
+        if(isBlank(line))
+        {
+            ++i;
+            continue;
+        }
+        if(anchors)
+        {
+            anchorLine  = i;
+            anchorStart = html.size();
+        }
+
+        int indent = indentation(line);
+
+        //indented codes
+        if(indent >= 4)
+        {
+            QStringList codes;
+            int lastNonBlank = i;
+            while(i < n && (isBlank(lines.at(i)) || indentation(lines.at(i)) >= 4))
+            {
+                if(!isBlank(lines.at(i)))
+                    lastNonBlank = i;
+                codes.append(removeIndentation(lines.at(i), 4));
+                ++i;
+            }
+            //trailing blank lines don't belong to the codes
+            int trailing = i - 1 - lastNonBlank;
+            codes = codes.mid(0, codes.size() - trailing);
+            html += QString("<pre><code>%1\n</code></pre>\n").arg(codes.join('\n').toHtmlEscaped());
+            continue;
+        }
+
+        QString text = removeIndentation(line, indent);
+
+        //fenced codes
+        QString fence = openingFence(text);
+        if(!fence.isEmpty())
+        {
+            QString info = text.mid(fence.size()).trimmed();
+            QString language = info.section(' ', 0, 0);
+            QStringList codes;
+            ++i;
+            while(i < n)
+            {
+                QString closing = lines.at(i).trimmed();
+                if(indentation(lines.at(i)) < 4 && closing.startsWith(fence)
+                        && closing.count(fence.at(0)) == closing.size())
+                {
+                    ++i;
+                    break;
+                }
+                codes.append(removeIndentation(lines.at(i), indent));
+                ++i;
+            }
+            QString code = codes.isEmpty() ? QString() : codes.join('\n').toHtmlEscaped() + '\n';
+            if(language.isEmpty())
+                html += QString("<pre><code>%1</code></pre>\n").arg(code);
+            else
+                html += QString("<pre><code class=\"hljs language-%1\">%2</code></pre>\n")
+                        .arg(language.toHtmlEscaped(), code);
+            continue;
+        }
+
+        //math blocks, kept for KaTeX
+        if(text.startsWith("$$"))
+        {
+            QStringList math = { text };
+            bool closed = text.size() >= 4 && text.trimmed().endsWith("$$");
+            ++i;
+            while(!closed && i < n)
+            {
+                math.append(lines.at(i));
+                closed = lines.at(i).trimmed().endsWith("$$");
+                ++i;
+            }
+            html += QString("<p>%1</p>\n").arg(math.join('\n').toHtmlEscaped());
+            continue;
+        }
+
+        //ATX headings
+        int level = atxHeadingLevel(text);
+        if(level > 0)
+        {
+            QString content = text.mid(level).trimmed();
+            //remove closing sequence
+            int closingStart = content.size();
+            while(closingStart > 0 && content.at(closingStart - 1) == '#')
+                --closingStart;
+            if(closingStart == 0 || (closingStart < content.size() && content.at(closingStart - 1) == ' '))
+                content = content.left(closingStart).trimmed();
+            html += QString("<h%1 id=\"%2\">%3</h%1>\n").arg(QString::number(level), headingId(content),
+                                                              renderInlines(content));
+            ++i;
+            continue;
+        }
+
+        //thematic breaks
+        if(isThematicBreak(text))
+        {
+            html += "<hr>\n";
+            ++i;
+            continue;
+        }
+
+        //block quotes
+        if(text.startsWith('>'))
+        {
+            QStringList quoted;
+            bool lazyAllowed = false;
+            while(i < n)
+            {
+                const QString& current = lines.at(i);
+                int currentIndent = indentation(current);
+                QString stripped = removeIndentation(current, currentIndent);
+                if(currentIndent < 4 && stripped.startsWith('>'))
+                {
+                    stripped = stripped.mid(1);
+                    if(stripped.startsWith(' '))
+                        stripped = stripped.mid(1);
+                    quoted.append(stripped);
+                    lazyAllowed = !isBlank(stripped) && openingFence(removeIndentation(stripped, 3)).isEmpty();
+                }
+                else if(lazyAllowed && !isBlank(current) && !interruptsParagraph(current))
+                    quoted.append(current);   //lazy continuation line
+                else
+                    break;
+                ++i;
+            }
+            html += "<blockquote>\n";
+            renderBlocks(quoted, html);
+            html += "</blockquote>\n";
+            continue;
+        }
+
+        //lists
+        if(listItemStart(line))
+        {
+            renderList(lines, i, html);
+            continue;
+        }
+
+        //HTML blocks, end with a blank line
+        if(isHtmlBlockStart(text))
+        {
+            while(i < n && !isBlank(lines.at(i)))
+                html += lines.at(i++) + '\n';
+            continue;
+        }
+
+        //link reference definitions, collected by render()
+        if(linkDefinition(text))
+        {
+            ++i;
+            continue;
+        }
+
+        //tables
+        if(renderTable(lines, i, html))
+            continue;
+
+        //paragraphs
+        QStringList paragraph = { text };
+        int setextLevel = 0;
+        ++i;
+        while(i < n && !isBlank(lines.at(i)))
+        {
+            const QString& current = lines.at(i);
+            QString trimmed = current.trimmed();
+            if(indentation(current) < 4 && !trimmed.isEmpty()
+                    && (trimmed.count('=') == trimmed.size() || trimmed.count('-') == trimmed.size()))
+            {
+                setextLevel = trimmed.at(0) == '=' ? 1 : 2;
+                ++i;
+                break;
+            }
+            if(interruptsParagraph(current))
+                break;
+            paragraph.append(removeIndentation(current, indentation(current)));
+            ++i;
+        }
+
+        //trailing spaces of the last line are not hard line breaks
+        QString content = paragraph.join('\n');
+        while(content.endsWith(' ') || content.endsWith('\t'))
+            content.chop(1);
+
+        if(setextLevel > 0)
+            html += QString("<h%1 id=\"%2\">%3</h%1>\n").arg(QString::number(setextLevel), headingId(content),
+                                                              renderInlines(content));
+        else if(tight)
+            html += renderInlines(content) + '\n';
+        else
+            html += QString("<p>%1</p>\n").arg(renderInlines(content));
+    }
+    if(anchorLine >= 0)
+        addLineAnchor(html, anchorStart, anchorLine);
+}
+
+void HPEMarkdownRenderer::addLineAnchor(QString &html, int start, int line)
+{
+    //not in raw HTML comments or declarations
+    if(start + 1 >= html.size() || html.at(start) != '<' || !html.at(start + 1).isLetter())
+        return;
+    int nameEnd = start + 1;
+    while(nameEnd < html.size() && html.at(nameEnd).isLetterOrNumber())
+        ++nameEnd;
+    html.insert(nameEnd, QString(" data-line=\"%1\"").arg(line));
+}
+
+void HPEMarkdownRenderer::renderList(const QStringList &lines, int &i, QString &html) const
+{
+    const int n = lines.size();
+    QChar marker;
+    int start;
+    int contentOffset;
+    listItemStart(lines.at(i), &marker, &start, &contentOffset);
+    bool ordered = start >= 0;
+
+    QList<QStringList> items;
+    bool loose = false;
+    bool blankBetween = false;
+
+    while(i < n)
+    {
+        QChar itemMarker;
+        int itemStart;
+        int itemOffset;
+        if(!listItemStart(lines.at(i), &itemMarker, &itemStart, &itemOffset)
+                || itemMarker != marker || (itemStart >= 0) != ordered)
+            break;
+        if(blankBetween)
+            loose = true;
+
+        //the first line of the item, itemOffset is a column
+        QStringList item;
+        QString first = expandTabs(lines.at(i), itemOffset).mid(itemOffset);
+        item.append(isBlank(first) ? QString() : first);
+        ++i;
+
+        //following lines
+        bool lastBlank = isBlank(item.last());
+        blankBetween = false;
+        while(i < n)
+        {
+            const QString& current = lines.at(i);
+            if(isBlank(current))
+            {
+                item.append(QString());
+                lastBlank = true;
+                ++i;
+                continue;
+            }
+            int currentIndent = indentation(current);
+            if(currentIndent >= itemOffset)
+            {
+                if(lastBlank && item.size() > 1)
+                    loose = true;
+                item.append(removeIndentation(current, itemOffset));
+                lastBlank = false;
+                ++i;
+                continue;
+            }
+            if(!lastBlank && !interruptsParagraph(current) && !listItemStart(current))
+            {
+                //lazy continuation line
+                item.append(removeIndentation(current, currentIndent));
+                ++i;
+                continue;
+            }
+            break;
+        }
+
+        //trailing blank lines belong to the space between items
+        while(!item.isEmpty() && item.size() > 1 && isBlank(item.last()))
+        {
+            item.removeLast();
+            blankBetween = true;
+        }
+        items.append(item);
+    }
+
+    if(ordered)
+        html += start == 1 ? QString("<ol>\n") : QString("<ol start=\"%1\">\n").arg(start);
+    else
+        html += "<ul>\n";
+
+    for(QStringList& item : items)
+    {
+        html += "<li>";
+        //task list items
+        QString& first = item.first();
+        if(first.startsWith("[ ] ") || first.startsWith("[x] ") || first.startsWith("[X] "))
+        {
+            html += first.at(1) == ' ' ? QString("<input disabled=\"\" type=\"checkbox\"> ")
+                                       : QString("<input checked=\"\" disabled=\"\" type=\"checkbox\"> ");
+            first = first.mid(4);
+        }
+        QString itemHtml;
+        renderBlocks(item, itemHtml, !loose);
+        if(!loose && itemHtml.endsWith('\n'))
+            itemHtml.chop(1);
+        html += itemHtml + "</li>\n";
+    }
+
+    html += ordered ? "</ol>\n" : "</ul>\n";
+}
+
+bool HPEMarkdownRenderer::renderTable(const QStringList &lines, int &i, QString &html) const
+{
+    if(i + 1 >= lines.size() || !lines.at(i).contains('|'))
+        return false;
+
+    //delimiter row
+    QStringList delimiters = splitTableRow(lines.at(i + 1));
+    QStringList headers = splitTableRow(lines.at(i));
+    if(delimiters.isEmpty() || delimiters.size() != headers.size())
+        return false;
+    QStringList aligns;
+    for(const QString& delimiter : delimiters)
+    {
+        QString cell = delimiter.trimmed();
+        bool left  = cell.startsWith(':');
+        bool right = cell.endsWith(':');
+        QString dashes = cell.mid(left ? 1 : 0);
+        dashes.chop(right ? 1 : 0);
+        if(dashes.isEmpty() || dashes.count('-') != dashes.size())
+            return false;
+        aligns.append(left && right ? QString(" align=\"center\"") : left ? QString(" align=\"left\"")
+                                    : right ? QString(" align=\"right\"") : QString());
+    }
+
+    html += "<table>\n<thead>\n<tr>\n";
+    for(int c = 0; c < headers.size(); ++c)
+        html += QString("<th%1>%2</th>\n").arg(aligns.at(c), renderInlines(headers.at(c).trimmed()));
+    html += "</tr>\n</thead>\n";
+
+    i += 2;
+    bool hasBody = false;
+    while(i < lines.size() && !isBlank(lines.at(i)) && !interruptsParagraph(lines.at(i)))
+    {
+        if(!hasBody)
+        {
+            html += "<tbody>";
+            hasBody = true;
+        }
+        QStringList cells = splitTableRow(lines.at(i));
+        html += "<tr>\n";
+        for(int c = 0; c < headers.size(); ++c)
+            html += QString("<td%1>%2</td>\n").arg(aligns.at(c),
+                                                   c < cells.size() ? renderInlines(cells.at(c).trimmed()) : QString());
+        html += "</tr>\n";
+        ++i;
+    }
+    html += hasBody ? "</tbody></table>\n" : "</table>\n";
+    return true;
+}
+
+QString HPEMarkdownRenderer::renderInlines(const QString &text) const
+{
+    QString html;
+    html.reserve(text.size() + text.size() / 4);
+    //the HTML is split into pieces at delimiter runs, which are filled in by processEmphasis()
+    QStringList pieces;
+    QList<Delimiter> delimiters;
+    int pos = 0;
+    const int n = text.size();
+    while(pos < n)
+    {
+        QChar c = text.at(pos);
+        switch(c.unicode())
+        {
+        case '\\':
+            if(pos + 1 < n && text.at(pos + 1) == '\n')
+            {
+                html += "<br>";
+                ++pos;
+            }
+            else if(pos + 1 < n && text.at(pos + 1).unicode() < 128 && isPunctuation(text.at(pos + 1)))
+            {
+                html += QString(text.at(pos + 1)).toHtmlEscaped();
+                pos += 2;
+            }
+            else
+                html += text.at(pos++);
+            continue;
+        case '`':
+        {
+            int runLength = 1;
+            while(pos + runLength < n && text.at(pos + runLength) == '`')
+                ++runLength;
+            QString run(runLength, '`');
+            int closing = pos + runLength;
+            //the closing run should have exactly the same length
+            while((closing = text.indexOf(run, closing)) >= 0)
+            {
+                if((closing + runLength >= n || text.at(closing + runLength) != '`'))
+                    break;
+                while(closing < n && text.at(closing) == '`')
+                    ++closing;
+            }
+            if(closing < 0)
+            {
+                html += run;
+                pos += runLength;
+                continue;
+            }
+            QString code = text.mid(pos + runLength, closing - pos - runLength);
+            code.replace('\n', ' ');
+            if(code.size() > 2 && code.startsWith(' ') && code.endsWith(' ') && !isBlank(code))
+                code = code.mid(1, code.size() - 2);
+            html += QString("<code>%1</code>").arg(code.toHtmlEscaped());
+            pos = closing + runLength;
+            continue;
+        }
+        case '$':
+        {
+            //math, kept as it is for KaTeX
+            bool display = pos + 1 < n && text.at(pos + 1) == '$';
+            QString delimiter = display ? QString("$$") : QString("$");
+            int closing = text.indexOf(delimiter, pos + delimiter.size());
+            if(!display)
+            {
+                //like Pandoc, $ opens math before a non-space, and closes it after a non-space
+                //and not before a digit, so "$5 and $10" is not math
+                if(pos + 1 >= n || text.at(pos + 1).isSpace())
+                    closing = -1;
+                while(closing > 0 && (text.at(closing - 1).isSpace() || text.at(closing - 1) == '\\'
+                                      || (closing + 1 < n && text.at(closing + 1).isDigit())))
+                    closing = text.indexOf(delimiter, closing + 1);
+            }
+            if(closing > pos + delimiter.size())
+            {
+                html += text.mid(pos, closing + delimiter.size() - pos).toHtmlEscaped();
+                pos = closing + delimiter.size();
+                continue;
+            }
+            html += c;
+            ++pos;
+            continue;
+        }
+        case '!':
+        case '[':
+            if(parseLink(text, pos, html))
+                continue;
+            html += c;
+            ++pos;
+            continue;
+        case '*':
+        case '_':
+        case '~':
+        {
+            int runLength = 1;
+            while(pos + runLength < n && text.at(pos + runLength) == c)
+                ++runLength;
+            //strikethrough needs '~~'
+            if(c == '~' && runLength != 2)
+            {
+                html += QString(runLength, c);
+                pos += runLength;
+                continue;
+            }
+
+            //the start and the end of text count as spaces
+            QChar before = pos > 0 ? text.at(pos - 1) : QChar(' ');
+            QChar after  = pos + runLength < n ? text.at(pos + runLength) : QChar(' ');
+            bool leftFlanking  = !after.isSpace() && (!isPunctuation(after) || before.isSpace() || isPunctuation(before));
+            bool rightFlanking = !before.isSpace() && (!isPunctuation(before) || after.isSpace() || isPunctuation(after));
+            Delimiter delimiter;
+            delimiter.c = c;
+            delimiter.length = delimiter.count = runLength;
+            //'_' is not intraword
+            delimiter.canOpen  = c == '_' ? leftFlanking && (!rightFlanking || isPunctuation(before)) : leftFlanking;
+            delimiter.canClose = c == '_' ? rightFlanking && (!leftFlanking || isPunctuation(after)) : rightFlanking;
+            pieces.append(html);
+            html.clear();
+            delimiter.piece = pieces.size();
+            pieces.append(QString());
+            delimiters.append(delimiter);
+            pos += runLength;
+            continue;
+        }
+        case '<':
+        {
+            int closing = text.indexOf('>', pos + 1);
+            if(closing > pos + 1)
+            {
+                QString inside = text.mid(pos + 1, closing - pos - 1);
+                //autolinks
+                int colon = inside.indexOf(':');
+                bool isScheme = colon > 1 && inside.at(0).isLetter();
+                for(int k = 1; k < colon && isScheme; ++k)
+                    isScheme = inside.at(k).unicode() < 128 && (inside.at(k).isLetterOrNumber()
+                               || inside.at(k) == '+' || inside.at(k) == '.' || inside.at(k) == '-');
+                if(isScheme && !inside.contains(' ') && !inside.contains('<'))
+                {
+                    html += QString("<a href=\"%1\">%2</a>").arg(inside.toHtmlEscaped(), inside.toHtmlEscaped());
+                    pos = closing + 1;
+                    continue;
+                }
+                if(inside.contains('@') && !inside.contains(' '))
+                {
+                    html += QString("<a href=\"mailto:%1\">%1</a>").arg(inside.toHtmlEscaped());
+                    pos = closing + 1;
+                    continue;
+                }
+                //raw HTML
+                QChar first = inside.at(0);
+                if(first.isLetter() || first == '/' || first == '!' || first == '?')
+                {
+                    html += text.mid(pos, closing - pos + 1);
+                    pos = closing + 1;
+                    continue;
+                }
+            }
+            html += "&lt;";
+            ++pos;
+            continue;
+        }
+        case '&':
+        {
+            //entities
+            int semicolon = text.indexOf(';', pos + 1);
+            if(semicolon > pos + 1 && semicolon - pos <= 32)
+            {
+                QString name = text.mid(pos + 1, semicolon - pos - 1);
+                bool valid = true;
+                for(int k = 0; k < name.size() && valid; ++k)
+                    valid = name.at(k).isLetterOrNumber() || (k == 0 && name.at(k) == '#');
+                if(valid)
+                {
+                    html += text.mid(pos, semicolon - pos + 1);
+                    pos = semicolon + 1;
+                    continue;
+                }
+            }
+            html += "&amp;";
+            ++pos;
+            continue;
+        }
+        case '\n':
+        {
+            //hard line breaks (two spaces at the end of the line)
+            if(html.endsWith("  "))
+            {
+                while(html.endsWith(' '))
+                    html.chop(1);
+                html += "<br>";
+            }
+            else
+                while(html.endsWith(' '))
+                    html.chop(1);
+            html += '\n';
+            ++pos;
+            continue;
+        }
+        case '>':
+            html += "&gt;";
+            ++pos;
+            continue;
+        case '"':
+            html += "&quot;";
+            ++pos;
+            continue;
+        default:
+            html += c;
+            ++pos;
+        }
+    }
+    if(delimiters.isEmpty())
+        return html;
+
+    pieces.append(html);
+    processEmphasis(delimiters);
+    for(const Delimiter& delimiter : qAsConst(delimiters))
+        pieces[delimiter.piece] = delimiter.closingTags + QString(delimiter.count, delimiter.c) + delimiter.openingTags;
+    return pieces.join(QString());
+}
+
+bool HPEMarkdownRenderer::parseLink(const QString &text, int &pos, QString &html) const
+{
+    const int n = text.size();
+    bool isImage = text.at(pos) == '!';
+    int open = isImage ? pos + 1 : pos;
+    if(open >= n || text.at(open) != '[')
+        return false;
+
+    //find the matching ']'
+    int depth = 0;
+    int close = -1;
+    for(int k = open; k < n; ++k)
+    {
+        QChar c = text.at(k);
+        if(c == '\\')
+            ++k;
+        else if(c == '`')
+        {
+            int end = text.indexOf('`', k + 1);
+            if(end > 0)
+                k = end;
+        }
+        else if(c == '[')
+            ++depth;
+        else if(c == ']' && --depth == 0)
+        {
+            close = k;
+            break;
+        }
+    }
+    if(close < 0)
+        return false;
+
+    QString label = text.mid(open + 1, close - open - 1);
+    QString destination;
+    QString title;
+    int k = close + 1;
+    if(k >= n || text.at(k) != '(')
+    {
+        //reference links: [text][label], [label][] and [label]
+        QString reference = label;
+        if(k < n && text.at(k) == '[')
+        {
+            int end = text.indexOf(']', k + 1);
+            if(end < 0)
+                return false;
+            if(end > k + 1)
+                reference = text.mid(k + 1, end - k - 1);
+            k = end + 1;
+        }
+        auto definition = m_definitions.constFind(normalizedLabel(reference));
+        if(definition == m_definitions.constEnd())
+            return false;
+        destination = definition->destination;
+        title = definition->title;
+        renderLink(label, destination, title, isImage, html);
+        pos = k;
+        return true;
+    }
+
+    //destination and title
+    ++k;
+    while(k < n && text.at(k).isSpace())
+        ++k;
+    if(k < n && text.at(k) == '<')
+    {
+        int end = text.indexOf('>', k + 1);
+        if(end < 0)
+            return false;
+        destination = text.mid(k + 1, end - k - 1);
+        k = end + 1;
+    }
+    else
+    {
+        int parentheses = 0;
+        int begin = k;
+        while(k < n && !text.at(k).isSpace())
+        {
+            QChar c = text.at(k);
+            if(c == '\\' && k + 1 < n)
+                ++k;
+            else if(c == '(')
+                ++parentheses;
+            else if(c == ')' && parentheses-- == 0)
+                break;
+            ++k;
+        }
+        destination = text.mid(begin, k - begin);
+    }
+    while(k < n && text.at(k).isSpace())
+        ++k;
+    if(k < n && (text.at(k) == '"' || text.at(k) == '\'' || text.at(k) == '('))
+    {
+        QChar closing = text.at(k) == '(' ? QChar(')') : text.at(k);
+        int end = text.indexOf(closing, k + 1);
+        if(end < 0)
+            return false;
+        title = text.mid(k + 1, end - k - 1);
+        k = end + 1;
+        while(k < n && text.at(k).isSpace())
+            ++k;
+    }
+    if(k >= n || text.at(k) != ')')
+        return false;
+
+    renderLink(label, destination, title, isImage, html);
+    pos = k + 1;
+    return true;
+}
+
+void HPEMarkdownRenderer::renderLink(const QString &label, const QString &destination, const QString &title,
+                                     bool isImage, QString &html) const
+{
+    QString titleAttribute = title.isEmpty() ? QString() : QString(" title=\"%1\"").arg(title.toHtmlEscaped());
+    if(isImage)
+    {
+        QString source = m_imageResolver ? m_imageResolver(destination) : destination;
+        html += QString("<img src=\"%1\" alt=\"%2\"%3>").arg(source.toHtmlEscaped(), label.toHtmlEscaped(), titleAttribute);
+    }
+    else
+        html += QString("<a href=\"%1\"%2>%3</a>").arg(destination.toHtmlEscaped(), titleAttribute, renderInlines(label));
+}
+
+void HPEMarkdownRenderer::processEmphasis(QList<Delimiter> &delimiters)
+{
+    //the opener of a closer is looked for only above the bottom of its kind,
+    //by the character, whether the closer can open and its length mod 3
+    int openersBottom[3][2][3];
+    std::fill(&openersBottom[0][0][0], &openersBottom[0][0][0] + 18, -1);
+
+    for(int closer = 0; closer < delimiters.size(); ++closer)
+    {
+        Delimiter& closing = delimiters[closer];
+        while(closing.canClose && closing.count > 0)
+        {
+            int kind = closing.c == '*' ? 0 : closing.c == '_' ? 1 : 2;
+            int& bottom = openersBottom[kind][closing.canOpen ? 1 : 0][closing.length % 3];
+            int opener = -1;
+            for(int k = closer - 1; k > bottom && opener < 0; --k)
+            {
+                const Delimiter& candidate = delimiters.at(k);
+                if(candidate.c != closing.c || !candidate.canOpen || candidate.count == 0)
+                    continue;
+                //strikethrough pairs runs of the same length,
+                //emphasis doesn't pair runs whose lengths sum to a multiple of 3 if either can both open and close
+                if(closing.c == '~' ? candidate.length != closing.length
+                                    : (candidate.canClose || closing.canOpen) && (candidate.length + closing.length) % 3 == 0
+                                      && (candidate.length % 3 != 0 || closing.length % 3 != 0))
+                    continue;
+                opener = k;
+            }
+            if(opener < 0)
+            {
+                bottom = closer - 1;
+                break;
+            }
+
+            Delimiter& opening = delimiters[opener];
+            int used = closing.c == '~' || (closing.count >= 2 && opening.count >= 2) ? 2 : 1;
+            QString tag = closing.c == '~' ? QString("del") : used == 2 ? QString("strong") : QString("em");
+            //the inner tags are closer to the text
+            opening.openingTags = QString("<%1>").arg(tag) + opening.openingTags;
+            closing.closingTags += QString("</%1>").arg(tag);
+            opening.count -= used;
+            closing.count -= used;
+            //the delimiters between them are left as text
+            for(int k = opener + 1; k < closer; ++k)
+                delimiters[k].canOpen = delimiters[k].canClose = false;
+        }
+    }
+}
+
+int HPEMarkdownRenderer::indentation(const QString &line)
+{
+    int columns = 0;
+    for(const QChar& c : line)
+    {
+        if(c == ' ')
+            ++columns;
+        else if(c == '\t')
+            columns += 4 - columns % 4;
+        else
+            break;
+    }
+    return columns;
+}
+
+QString HPEMarkdownRenderer::removeIndentation(const QString &line, int count)
+{
+    int columns = 0;
+    int k = 0;
+    while(k < line.size() && columns < count)
+    {
+        if(line.at(k) == ' ')
+            ++columns;
+        else if(line.at(k) == '\t')
+            columns += 4 - columns % 4;
+        else
+            break;
+        ++k;
+    }
+    //a tab may be partially removed
+    return columns > count ? QString(columns - count, ' ') + line.mid(k) : line.mid(k);
+}
+
+QString HPEMarkdownRenderer::expandTabs(const QString &line, int count)
+{
+    QString expanded;
+    expanded.reserve(line.size() + 4);
+    int columns = 0;
+    int k = 0;
+    for(; k < line.size() && columns < count; ++k)
+    {
+        if(line.at(k) == '\t')
+        {
+            expanded += QString(4 - columns % 4, ' ');
+            columns += 4 - columns % 4;
+        }
+        else
+        {
+            expanded += line.at(k);
+            ++columns;
+        }
+    }
+    return expanded + line.mid(k);
+}
+
+bool HPEMarkdownRenderer::isPunctuation(const QChar &c)
+{
+    return c.isPunct() || c.isSymbol();
+}
+
+bool HPEMarkdownRenderer::isBlank(const QString &line)
+{
+    for(const QChar& c : line)
+        if(!c.isSpace())
+            return false;
+    return true;
+}
+
+int HPEMarkdownRenderer::atxHeadingLevel(const QString &line)
+{
+    int level = 0;
+    while(level < line.size() && line.at(level) == '#')
+        ++level;
+    if(level == 0 || level > 6)
+        return 0;
+    if(level < line.size() && line.at(level) != ' ' && line.at(level) != '\t')
+        return 0;
+    return level;
+}
+
+bool HPEMarkdownRenderer::isThematicBreak(const QString &line)
+{
+    if(indentation(line) >= 4)
+        return false;
+    QChar marker;
+    int count = 0;
+    for(const QChar& c : line)
+    {
+        if(c == ' ' || c == '\t')
+            continue;
+        if(c != '*' && c != '-' && c != '_')
+            return false;
+        if(count > 0 && c != marker)
+            return false;
+        marker = c;
+        ++count;
+    }
+    return count >= 3;
+}
+
+QString HPEMarkdownRenderer::openingFence(const QString &line)
+{
+    if(!line.startsWith("```") && !line.startsWith("~~~"))
+        return QString();
+    int length = 3;
+    while(length < line.size() && line.at(length) == line.at(0))
+        ++length;
+    //the info string of backtick fences can't contain backticks
+    if(line.at(0) == '`' && line.indexOf('`', length) >= 0)
+        return QString();
+    return line.left(length);
+}
+
+bool HPEMarkdownRenderer::listItemStart(const QString &line, QChar *marker, int *start, int *contentOffset)
+{
+    int indent = indentation(line);
+    if(indent >= 4)
+        return false;
+    //so that the spaces after the marker are counted in columns of the line
+    QString text = expandTabs(line, line.size() * 4).mid(indent);
+    if(text.isEmpty() || isThematicBreak(text))
+        return false;
+
+    int markerLength = 0;
+    QChar markerChar;
+    int number = -1;
+    if(text.at(0) == '-' || text.at(0) == '+' || text.at(0) == '*')
+    {
+        markerChar = text.at(0);
+        markerLength = 1;
+    }
+    else
+    {
+        int digits = 0;
+        while(digits < text.size() && digits < 9 && text.at(digits).isDigit())
+            ++digits;
+        if(digits == 0 || digits >= text.size() || (text.at(digits) != '.' && text.at(digits) != ')'))
+            return false;
+        markerChar = text.at(digits);
+        number = text.left(digits).toInt();
+        markerLength = digits + 1;
+    }
+
+    //the marker should be followed by spaces or the end of line
+    if(markerLength < text.size() && text.at(markerLength) != ' ' && text.at(markerLength) != '\t')
+        return false;
+    int spaces = indentation(text.mid(markerLength));
+    if(spaces > 4 || markerLength + spaces >= text.size())
+        spaces = 1;
+
+    if(marker)
+        *marker = markerChar;
+    if(start)
+        *start = number;
+    if(contentOffset)
+        *contentOffset = indent + markerLength + spaces;
+    return true;
+}
+
+bool HPEMarkdownRenderer::isHtmlBlockStart(const QString &line)
+{
+    static const QStringList blockTags = {
+        "address", "article", "aside", "blockquote", "center", "details", "dialog", "div", "dl",
+        "fieldset", "figcaption", "figure", "footer", "form", "h1", "h2", "h3", "h4", "h5", "h6",
+        "header", "hr", "iframe", "li", "main", "nav", "ol", "p", "pre", "script", "section",
+        "style", "summary", "table", "tbody", "td", "th", "thead", "tr", "ul", "video", "audio"
+    };
+    if(!line.startsWith('<'))
+        return false;
+    if(line.startsWith("<!--"))
+        return true;
+    int k = line.startsWith("</") ? 2 : 1;
+    int nameStart = k;
+    while(k < line.size() && line.at(k).isLetterOrNumber())
+        ++k;
+    if(k == nameStart || (k < line.size() && line.at(k) != ' ' && line.at(k) != '>' && line.at(k) != '/'))
+        return false;
+    return blockTags.contains(line.mid(nameStart, k - nameStart).toLower());
+}
+
+bool HPEMarkdownRenderer::interruptsParagraph(const QString &line)
+{
+    int indent = indentation(line);
+    if(indent >= 4)
+        return false;
+    QString text = removeIndentation(line, indent);
+    int start;
+    return atxHeadingLevel(text) > 0 || isThematicBreak(text) || !openingFence(text).isEmpty()
+            || text.startsWith('>') || text.startsWith("$$") || isHtmlBlockStart(text)
+            //an ordered list can interrupt a paragraph only if it starts with 1
+            || (listItemStart(text, nullptr, &start) && (start < 0 || start == 1)
+                && !isBlank(text.mid(text.indexOf(' ') < 0 ? text.size() : text.indexOf(' '))));
+}
+
+QString HPEMarkdownRenderer::headingId(const QString &text)
+{
+    QString id;
+    id.reserve(text.size());
+    bool inTag = false;
+    for(const QChar& c : text.trimmed().toLower())
+    {
+        if(c == '<')
+            inTag = true;
+        else if(c == '>')
+            inTag = false;
+        else if(inTag)
+            continue;
+        else if(c.isSpace())
+            id += '-';
+        else if(c.unicode() < 128 && c.isPunct() && c != '-' && c != '_')
+            continue;
+        else if(c.unicode() >= 0x2000 && c.unicode() <= 0x206F)
+            continue;
+        else
+            id += c;
+    }
+    return id.toHtmlEscaped();
+}
+
+QStringList HPEMarkdownRenderer::splitTableRow(const QString &line)
+{
+    QString row = line.trimmed();
+    if(row.startsWith('|'))
+        row = row.mid(1);
+    if(row.endsWith('|') && !row.endsWith("\\|"))
+        row.chop(1);
+
+    QStringList cells;
+    QString cell;
+    bool inCode = false;
+    for(int k = 0; k < row.size(); ++k)
+    {
+        QChar c = row.at(k);
+        if(c == '\\' && k + 1 < row.size() && row.at(k + 1) == '|')
+        {
+            cell += '|';
+            ++k;
+        }
+        else if(c == '`')
+        {
+            inCode = !inCode;
+            cell += c;
+        }
+        else if(c == '|' && !inCode)
+        {
+            cells.append(cell);
+            cell.clear();
+        }
+        else
+            cell += c;
+    }
+    cells.append(cell);
+    return cells;
+}
+
+bool HPEMarkdownRenderer::linkDefinition(const QString &line, QString *label, QString *destination, QString *title)
+{
+    int indent = indentation(line);
+    if(indent >= 4)
+        return false;
+    QString text = removeIndentation(line, indent);
+    if(!text.startsWith('['))
+        return false;
+
+    //the label can't contain unescaped brackets
+    int close = 1;
+    while(close < text.size() && text.at(close) != ']')
+    {
+        if(text.at(close) == '[')
+            return false;
+        if(text.at(close) == '\\')
+            ++close;
+        ++close;
+    }
+    if(close + 1 >= text.size() || text.at(close + 1) != ':' || isBlank(text.mid(1, close - 1)))
+        return false;
+
+    //the destination should be on the same line
+    int k = close + 2;
+    while(k < text.size() && text.at(k).isSpace())
+        ++k;
+    if(k >= text.size())
+        return false;
+    QString url;
+    if(text.at(k) == '<')
+    {
+        int end = text.indexOf('>', k + 1);
+        if(end < 0)
+            return false;
+        url = text.mid(k + 1, end - k - 1);
+        k = end + 1;
+    }
+    else
+    {
+        int begin = k;
+        while(k < text.size() && !text.at(k).isSpace())
+            ++k;
+        url = text.mid(begin, k - begin);
+    }
+
+    //an optional title separated by spaces, nothing else
+    QString rest = text.mid(k).trimmed();
+    QString titleText;
+    if(!rest.isEmpty())
+    {
+        QChar opening = rest.at(0);
+        QChar closing = opening == '(' ? QChar(')') : opening;
+        if(!text.at(k).isSpace() || (opening != '"' && opening != '\'' && opening != '(')
+                || rest.size() < 2 || !rest.endsWith(closing))
+            return false;
+        titleText = rest.mid(1, rest.size() - 2);
+    }
+
+    if(label)
+        *label = text.mid(1, close - 1);
+    if(destination)
+        *destination = url;
+    if(title)
+        *title = titleText;
+    return true;
+}
+
+QString HPEMarkdownRenderer::normalizedLabel(const QString &label)
+{
+    return label.simplified().toCaseFolded();
+}
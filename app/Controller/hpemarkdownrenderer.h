@@ -0,0 +1,332 @@
+/**
+ * @file hpemarkdownrenderer.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-12
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEMARKDOWNRENDERER_H
+#define HPEMARKDOWNRENDERER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+/**
+ * @class HPEMarkdownRenderer
+ * @brief A native Markdown (CommonMark & GFM) to HTML renderer
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPEMarkdownRenderer converts Markdown texts to HTML in C++,
+ * so that the web page (app/resources/index.html) does not need to parse Markdown by marked.js.
+ * 
+ * @par Block parsing
+ * 
+ * The lines are scanned once from top to bottom. Every time a block is closed,
+ * its HTML is appended to the output immediately. Containers (block quotes and list items)
+ * are parsed recursively with their markers stripped.
+ * 
+ * Supported blocks: ATX and setext headings, thematic breaks, fenced and indented codes,
+ * block quotes, (task) lists, GFM tables, HTML blocks, math blocks ($$) and paragraphs.
+ * 
+ * @par Inline parsing
+ * 
+ * Emphasis, strong emphasis and strikethrough are matched with a delimiter stack, like CommonMark:
+ * every run of '*', '_' or '~~' is kept as a delimiter with whether it can open or close,
+ * and processEmphasis() pairs the closers with the nearest openers when the text is done,
+ * so "*a **b** c*" nests correctly. Inline math ($...$) follows the rules of Pandoc.
+ * 
+ * Supported inlines: backslash escapes, code spans, emphasis, strong emphasis, strikethrough,
+ * links, images, reference links, autolinks, raw HTML, entities and hard line breaks.
+ * The link reference definitions ([label]: url "title") are collected before the blocks are parsed,
+ * so a link may come before its definition.
+ * Math ($...$ and $$...$$) is kept as it is (HTML escaped) for KaTeX.
+ * 
+ * @par Output
+ * 
+ * The output follows marked.js with its options in index.html, for example,
+ * fenced codes are rendered as <pre><code class="hljs language-xxx"> for highlight.js.
+ * 
+ * @par Line anchors
+ * 
+ * If setLineAnchors() is enabled, every top-level element gets the line it starts at
+ * as a data-line attribute, for example <p data-line="3">, so the web page can map lines
+ * to positions inside a preview block (see HPEDocument::scrollToLine()).
+ * 
+ * @par Image paths
+ * 
+ * The source of every image is passed to the resolver set by setImageResolver()
+ * (HPEConvertedMarkdownPreview converts Hexo's assets folder paths to local URLs with it).
+ * 
+ * @note Visit https://spec.commonmark.org and https://github.github.com/gfm for more info
+*/
+class HPEMarkdownRenderer
+{
+public:
+
+    /**
+     * @brief A function converting a path (or URL) to the URL used in HTML
+     * 
+    */
+    typedef std::function<QString(const QString&)> UrlResolver;
+
+    /**
+     * @brief Construct an HPEMarkdownRenderer
+     * 
+    */
+    HPEMarkdownRenderer() = default;
+
+    /**
+     * @brief Set the resolver used to convert images' sources
+     * 
+     * @param[in] resolver
+    */
+    void setImageResolver(const UrlResolver& resolver);
+
+    /**
+     * @brief Set whether top-level elements carry the lines they start at (data-line), false by default
+     * 
+     * @param[in] enabled
+    */
+    void setLineAnchors(bool enabled);
+
+    /**
+     * @brief Render Markdown text to HTML
+     * 
+     * @param[in] markdown
+     * @return HTML
+    */
+    QString render(const QString& markdown) const;
+
+    /**
+     * @brief Render Markdown lines to HTML
+     * 
+     * @param[in] lines
+     * @return HTML
+    */
+    QString render(const QStringList& lines) const;
+
+private:
+
+    /**
+     * @brief Used to resolve images' sources
+     * 
+    */
+    UrlResolver m_imageResolver;
+
+    /**
+     * @brief If top-level elements carry data-line
+     * 
+    */
+    bool m_lineAnchors = false;
+
+    struct LinkDefinition
+    {
+        QString destination;
+        QString title;
+    };
+
+    /**
+     * @brief The link reference definitions of the text being rendered, by normalized label.
+     * Collected by render().
+     * 
+    */
+    mutable QHash<QString, LinkDefinition> m_definitions;
+
+    /**
+     * @brief Collect the link reference definitions of lines into m_definitions,
+     * the first definition of a label wins
+     * 
+    */
+    void collectDefinitions(const QStringList& lines) const;
+
+    /**
+     * @brief Parse the lines of a container and append HTML to html.
+     * If tight is true, paragraphs are rendered without <p> (tight list items).
+     * If anchors is true, the first tag of each block gets its line as data-line.
+     * 
+    */
+    void renderBlocks(const QStringList& lines, QString& html, bool tight = false, bool anchors = false) const;
+
+    /**
+     * @brief Add data-line="line" to the tag starting at html[start], if there is one
+     * 
+    */
+    static void addLineAnchor(QString& html, int start, int line);
+
+    /**
+     * @brief Parse and render a list starting at lines[i].
+     * After return, i is the line after the list.
+     * 
+    */
+    void renderList(const QStringList& lines, int& i, QString& html) const;
+
+    /**
+     * @brief Parse and render a GFM table starting at lines[i] if there is one.
+     * After return, i is the line after the table.
+     * 
+     * @return false if lines[i] doesn't start a table
+    */
+    bool renderTable(const QStringList& lines, int& i, QString& html) const;
+
+    /**
+     * @brief Render inlines of text
+     * 
+    */
+    QString renderInlines(const QString& text) const;
+
+    /**
+     * @brief Try to parse a link or an image at text[pos] ('[' or '!').
+     * 
+     * @param[in] text
+     * @param[in, out] pos Moved after the link if succeeded
+     * @param[out] html
+     * @return true if succeeded
+    */
+    bool parseLink(const QString& text, int& pos, QString& html) const;
+
+    /**
+     * @brief Append the HTML of a link, or an image if isImage is true, to html
+     * 
+    */
+    void renderLink(const QString& label, const QString& destination, const QString& title,
+                    bool isImage, QString& html) const;
+
+    /**
+     * @brief A run of '*', '_' or '~' met by renderInlines()
+     * 
+    */
+    struct Delimiter
+    {
+        int   piece;            ///< the index of the piece of HTML it takes
+        QChar c;
+        int   length;           ///< the length of the run
+        int   count;            ///< the delimiters not paired yet, left as text
+        bool  canOpen;
+        bool  canClose;
+        QString closingTags;    ///< before the delimiters left
+        QString openingTags;    ///< after the delimiters left
+    };
+
+    /**
+     * @brief Pair the delimiters into emphasis, strong emphasis and strikethrough,
+     * filling in their tags (the "process emphasis" procedure of CommonMark)
+     * 
+    */
+    static void processEmphasis(QList<Delimiter>& delimiters);
+
+public:
+
+    /**
+     * @brief Returns the number of leading spaces of line (a tab counts as 4 spaces)
+     * 
+    */
+    static int indentation(const QString& line);
+
+    /**
+     * @brief Remove up to count columns of leading spaces from line
+     * 
+    */
+    static QString removeIndentation(const QString& line, int count);
+
+    /**
+     * @brief Replace the tabs in the first count columns of line with spaces (tab stops of 4)
+     * 
+    */
+    static QString expandTabs(const QString& line, int count);
+
+    /**
+     * @brief Returns whether c is a punctuation or a symbol, for the flanking rules of emphasis
+     * 
+    */
+    static bool isPunctuation(const QChar& c);
+
+    /**
+     * @brief Returns whether line is blank
+     * 
+    */
+    static bool isBlank(const QString& line);
+
+    /**
+     * @brief Returns the heading level (1~6) of an ATX heading line, 0 if it isn't
+     * 
+    */
+    static int atxHeadingLevel(const QString& line);
+
+    /**
+     * @brief Returns whether line is a thematic break (***, ---, ___)
+     * 
+    */
+    static bool isThematicBreak(const QString& line);
+
+    /**
+     * @brief Returns the fence (``` or ~~~ with its length) opened by line, empty if it isn't
+     * 
+    */
+    static QString openingFence(const QString& line);
+
+    /**
+     * @brief Check whether line starts a list item.
+     * 
+     * @param[in] line
+     * @param[out] marker The bullet char or the delimiter of ordered list ('.' or ')')
+     * @param[out] start The start number of ordered list, -1 for bullet list
+     * @param[out] contentOffset The column where the content of item starts
+     * @return true if line starts a list item
+    */
+    static bool listItemStart(const QString& line, QChar* marker = nullptr, int* start = nullptr, int* contentOffset = nullptr);
+
+    /**
+     * @brief Returns whether line starts an HTML block
+     * 
+    */
+    static bool isHtmlBlockStart(const QString& line);
+
+    /**
+     * @brief Returns whether line can interrupt a paragraph
+     * 
+    */
+    static bool interruptsParagraph(const QString& line);
+
+    /**
+     * @brief Returns the id of a heading (the same as marked.js)
+     * 
+    */
+    static QString headingId(const QString& text);
+
+    /**
+     * @brief Split a table row into cells
+     * 
+    */
+    static QStringList splitTableRow(const QString& line);
+
+    /**
+     * @brief Check whether line is a link reference definition ([label]: destination "title")
+     * 
+     * @param[in] line
+     * @param[out] label
+     * @param[out] destination
+     * @param[out] title
+     * @return true if line is a link reference definition
+    */
+    static bool linkDefinition(const QString& line, QString* label = nullptr,
+                               QString* destination = nullptr, QString* title = nullptr);
+
+    /**
+     * @brief Returns the label of a reference link normalized for matching (case folded, spaces collapsed)
+     * 
+    */
+    static QString normalizedLabel(const QString& label);
+};
+
+#endif // HPEMARKDOWNRENDERER_H
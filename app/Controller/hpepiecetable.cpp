@@ -0,0 +1,330 @@
+/**
+ * @file hpepiecetable.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpepiecetable.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Returns the position after the count-th '\n' of data, data must have count '\n'
+ * 
+*/
+static qint64 skipLineBreaks(const char* data, qint64 size, qint64 count)
+{
+    qint64 position = 0;
+    for(; count > 0; --count)
+        position = static_cast<const char*>(std::memchr(data + position, '\n', size - position)) - data + 1;
+    return position;
+}
+
+HPEPieceTable::HPEPieceTable()
+{
+    m_checkpoints.append(0);
+}
+
+bool HPEPieceTable::open(const QString &filePath)
+{
+    closeOriginal();
+    m_file.setFileName(filePath);
+    m_added.clear();
+    m_pieces.clear();
+    m_checkpoints = { 0 };
+    m_lineBreak = "\n";
+    m_size = m_lineBreaks = 0;
+    m_modified = false;
+    if(!mapOriginal())
+        return false;
+
+    //record the line starts, the pages are read once and not kept
+    const char* end = m_original + m_originalSize;
+    for(const char* p = m_original; p < end; ++p)
+    {
+        p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if(!p)
+            break;
+        if(m_lineBreaks == 0 && p > m_original && p[-1] == '\r')
+            m_lineBreak = "\r\n";
+        if(++m_lineBreaks % LINE_CHECKPOINT == 0)
+            m_checkpoints.append(p + 1 - m_original);
+    }
+
+    m_size = m_originalSize;
+    if(m_originalSize > 0)
+        m_pieces.append({ Original, 0, m_originalSize, m_lineBreaks });
+    return true;
+}
+
+bool HPEPieceTable::save(const QString &filePath)
+{
+    QSaveFile saved(filePath);
+    if(!saved.open(QIODevice::WriteOnly))
+    {
+        m_errorString = saved.errorString();
+        return false;
+    }
+    for(const Piece& piece : qAsConst(m_pieces))
+        saved.write(dataOf(piece), piece.length);
+
+    //a mapped file cannot be replaced on Windows
+    bool replacing = m_file.isOpen() && QFileInfo(filePath) == QFileInfo(m_file);
+    if(replacing)
+        closeOriginal();
+    if(!saved.commit())
+    {
+        m_errorString = saved.errorString();
+        if(replacing)
+            mapOriginal();
+        return false;
+    }
+    return open(filePath);
+}
+
+QString HPEPieceTable::errorString() const
+{
+    return m_errorString;
+}
+
+bool HPEPieceTable::isModified() const
+{
+    return m_modified;
+}
+
+qint64 HPEPieceTable::size() const
+{
+    return m_size;
+}
+
+qint64 HPEPieceTable::lineCount() const
+{
+    return m_lineBreaks + 1;
+}
+
+QByteArray HPEPieceTable::lineBreak() const
+{
+    return m_lineBreak;
+}
+
+QString HPEPieceTable::lines(qint64 first, qint64 count) const
+{
+    if(first < 0 || count <= 0 || first >= lineCount())
+        return QString();
+
+    qint64 last = qMin(first + count, lineCount()) - 1;
+    QByteArray text = bytes(offsetOfLine(first), endOfLine(last));
+    text.replace("\r\n", "\n");
+    if(last < m_lineBreaks && text.endsWith('\r'))
+        text.chop(1);
+    return QString::fromUtf8(text);
+}
+
+void HPEPieceTable::replaceLines(qint64 first, qint64 count, const QString &text)
+{
+    first = qBound(qint64(0), first, lineCount() - 1);
+    qint64 last = qMin(first + count, lineCount()) - 1;
+    qint64 from = offsetOfLine(first);
+    qint64 to = count > 0 ? endOfLine(last) : from;
+    //the '\r' of the "\r\n" after the lines stays with its '\n'
+    if(to > from && last < m_lineBreaks && bytes(to - 1, to) == "\r")
+        --to;
+
+    QByteArray replacement = text.toUtf8();
+    if(m_lineBreak != "\n")
+        replacement.replace("\n", m_lineBreak);
+    replace(from, to, replacement);
+}
+
+bool HPEPieceTable::mapOriginal()
+{
+    if(!m_file.open(QIODevice::ReadOnly))
+    {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_originalSize = m_file.size();
+    if(m_originalSize > 0)
+    {
+        m_original = reinterpret_cast<const char*>(m_file.map(0, m_originalSize));
+        if(!m_original)
+        {
+            m_errorString = m_file.errorString();
+            m_file.close();
+            m_originalSize = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+void HPEPieceTable::closeOriginal()
+{
+    if(m_original)
+        m_file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_original)));
+    m_original = nullptr;
+    m_file.close();
+}
+
+const char *HPEPieceTable::dataOf(const Piece &piece) const
+{
+    return (piece.source == Original ? m_original : m_added.constData()) + piece.start;
+}
+
+HPEPieceTable::Piece HPEPieceTable::slice(const Piece &piece, qint64 from, qint64 to) const
+{
+    Piece sliced = { piece.source, piece.start + from, to - from, 0 };
+    if(piece.source == Original)
+        sliced.lineBreaks = originalLineBreaksBefore(sliced.start + sliced.length) - originalLineBreaksBefore(sliced.start);
+    else
+        sliced.lineBreaks = std::count(dataOf(sliced), dataOf(sliced) + sliced.length, '\n');
+    return sliced;
+}
+
+qint64 HPEPieceTable::offsetOfLine(qint64 line) const
+{
+    if(line <= 0)
+        return 0;
+    if(line > m_lineBreaks)
+        return m_size;
+
+    qint64 position = 0;
+    qint64 lineBreaks = 0;
+    for(const Piece& piece : m_pieces)
+    {
+        if(lineBreaks + piece.lineBreaks >= line)
+        {
+            //the line break before line is in this piece
+            qint64 count = line - lineBreaks;
+            if(piece.source == Original)
+                return position + originalOffsetOfLine(originalLineBreaksBefore(piece.start) + count) - piece.start;
+            return position + skipLineBreaks(dataOf(piece), piece.length, count);
+        }
+        lineBreaks += piece.lineBreaks;
+        position += piece.length;
+    }
+    return m_size;
+}
+
+qint64 HPEPieceTable::endOfLine(qint64 line) const
+{
+    return line >= m_lineBreaks ? m_size : offsetOfLine(line + 1) - 1;
+}
+
+QByteArray HPEPieceTable::bytes(qint64 from, qint64 to) const
+{
+    QByteArray result;
+    result.reserve(to - from);
+    qint64 position = 0;
+    for(const Piece& piece : m_pieces)
+    {
+        qint64 end = position + piece.length;
+        if(end > from && position < to)
+        {
+            qint64 start = qMax(from, position);
+            result.append(dataOf(piece) + start - position, qMin(to, end) - start);
+        }
+        if(end >= to)
+            break;
+        position = end;
+    }
+    return result;
+}
+
+void HPEPieceTable::replace(qint64 from, qint64 to, const QByteArray &bytes)
+{
+    Piece added = { Added, m_added.size(), bytes.size(), bytes.count('\n') };
+    m_added.append(bytes);
+
+    QVector<Piece> pieces;
+    pieces.reserve(m_pieces.size() + 2);
+    bool inserted = false;
+    auto insert = [&]{
+        if(!inserted && added.length > 0)
+            pieces.append(added);
+        inserted = true;
+    };
+
+    qint64 position = 0;
+    for(const Piece& piece : qAsConst(m_pieces))
+    {
+        qint64 end = position + piece.length;
+        if(end <= from)
+            pieces.append(piece);
+        else if(position >= to)
+        {
+            insert();
+            pieces.append(piece);
+        }
+        else
+        {
+            //the piece overlaps [from, to), keep its head and tail
+            if(position < from)
+                pieces.append(slice(piece, 0, from - position));
+            insert();
+            if(end > to)
+                pieces.append(slice(piece, to - position, piece.length));
+        }
+        position = end;
+    }
+    insert();
+
+    m_pieces = pieces;
+    m_size = m_lineBreaks = 0;
+    qint64 addedSize = 0;
+    for(const Piece& piece : qAsConst(m_pieces))
+    {
+        m_size += piece.length;
+        m_lineBreaks += piece.lineBreaks;
+        if(piece.source == Added)
+            addedSize += piece.length;
+    }
+    m_modified = true;
+
+    //every move of the editor's window appends the whole window
+    qint64 replacedSize = m_added.size() - addedSize;
+    if(replacedSize > addedSize && replacedSize >= MIN_COMPACTED_SIZE)
+        compactAdded();
+}
+
+void HPEPieceTable::compactAdded()
+{
+    QByteArray added;
+    for(const Piece& piece : qAsConst(m_pieces))
+        if(piece.source == Added)
+            added.append(dataOf(piece), piece.length);
+
+    qint64 start = 0;
+    for(Piece& piece : m_pieces)
+        if(piece.source == Added)
+        {
+            piece.start = start;
+            start += piece.length;
+        }
+    m_added = added;
+}
+
+qint64 HPEPieceTable::originalLineBreaksBefore(qint64 offset) const
+{
+    //the last recorded line start not after offset
+    qint64 i = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), offset) - m_checkpoints.cbegin() - 1;
+    qint64 start = m_checkpoints.at(i);
+    return i * LINE_CHECKPOINT + std::count(m_original + start, m_original + offset, '\n');
+}
+
+qint64 HPEPieceTable::originalOffsetOfLine(qint64 line) const
+{
+    qint64 start = m_checkpoints.at(line / LINE_CHECKPOINT);
+    return start + skipLineBreaks(m_original + start, m_originalSize - start, line % LINE_CHECKPOINT);
+}
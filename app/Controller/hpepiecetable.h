@@ -0,0 +1,235 @@
+/**
+ * @file hpepiecetable.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEPIECETABLE_H
+#define HPEPIECETABLE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class HPEPieceTable
+ * @brief The text of a large file, memory-mapped and edited by a piece table
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPEPieceTable keeps a file of any size without reading it: the file is mapped into memory
+ * as the original buffer, and the edits are appended to the added buffer.
+ * The text is the sequence of pieces, each of which is a span of one of the two buffers.
+ * 
+ * @par Lines
+ * 
+ * HPEPieceTable is read and edited by lines, like the blocks of QTextDocument:
+ * a file of n line breaks has n + 1 lines.
+ * When the file is opened, the start of every LINE_CHECKPOINT-th line of the original buffer
+ * is recorded, so finding a line scans at most LINE_CHECKPOINT lines, and the pages of
+ * the mapped file not shown are left to the system to drop.
+ * 
+ * @code
+ *      HPEPieceTable table;
+ *      if(table.open(path))
+ *      {
+ *          QString text = table.lines(1000, 50);           //lines [1000, 1050)
+ *          table.replaceLines(1000, 50, text.toUpper());
+ *          table.save(path);
+ *      }
+ * @endcode
+ * 
+ * @par Line breaks
+ * 
+ * The line break of the file, "\r\n" or "\n", is taken from its first line when it is opened.
+ * "\r\n" is read as "\n", and the line breaks of the replacing text are written as the one of the file,
+ * so saving doesn't mix them. The lines not replaced keep their own line breaks.
+ * 
+ * @note The text is UTF-8.
+*/
+class HPEPieceTable
+{
+public:
+
+    /**
+     * @brief Construct an empty HPEPieceTable
+     * 
+    */
+    HPEPieceTable();
+
+    /**
+     * @brief Map the file at filePath as the text, the edits are dropped
+     * 
+     * @return false if the file cannot be opened, see errorString()
+    */
+    bool open(const QString& filePath);
+
+    /**
+     * @brief Write the text to the file at filePath and open it, so the added buffer is emptied.
+     * The file is replaced only if the whole text is written.
+     * 
+     * @return false if the file cannot be written, see errorString()
+    */
+    bool save(const QString& filePath);
+
+    /**
+     * @brief Returns the error of the last open() or save()
+     * 
+    */
+    QString errorString() const;
+
+    /**
+     * @brief Returns whether the text is edited since it is opened
+     * 
+    */
+    bool isModified() const;
+
+    /**
+     * @brief Returns the size of the text in bytes
+     * 
+    */
+    qint64 size() const;
+
+    /**
+     * @brief Returns the number of lines, at least 1
+     * 
+    */
+    qint64 lineCount() const;
+
+    /**
+     * @brief Returns the line break written by replaceLines(), "\r\n" or "\n"
+     * 
+    */
+    QByteArray lineBreak() const;
+
+    /**
+     * @brief Returns the lines [first, first + count) joined by '\n'
+     * 
+    */
+    QString lines(qint64 first, qint64 count) const;
+
+    /**
+     * @brief Replace the lines [first, first + count) with text, which may have any number of lines
+     * 
+    */
+    void replaceLines(qint64 first, qint64 count, const QString& text);
+
+private:
+
+    enum Source
+    {
+        Original,
+        Added
+    };
+
+    struct Piece
+    {
+        Source source;
+        qint64 start;
+        qint64 length;
+        qint64 lineBreaks;
+    };
+
+    /**
+     * @brief Map m_file, the pieces are kept
+     * 
+    */
+    bool mapOriginal();
+
+    /**
+     * @brief Unmap and close m_file
+     * 
+    */
+    void closeOriginal();
+
+    const char* dataOf(const Piece& piece) const;
+
+    /**
+     * @brief Returns the piece [from, to) of piece
+     * 
+    */
+    Piece slice(const Piece& piece, qint64 from, qint64 to) const;
+
+    /**
+     * @brief Returns the offset where line starts, size() if line >= lineCount()
+     * 
+    */
+    qint64 offsetOfLine(qint64 line) const;
+
+    /**
+     * @brief Returns the offset where line ends (the line break excluded)
+     * 
+    */
+    qint64 endOfLine(qint64 line) const;
+
+    /**
+     * @brief Returns the bytes [from, to) of the text
+     * 
+    */
+    QByteArray bytes(qint64 from, qint64 to) const;
+
+    /**
+     * @brief Replace the bytes [from, to) of the text with bytes
+     * 
+    */
+    void replace(qint64 from, qint64 to, const QByteArray& bytes);
+
+    /**
+     * @brief Copy the spans of the added buffer still in the pieces to a new one,
+     * dropping the text the edits replaced
+     * 
+    */
+    void compactAdded();
+
+    /**
+     * @brief Returns the number of line breaks in the original buffer before offset
+     * 
+    */
+    qint64 originalLineBreaksBefore(qint64 offset) const;
+
+    /**
+     * @brief Returns the offset where line of the original buffer starts
+     * 
+    */
+    qint64 originalOffsetOfLine(qint64 line) const;
+
+    /**
+     * @brief The distance (lines) between the recorded line starts of the original buffer
+     * 
+    */
+    static constexpr qint64 LINE_CHECKPOINT = 1024;
+
+    /**
+     * @brief The added buffer is compacted when more than half of it, and at least this many bytes, is replaced text
+     * 
+    */
+    static constexpr qint64 MIN_COMPACTED_SIZE = 1024 * 1024;
+
+    QFile m_file;
+    const char* m_original = nullptr;
+    qint64 m_originalSize  = 0;
+
+    /**
+     * @brief The start of every LINE_CHECKPOINT-th line of the original buffer
+     * 
+    */
+    QVector<qint64> m_checkpoints;
+
+    QByteArray m_added;
+    QVector<Piece> m_pieces;
+    QByteArray m_lineBreak = "\n";
+
+    qint64 m_size       = 0;
+    qint64 m_lineBreaks = 0;
+    bool m_modified     = false;
+    QString m_errorString;
+};
+
+#endif // HPEPIECETABLE_H
@@ -0,0 +1,183 @@
+/**
+ * @file hpepreviewscheduler.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-14
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpepreviewscheduler.h"
+
+#include "hpedocument.h"
+
+HPEPreviewScheduler::HPEPreviewScheduler(HPEDocument *document, QObject *parent)
+    : QObject{parent}, m_document(document)
+{
+    m_document->setAutoPublish(false);
+
+    m_debounceTimer.setSingleShot(true);
+    m_acknowledgeTimer.setSingleShot(true);
+    m_acknowledgeTimer.setInterval(ACKNOWLEDGE_TIMEOUT);
+
+    connect(m_document, &HPEDocument::acknowledged, this, &HPEPreviewScheduler::onAcknowledged);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &HPEPreviewScheduler::tryPublish);
+    connect(&m_acknowledgeTimer, &QTimer::timeout, this, &HPEPreviewScheduler::onAcknowledgeTimeout);
+}
+
+int HPEPreviewScheduler::interval() const
+{
+    return m_interval;
+}
+
+double HPEPreviewScheduler::averageCost() const
+{
+    return m_averageCost;
+}
+
+void HPEPreviewScheduler::setText(const QString &text)
+{
+    //the edits before are replaced
+    m_hasPendingChange = false;
+    m_changeLines.clear();
+    m_hasPendingText = true;
+    m_pendingLines = text.split('\n');
+    schedule();
+}
+
+void HPEPreviewScheduler::applyChange(int from, int to, const QStringList &lines)
+{
+    if(m_hasPendingText)
+    {
+        if(from < 0 || to < from || to > m_pendingLines.size())
+            return;
+        replaceLines(m_pendingLines, from, to, lines);
+        schedule();
+        return;
+    }
+
+    //an edit apart from the pending one can't be merged, apply the pending one first
+    int changeEnd = m_changeFrom + m_changeLines.size();
+    if(m_hasPendingChange && (from > changeEnd || to < m_changeFrom))
+        flush();
+    if(!m_hasPendingChange)
+    {
+        m_hasPendingChange = true;
+        m_changeFrom  = from;
+        m_changeTo    = to;
+        m_changeLines = lines;
+        schedule();
+        return;
+    }
+
+    //the lines [first, last) after the pending edit, with the lines of the document around it
+    int first = qMin(from, m_changeFrom);
+    int last  = qMax(to, changeEnd);
+    QStringList merged = m_document->lines(first, m_changeFrom);
+    merged.append(m_changeLines);
+    merged.append(m_document->lines(m_changeTo, m_changeTo + last - changeEnd));
+    replaceLines(merged, from - first, to - first, lines);
+
+    m_changeTo   += last - changeEnd;
+    m_changeFrom  = first;
+    m_changeLines = merged;
+    schedule();
+}
+
+void HPEPreviewScheduler::onAcknowledged(int version, double renderTime)
+{
+    //-1 acknowledges the whole text, which is always the latest one
+    if(m_inFlightVersion < 0 || (version >= 0 && version < m_inFlightVersion))
+        return;
+
+    m_acknowledgeTimer.stop();
+    m_inFlightVersion = -1;
+
+    double cost = m_publishTime + renderTime;
+    m_averageCost = m_averageCost > 0 ? m_averageCost + SMOOTHING_FACTOR * (cost - m_averageCost) : cost;
+    m_interval = qBound(MIN_INTERVAL, qRound(m_averageCost * 1.5), MAX_INTERVAL);
+
+    //the edits made during rendering are published at once if they have waited long enough
+    if(hasPendingChanges()
+            && (!m_debounceTimer.isActive() || m_pendingAge.elapsed() >= MAX_LATENCY))
+    {
+        m_debounceTimer.stop();
+        tryPublish();
+    }
+}
+
+void HPEPreviewScheduler::schedule()
+{
+    if(!m_pendingAge.isValid())
+        m_pendingAge.start();
+
+    //keep waiting while typing, but not longer than MAX_LATENCY
+    qint64 remaining = MAX_LATENCY - m_pendingAge.elapsed();
+    if(remaining <= 0)
+    {
+        m_debounceTimer.stop();
+        tryPublish();
+    }
+    else
+        m_debounceTimer.start(qMin<qint64>(m_interval, remaining));
+}
+
+bool HPEPreviewScheduler::hasPendingChanges() const
+{
+    return m_hasPendingText || m_hasPendingChange || m_document->hasPendingChanges();
+}
+
+void HPEPreviewScheduler::flush()
+{
+    if(m_hasPendingText)
+    {
+        m_hasPendingText = false;
+        m_document->setText(m_pendingLines.join('\n'));
+        m_pendingLines.clear();
+    }
+    else if(m_hasPendingChange)
+    {
+        m_hasPendingChange = false;
+        m_document->applyChange(m_changeFrom, m_changeTo, m_changeLines);
+        m_changeLines.clear();
+    }
+}
+
+void HPEPreviewScheduler::tryPublish()
+{
+    //the latest changes will be published after the version in flight is acknowledged
+    if(m_inFlightVersion >= 0 || !hasPendingChanges())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    flush();
+    m_pendingAge.invalidate();
+    if(!m_document->hasPendingChanges())
+        return;
+    m_document->publish();
+    m_publishTime = timer.nsecsElapsed() / 1e6;
+
+    m_inFlightVersion = m_document->publishedVersion();
+    m_acknowledgeTimer.start();
+}
+
+void HPEPreviewScheduler::replaceLines(QStringList &target, int from, int to, const QStringList &lines)
+{
+    int diff = lines.size() - (to - from);
+    if(diff > 0)
+        target.insert(from, diff, QString());
+    else if(diff < 0)
+        target.remove(from, -diff);
+    for(int i = 0; i < lines.size(); ++i)
+        target[from + i] = lines.at(i);
+}
+
+void HPEPreviewScheduler::onAcknowledgeTimeout()
+{
+    m_inFlightVersion = -1;
+    tryPublish();
+}
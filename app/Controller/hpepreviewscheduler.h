@@ -0,0 +1,213 @@
+/**
+ * @file hpepreviewscheduler.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-14
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEPREVIEWSCHEDULER_H
+#define HPEPREVIEWSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringList>
+
+class HPEDocument;
+
+/**
+ * @class HPEPreviewScheduler
+ * @brief An HPEPreviewScheduler decides when the converted changes reach an HPEDocument and the web page
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * HPEPreviewScheduler stands between the converted Markdown (HPEConvertedMarkdownPreview) and
+ * an HPEDocument: setText() and applyChange() are only recorded, and the document is changed
+ * and published when the scheduler decides. It
+ * - coalesces a burst of edits before they reach the document: an edit touching the lines of
+ *   the pending one is merged into it, so the document re-splits the blocks once per burst.
+ *   The pending edit is applied first when an edit elsewhere comes;
+ * - waits for the debounce interval after the last edit,
+ *   but never longer than the max latency after the first unpublished one;
+ * - keeps at most one version in flight: while the web page hasn't acknowledged the last version,
+ *   new edits keep being merged, and the latest state is published after
+ *   the acknowledgement, so intermediate versions are dropped (latest wins);
+ * - adapts the debounce interval to the measured cost, that is, the time spent by the document
+ *   (block splitting and native rendering) plus the render time reported by the page,
+ *   smoothed by an exponential moving average.
+ * 
+ * If the page doesn't acknowledge in time (for example, it is still loading),
+ * the version in flight is given up.
+ * 
+ * @see HPEDocument::applyChange(), HPEDocument::publish(), HPEDocument::acknowledge()
+*/
+class HPEPreviewScheduler : public QObject
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct an HPEPreviewScheduler for document with parent
+     * 
+     * @param[in] document
+     * @param[in] parent
+    */
+    explicit HPEPreviewScheduler(HPEDocument* document, QObject *parent = nullptr);
+
+    /**
+     * @brief Returns the current debounce interval (ms)
+     * 
+    */
+    int interval() const;
+
+    /**
+     * @brief Returns the smoothed cost (ms) of publishing and rendering a version
+     * 
+    */
+    double averageCost() const;
+
+public slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Replace the whole text of the document later
+     * 
+     * @see HPEDocument::setText()
+    */
+    void setText(const QString& text);
+
+    /**
+     * @brief Replace the lines [from, to) of the document with lines later
+     * 
+     * @see HPEDocument::applyChange()
+    */
+    void applyChange(int from, int to, const QStringList& lines);
+
+    /**
+     * @brief Called when the web page acknowledges a rendered version
+     * 
+     * @param[in] version
+     * @param[in] renderTime
+    */
+    void onAcknowledged(int version, double renderTime);
+/**
+ * @}
+*/
+
+private:
+
+    /**
+     * @brief Called after an edit is recorded, (re)start the debounce timer
+     * 
+    */
+    void schedule();
+
+    /**
+     * @brief Returns whether there are edits not applied to the document or not published
+     * 
+    */
+    bool hasPendingChanges() const;
+
+    /**
+     * @brief Apply the pending text or edit to the document, without publishing
+     * 
+    */
+    void flush();
+
+    /**
+     * @brief Replace the lines [from, to) of target with lines
+     * 
+    */
+    static void replaceLines(QStringList& target, int from, int to, const QStringList& lines);
+
+    /**
+     * @brief Apply and publish the pending changes if the page is ready for a new version,
+     * otherwise wait for the acknowledgement
+     * 
+    */
+    void tryPublish();
+
+    /**
+     * @brief Give up waiting for the version in flight
+     * 
+    */
+    void onAcknowledgeTimeout();
+
+    HPEDocument* m_document = nullptr;
+
+    /**
+     * @brief The text set by setText() and edited since, if m_hasPendingText is true
+     * 
+    */
+    bool m_hasPendingText = false;
+    QStringList m_pendingLines;
+
+    /**
+     * @brief The merged edit not applied to the document yet, if m_hasPendingChange is true.
+     * It replaces the lines [m_changeFrom, m_changeTo) of the document with m_changeLines.
+     * 
+    */
+    bool m_hasPendingChange = false;
+    int  m_changeFrom = 0;
+    int  m_changeTo = 0;
+    QStringList m_changeLines;
+
+    /**
+     * @brief Fires when the edits calm down
+     * 
+    */
+    QTimer m_debounceTimer;
+
+    /**
+     * @brief The debounce interval (ms), adapted to m_averageCost
+     * 
+    */
+    int m_interval = MIN_INTERVAL * 2;
+
+    /**
+     * @brief Fires when the page doesn't acknowledge in time
+     * 
+    */
+    QTimer m_acknowledgeTimer;
+
+    /**
+     * @brief Measures the age of the first unpublished change
+     * 
+    */
+    QElapsedTimer m_pendingAge;
+
+    /**
+     * @brief The version in flight, -1 if none
+     * 
+    */
+    int m_inFlightVersion = -1;
+
+    /**
+     * @brief The time (ms) spent by the document on the version in flight
+     * 
+    */
+    double m_publishTime = 0;
+
+    /**
+     * @brief The smoothed cost (ms) of a version
+     * 
+    */
+    double m_averageCost = 0;
+
+    static constexpr int    MIN_INTERVAL        = 16;
+    static constexpr int    MAX_INTERVAL        = 400;
+    static constexpr int    MAX_LATENCY         = 800;
+    static constexpr int    ACKNOWLEDGE_TIMEOUT = 2000;
+    static constexpr double SMOOTHING_FACTOR    = 0.25;
+};
+
+#endif // HPEPREVIEWSCHEDULER_H
@@ -22,6 +22,9 @@ HPESettings::HPESettings()
     HPE_DEFAULT_SETTINGS[QString("window/sizeState")] = QString("MAXIMIZED");
     HPE_DEFAULT_SETTINGS[QString("window/previewWidth")] = 500;
     HPE_DEFAULT_SETTINGS[QString("basic/presetDir")] = QDir::homePath();
+    HPE_DEFAULT_SETTINGS[QString("preview/deltaUpdates")] = true;
+    HPE_DEFAULT_SETTINGS[QString("preview/renderer")] = QString("marked");  //"marked" or "native"
+    HPE_DEFAULT_SETTINGS[QString("preview/imageProxy")] = true;
 }
 
 HPESettings* HPESettings::config()
@@ -0,0 +1,200 @@
+/**
+ * @file hpetextsearcher.cpp
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpetextsearcher.h"
+
+#include <cstring>
+
+/**
+ * @brief Returns a word whose lane has its highest bit set if the lane of word equals c.
+ * The result is not zero if and only if any of the four UTF-16 lanes equals c.
+ * 
+ * @see HPELinkScanner
+*/
+static inline quint64 lanesEqual(quint64 word, char16_t c)
+{
+    const quint64 ones = Q_UINT64_C(0x0001000100010001);
+    quint64 x = word ^ (quint64(c) * ones);
+    return (x - ones) & ~x & Q_UINT64_C(0x8000800080008000);
+}
+
+HPETextSearcher::HPETextSearcher(const QString &pattern, Options options)
+    : m_pattern(pattern), m_options(options)
+{
+    if(!(m_options & RegularExpression))
+        return;
+
+    QRegularExpression::PatternOptions patternOptions = QRegularExpression::UseUnicodePropertiesOption;
+    if(!(m_options & CaseSensitive))
+        patternOptions |= QRegularExpression::CaseInsensitiveOption;
+    m_regex.setPattern(m_pattern);
+    m_regex.setPatternOptions(patternOptions);
+    m_regex.optimize();
+}
+
+bool HPETextSearcher::isValid() const
+{
+    return !m_pattern.isEmpty() && (!(m_options & RegularExpression) || m_regex.isValid());
+}
+
+QString HPETextSearcher::errorString() const
+{
+    return (m_options & RegularExpression) && !m_regex.isValid() ? m_regex.errorString() : QString();
+}
+
+QString HPETextSearcher::pattern() const
+{
+    return m_pattern;
+}
+
+HPETextSearcher::Options HPETextSearcher::options() const
+{
+    return m_options;
+}
+
+bool HPETextSearcher::find(QStringView text, qsizetype from, Match &match) const
+{
+    if(!isValid() || from < 0)
+        return false;
+
+    if(!(m_options & RegularExpression))
+    {
+        const Qt::CaseSensitivity cs = m_options & CaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        for(qsizetype pos = indexOf(text, from, m_pattern, cs); pos >= 0; pos = indexOf(text, pos + 1, m_pattern, cs))
+            if(isWholeWord(text, pos, m_pattern.size()))
+            {
+                match = { pos, m_pattern.size() };
+                return true;
+            }
+        return false;
+    }
+
+    for(qsizetype pos = from; pos <= text.size(); )
+    {
+        QRegularExpressionMatch result = m_regex.match(text, pos);
+        if(!result.hasMatch())
+            return false;
+        if(result.capturedLength() > 0 && isWholeWord(text, result.capturedStart(), result.capturedLength()))
+        {
+            match = { result.capturedStart(), result.capturedLength() };
+            return true;
+        }
+        //empty matches, like '^', and parts of words are skipped
+        pos = result.capturedStart() + 1;
+    }
+    return false;
+}
+
+bool HPETextSearcher::findLast(QStringView text, qsizetype before, Match &match) const
+{
+    bool found = false;
+    Match candidate;
+    for(qsizetype from = 0; find(text, from, candidate) && candidate.start < before; from = candidate.start + 1)
+    {
+        match = candidate;
+        found = true;
+    }
+    return found;
+}
+
+QVector<HPETextSearcher::Match> HPETextSearcher::findAll(QStringView text) const
+{
+    QVector<Match> matches;
+    Match match;
+    for(qsizetype from = 0; find(text, from, match); from = match.start + match.length)
+        matches.append(match);
+    return matches;
+}
+
+QString HPETextSearcher::replacement(QStringView text, const Match &match, const QString &replacement) const
+{
+    if(!(m_options & RegularExpression))
+        return replacement;
+
+    QRegularExpressionMatch result = m_regex.match(text, match.start, QRegularExpression::NormalMatch,
+                                                   QRegularExpression::AnchorAtOffsetMatchOption);
+    QString expanded;
+    expanded.reserve(replacement.size());
+    for(qsizetype i = 0; i < replacement.size(); ++i)
+    {
+        QChar c = replacement.at(i);
+        if(c != u'\\' || i + 1 == replacement.size())
+        {
+            expanded.append(c);
+            continue;
+        }
+        QChar next = replacement.at(++i);
+        if(next.isDigit() && next.digitValue() <= 9)
+            expanded.append(result.captured(next.digitValue()));
+        else if(next == u'\\')
+            expanded.append(next);
+        else
+            expanded.append(c).append(next);
+    }
+    return expanded;
+}
+
+qsizetype HPETextSearcher::indexOf(QStringView text, qsizetype from, QStringView needle, Qt::CaseSensitivity cs)
+{
+    const qsizetype size = text.size();
+    const qsizetype needleSize = needle.size();
+    if(from < 0 || needleSize == 0 || from + needleSize > size)
+        return -1;
+
+    //the code units that can start the needle
+    char16_t first = needle.utf16()[0];
+    char16_t lower = first, upper = first, other = first;
+    if(cs == Qt::CaseInsensitive)
+    {
+        //the cases of a non-ASCII character are too many to list
+        if(first >= 0x80)
+            return text.indexOf(needle, from, cs);
+        lower = char16_t(QChar::toLower(first));
+        upper = char16_t(QChar::toUpper(first));
+        //the Kelvin sign and the long s are folded to 'k' and 's'
+        other = lower == u'k' ? char16_t(0x212A) : lower == u's' ? char16_t(0x017F) : lower;
+    }
+
+    const char16_t* data = text.utf16();
+    const qsizetype last = size - needleSize;
+    for(qsizetype pos = from; pos <= last; ++pos)
+    {
+        //check four code units at a time until a word contains a candidate
+        for(; pos + 3 <= last; pos += 4)
+        {
+            quint64 word;
+            std::memcpy(&word, data + pos, sizeof(word));
+            if(lanesEqual(word, lower) | lanesEqual(word, upper) | lanesEqual(word, other))
+                break;
+        }
+        if(pos > last)
+            break;
+
+        char16_t c = data[pos];
+        if(c != lower && c != upper && c != other)
+            continue;
+        if(cs == Qt::CaseSensitive
+                ? std::memcmp(data + pos, needle.utf16(), needleSize * sizeof(char16_t)) == 0
+                : text.mid(pos, needleSize).compare(needle, Qt::CaseInsensitive) == 0)
+            return pos;
+    }
+    return -1;
+}
+
+bool HPETextSearcher::isWholeWord(QStringView text, qsizetype start, qsizetype length) const
+{
+    if(!(m_options & WholeWords))
+        return true;
+    //like QTextDocument::find()
+    return (start == 0 || !text.at(start - 1).isLetterOrNumber())
+            && (start + length >= text.size() || !text.at(start + length).isLetterOrNumber());
+}
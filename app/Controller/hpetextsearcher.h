@@ -0,0 +1,141 @@
+/**
+ * @file hpetextsearcher.h
+ * @brief This file is part of HPEController
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPETEXTSEARCHER_H
+#define HPETEXTSEARCHER_H
+
+#include <QRegularExpression>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class HPETextSearcher
+ * @brief Finds a literal text or a regular expression in lines of UTF-16 text
+ * @since 1.0.0
+ * 
+ * @ingroup controller
+ * 
+ * A literal pattern is found by indexOf(): it jumps between the code units that can start
+ * the pattern (the first one, and its other cases) by checking four UTF-16 code units at a time
+ * in a 64-bit word, like HPELinkScanner, and compares the rest of the pattern only there.
+ * A regular expression is found by QRegularExpression.
+ * 
+ * Matches never cross a line break and are never empty, the searcher is given one block at a time.
+ * 
+ * @code
+ *      HPETextSearcher searcher("todo", HPETextSearcher::WholeWords);
+ *      for(const HPETextSearcher::Match& match : searcher.findAll(block.text()))
+ *          qDebug() << match.start << match.length;
+ * @endcode
+*/
+class HPETextSearcher
+{
+public:
+
+    enum Option
+    {
+        NoOptions         = 0x0,
+        CaseSensitive     = 0x1,
+        WholeWords        = 0x2,
+        RegularExpression = 0x4
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
+    /**
+     * @brief A match, the positions are offsets into the searched text
+     * 
+    */
+    struct Match
+    {
+        qsizetype start = 0;
+        qsizetype length = 0;
+    };
+
+    /**
+     * @brief Construct an HPETextSearcher finding pattern
+     * 
+     * @param[in] pattern Nothing is found if it is empty
+     * @param[in] options
+    */
+    explicit HPETextSearcher(const QString& pattern = QString(), Options options = NoOptions);
+
+    /**
+     * @brief Returns whether the pattern is not empty, and is a valid regular expression if it is one
+     * 
+    */
+    bool isValid() const;
+
+    /**
+     * @brief Returns the reason if the regular expression is invalid
+     * 
+    */
+    QString errorString() const;
+
+    QString pattern() const;
+    Options options() const;
+
+    /**
+     * @brief Find the first match starting at or after from
+     * 
+     * @param[in] text A line
+     * @param[in] from
+     * @param[out] match
+     * @return false if there is none
+    */
+    bool find(QStringView text, qsizetype from, Match& match) const;
+
+    /**
+     * @brief Find the last match starting before before
+     * 
+     * @param[in] text A line
+     * @param[in] before
+     * @param[out] match
+     * @return false if there is none
+    */
+    bool findLast(QStringView text, qsizetype before, Match& match) const;
+
+    /**
+     * @brief Returns all the matches of text, which don't overlap
+     * 
+    */
+    QVector<Match> findAll(QStringView text) const;
+
+    /**
+     * @brief Returns what match of text is replaced with: replacement,
+     * in which \\0 to \\9 are the captures of a regular expression
+     * 
+    */
+    QString replacement(QStringView text, const Match& match, const QString& replacement) const;
+
+    /**
+     * @brief Returns the position of the first needle in text from from, or -1
+     * 
+    */
+    static qsizetype indexOf(QStringView text, qsizetype from, QStringView needle,
+                             Qt::CaseSensitivity cs = Qt::CaseSensitive);
+
+private:
+
+    /**
+     * @brief Returns whether the match is a whole word, or WholeWords is not set
+     * 
+    */
+    bool isWholeWord(QStringView text, qsizetype start, qsizetype length) const;
+
+    QString m_pattern;
+    Options m_options;
+    QRegularExpression m_regex;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(HPETextSearcher::Options)
+
+#endif // HPETEXTSEARCHER_H
@@ -14,6 +14,10 @@
 #include "ui_hpefileselectorform.h"
 
 #include <QDirIterator>
+#include <QPointer>
+#include <QThreadPool>
+
+#include "Controller/hpefrontmatter.h"
 
 HPEFileSelectorForm::HPEFileSelectorForm(QWidget *parent) :
     QWidget(parent),
@@ -53,18 +57,40 @@ void HPEFileSelectorForm::setDir(const QDir &targetDir)
 
     ui->currentDirLabel->setText(tr("Current Dir: ") + m_targetDir.absolutePath());
     ui->currentDirLabel->setWordWrap(true);
+    QStringList filePaths;
     QDirIterator markdownIterator(targetDir.absolutePath(), {"*.md"}, QDir::Files | QDir::Writable, QDirIterator::Subdirectories);
-    QStringList markdownFiles;
     while(markdownIterator.hasNext())
     {
         markdownIterator.next();
-        markdownFiles.append(m_targetDir.relativeFilePath(markdownIterator.filePath()));
+        filePaths.append(markdownIterator.filePath());
+        ui->fileListWidget->addItem(m_targetDir.relativeFilePath(markdownIterator.filePath()));
     }
-    ui->fileListWidget->addItems(markdownFiles);
+
+    //show the title and date in Front-Matter as tool tip,
+    //read in the pool and filled in this thread row by row, unless the list is reset
+    QPointer<HPEFileSelectorForm> self(this);
+    int generation = ++m_generation;
+    QThreadPool::globalInstance()->start([self, generation, filePaths]{
+        for(int row = 0; row < filePaths.size() && self; ++row)
+        {
+            HPEFrontMatter frontMatter = HPEFrontMatter::fromFile(filePaths.at(row));
+            if(frontMatter.title().isEmpty())
+                continue;
+            QString toolTip = frontMatter.date().isEmpty() ? frontMatter.title()
+                                                           : QString("%1\n%2").arg(frontMatter.title(), frontMatter.date());
+            QMetaObject::invokeMethod(self, [self, generation, row, toolTip]{
+                if(!self || generation != self->m_generation)
+                    return;
+                if(QListWidgetItem* item = self->ui->fileListWidget->item(row))
+                    item->setToolTip(toolTip);
+            }, Qt::QueuedConnection);
+        }
+    });
 }
 
 void HPEFileSelectorForm::reset()
 {
+    ++m_generation;
     ui->confirmButton->setDisabled(true);
     ui->fileListWidget->clear();
 }
@@ -88,12 +88,21 @@ private:
     */
     QString m_selectedFileName;
 
+    /**
+     * @brief Increased by setDir() and reset(),
+     * the Front-Matters read for an older list are dropped
+     * 
+    */
+    int m_generation = 0;
+
 public:
 
     /**
      * @brief This method is usually called by HPEStartupDialog.
      * Store the given directory and list all Markdown files
      * in the directory in ui->fileListWidget.
+     * The Front-Matters of the files are read in QThreadPool, their titles and dates
+     * are set as the tool tips of the rows as they arrive.
      * Note that HPEFileSelectorForm won't be available until this method is called.
      * 
      * @param[in] directory The directory to iterate.
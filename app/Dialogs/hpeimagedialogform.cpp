@@ -18,6 +18,7 @@
 #include <QFileDialog>
 
 #include "hpemainwindow.h"
+#include "Controller/hpeassetresolver.h"
 
 HPEImageDialogForm::HPEImageDialogForm(QWidget *parent) :
     QWidget(parent),
@@ -63,17 +64,17 @@ HPEImageDialogForm::~HPEImageDialogForm()
 QString HPEImageDialogForm::getImageFilePath() const
 {
     //should copy to resource dir and reset path
+    HPEAssetResolver* assetResolver = m_mainWindow->getAssetResolver();
     if(ui->newSourceGroup->isChecked())
     {
-        QFileInfo currentFileInfo(m_mainWindow->getFilePath());
-        QDir currentDir = currentFileInfo.absoluteDir();
-        if(!currentDir.cd(currentFileInfo.baseName()))
+        QDir assetDir = assetResolver->assetDir();
+        if(!assetResolver->hasFilePath() || !assetDir.exists())
         {
             //error
             return ui->pathEdit->text();
         }
         QFileInfo targetFileInfo(ui->pathEdit->text());
-        if(!QFile::copy(ui->pathEdit->text(), currentDir.absoluteFilePath(targetFileInfo.fileName())))
+        if(!QFile::copy(ui->pathEdit->text(), assetDir.absoluteFilePath(targetFileInfo.fileName())))
             return ui->pathEdit->text();
         return targetFileInfo.fileName();
     }
@@ -82,7 +83,7 @@ QString HPEImageDialogForm::getImageFilePath() const
         if(!ui->imageList->selectedItems().empty())
         {
             QListWidgetItem* selected = ui->imageList->selectedItems().first();
-            if(QFileInfo(selected->toolTip()).absolutePath().endsWith("/images"))
+            if(QFileInfo(selected->toolTip()).absolutePath() == assetResolver->imagesDir().absolutePath())
                 return QString("/images/%1").arg(selected->text());
             else
                 return selected->text();
@@ -101,17 +102,7 @@ void HPEImageDialogForm::resetEdit()
 
 void HPEImageDialogForm::showEvent(QShowEvent *)
 {
-    QList<QFileInfo> imageFiles;
-    QFileInfo currentFileInfo(m_mainWindow->getFilePath());
-    QDir currentDir = currentFileInfo.absoluteDir();
-    if(currentDir.cd(currentFileInfo.baseName()))
-        imageFiles.append(currentDir.entryInfoList(QStringList() << "*.jpeg" << "*.jpg" << "*.png" << "*.tiff",
-                                               QDir::Files));
-    QDir sourceDir = currentFileInfo.absoluteDir();
-    if(sourceDir.dirName() == "source" || (sourceDir.cdUp() && sourceDir.dirName() == "source"))
-        if(sourceDir.cd("images"))
-            imageFiles.append(sourceDir.entryInfoList(QStringList() << "*.jpeg" << "*.jpg" << "*.png" << "*.tiff",
-                                                   QDir::Files));
+    const QFileInfoList imageFiles = m_mainWindow->getAssetResolver()->images();
 
     ui->imageList->clear();
     for(const QFileInfo& imageInfo : imageFiles)
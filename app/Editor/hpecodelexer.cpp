@@ -0,0 +1,495 @@
+/**
+ * @file hpecodelexer.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpecodelexer.h"
+
+#include <algorithm>
+
+//the keyword and literal tables are sorted, see contains()
+
+static const char* const C_KEYWORDS[] = {
+    "_Bool", "auto", "break", "case", "char", "const", "continue", "default", "do", "double",
+    "else", "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+    "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef",
+    "union", "unsigned", "void", "volatile", "while"
+};
+
+static const char* const C_LITERALS[] = {
+    "NULL", "false", "true"
+};
+
+static const char* const CPP_KEYWORDS[] = {
+    "_Bool", "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+    "char16_t", "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "concept",
+    "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype", "default",
+    "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern",
+    "final", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+    "namespace", "new", "noexcept", "not", "operator", "or", "override", "private", "protected",
+    "public", "register", "reinterpret_cast", "requires", "restrict", "return", "short", "signed",
+    "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+    "thread_local", "throw", "try", "typedef", "typeid", "typename", "union", "unsigned", "using",
+    "virtual", "void", "volatile", "wchar_t", "while"
+};
+
+static const char* const CPP_LITERALS[] = {
+    "NULL", "false", "nullptr", "true"
+};
+
+static const char* const CSHARP_KEYWORDS[] = {
+    "abstract", "as", "async", "await", "base", "bool", "break", "byte", "case", "catch", "char",
+    "checked", "class", "const", "continue", "decimal", "default", "delegate", "do", "double",
+    "else", "enum", "event", "explicit", "extern", "finally", "fixed", "float", "for", "foreach",
+    "get", "goto", "if", "implicit", "in", "init", "int", "interface", "internal", "is", "lock",
+    "long", "namespace", "new", "object", "operator", "out", "override", "params", "private",
+    "protected", "public", "readonly", "record", "ref", "return", "sbyte", "sealed", "set", "short",
+    "sizeof", "stackalloc", "static", "string", "struct", "switch", "this", "throw", "try",
+    "typeof", "uint", "ulong", "unchecked", "unsafe", "ushort", "using", "var", "virtual", "void",
+    "volatile", "while", "yield"
+};
+
+static const char* const JAVA_KEYWORDS[] = {
+    "abstract", "assert", "boolean", "break", "byte", "case", "catch", "char", "class", "const",
+    "continue", "default", "do", "double", "else", "enum", "extends", "final", "finally", "float",
+    "for", "goto", "if", "implements", "import", "instanceof", "int", "interface", "long", "native",
+    "new", "package", "permits", "private", "protected", "public", "record", "return", "sealed",
+    "short", "static", "strictfp", "super", "switch", "synchronized", "this", "throw", "throws",
+    "transient", "try", "var", "void", "volatile", "while", "yield"
+};
+
+static const char* const NULL_LITERALS[] = {
+    "false", "null", "true"
+};
+
+static const char* const JS_KEYWORDS[] = {
+    "async", "await", "break", "case", "catch", "class", "const", "continue", "debugger", "default",
+    "delete", "do", "else", "export", "extends", "finally", "for", "from", "function", "get", "if",
+    "import", "in", "instanceof", "let", "new", "of", "return", "set", "static", "super", "switch",
+    "this", "throw", "try", "typeof", "var", "void", "while", "with", "yield"
+};
+
+static const char* const JS_LITERALS[] = {
+    "Infinity", "NaN", "false", "null", "true", "undefined"
+};
+
+static const char* const TS_KEYWORDS[] = {
+    "abstract", "any", "as", "async", "await", "boolean", "break", "case", "catch", "class",
+    "const", "continue", "debugger", "declare", "default", "delete", "do", "else", "enum", "export",
+    "extends", "finally", "for", "from", "function", "get", "if", "implements", "import", "in",
+    "instanceof", "interface", "keyof", "let", "namespace", "never", "new", "number", "of",
+    "private", "protected", "public", "readonly", "return", "set", "static", "string", "super",
+    "switch", "symbol", "this", "throw", "try", "type", "typeof", "unknown", "var", "void", "while",
+    "with", "yield"
+};
+
+static const char* const GO_KEYWORDS[] = {
+    "bool", "break", "byte", "case", "chan", "const", "continue", "default", "defer", "else",
+    "error", "fallthrough", "float32", "float64", "for", "func", "go", "goto", "if", "import",
+    "int", "int16", "int32", "int64", "int8", "interface", "map", "package", "range", "return",
+    "rune", "select", "string", "struct", "switch", "type", "uint", "uint16", "uint32", "uint64",
+    "uint8", "uintptr", "var"
+};
+
+static const char* const GO_LITERALS[] = {
+    "false", "iota", "nil", "true"
+};
+
+static const char* const RUST_KEYWORDS[] = {
+    "Self", "as", "async", "await", "bool", "break", "char", "const", "continue", "crate", "dyn",
+    "else", "enum", "extern", "f32", "f64", "fn", "for", "i128", "i16", "i32", "i64", "i8", "if",
+    "impl", "in", "isize", "let", "loop", "match", "mod", "move", "mut", "pub", "ref", "return",
+    "self", "static", "str", "struct", "super", "trait", "type", "u128", "u16", "u32", "u64", "u8",
+    "unsafe", "use", "usize", "where", "while"
+};
+
+static const char* const RUST_LITERALS[] = {
+    "Err", "None", "Ok", "Some", "false", "true"
+};
+
+static const char* const KOTLIN_KEYWORDS[] = {
+    "abstract", "as", "break", "by", "catch", "class", "companion", "constructor", "continue",
+    "data", "do", "else", "enum", "finally", "for", "fun", "get", "if", "import", "in", "init",
+    "interface", "internal", "is", "lateinit", "object", "open", "override", "package", "private",
+    "protected", "public", "return", "sealed", "set", "super", "suspend", "this", "throw", "try",
+    "typealias", "val", "var", "when", "while"
+};
+
+static const char* const SWIFT_KEYWORDS[] = {
+    "Self", "as", "associatedtype", "break", "case", "catch", "class", "continue", "default",
+    "defer", "deinit", "do", "else", "enum", "extension", "fallthrough", "for", "func", "guard",
+    "if", "import", "in", "init", "inout", "is", "let", "operator", "private", "protocol", "public",
+    "repeat", "rethrows", "return", "self", "static", "struct", "subscript", "super", "switch",
+    "throw", "throws", "try", "typealias", "var", "where", "while"
+};
+
+static const char* const SWIFT_LITERALS[] = {
+    "false", "nil", "true"
+};
+
+static const char* const PYTHON_KEYWORDS[] = {
+    "and", "as", "assert", "async", "await", "break", "case", "class", "continue", "def", "del",
+    "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in", "is",
+    "lambda", "match", "nonlocal", "not", "or", "pass", "raise", "return", "try", "while", "with",
+    "yield"
+};
+
+static const char* const PYTHON_LITERALS[] = {
+    "False", "None", "True", "cls", "self"
+};
+
+static const char* const BASH_KEYWORDS[] = {
+    "case", "cd", "do", "done", "echo", "elif", "else", "esac", "eval", "exec", "exit", "export",
+    "fi", "for", "function", "if", "in", "local", "printf", "read", "readonly", "return", "select",
+    "set", "shift", "source", "test", "then", "trap", "unset", "until", "while"
+};
+
+static const char* const BOOL_LITERALS[] = {
+    "false", "true"
+};
+
+static const char* const YAML_LITERALS[] = {
+    "false", "no", "null", "off", "on", "true", "yes"
+};
+
+static const char* const SQL_KEYWORDS[] = {
+    "add", "all", "alter", "and", "as", "asc", "between", "by", "case", "create", "default",
+    "delete", "desc", "distinct", "drop", "else", "end", "exists", "foreign", "from", "full",
+    "group", "having", "if", "in", "index", "inner", "insert", "into", "is", "join", "key", "left",
+    "like", "limit", "not", "offset", "on", "or", "order", "outer", "primary", "references",
+    "right", "select", "set", "table", "then", "union", "unique", "update", "values", "view",
+    "when", "where", "with"
+};
+
+/**
+ * @brief A sorted table of words
+ * 
+*/
+struct WordTable
+{
+    const char* const* words = nullptr;
+    int count = 0;
+
+    constexpr WordTable() = default;
+    template<int N>
+    constexpr WordTable(const char* const (&table)[N]) : words(table), count(N) { }
+};
+
+/**
+ * @brief The lexical rules of a language
+ * 
+*/
+struct Syntax
+{
+    WordTable keywords;
+    WordTable literals;
+    const char16_t* lineComment;    ///< "//", "#", "--" or nullptr
+    bool blockComments;             ///< /* ... */, may span lines
+    const char16_t* quotes;         ///< the characters quoting a string in a line
+    bool backtickStrings;           ///< `...`, may span lines
+    bool tripleQuotes;              ///< """...""" and '''...''', may span lines
+    bool preprocessor;              ///< a line starting with '#' is Meta
+    bool decorators;                ///< @name is Meta
+    bool variables;                 ///< $name is Variable
+    bool keys;                      ///< "key": of JSON and key: of YAML are Key
+    bool caseInsensitive;           ///< the words of the tables
+};
+
+static const Syntax SYNTAXES[HPECodeLexer::LanguageCount] = {
+    //  keywords         literals         line     block  quotes   `      """    #      @      $      keys   case
+    { {},              {},              nullptr, false, u"",     false, false, false, false, false, false, false },  //None
+    { C_KEYWORDS,      C_LITERALS,      u"//",   true,  u"\"'",  false, false, true,  false, false, false, false },  //C
+    { CPP_KEYWORDS,    CPP_LITERALS,    u"//",   true,  u"\"'",  false, false, true,  false, false, false, false },  //Cpp
+    { CSHARP_KEYWORDS, NULL_LITERALS,   u"//",   true,  u"\"'",  false, false, true,  false, false, false, false },  //CSharp
+    { JAVA_KEYWORDS,   NULL_LITERALS,   u"//",   true,  u"\"'",  false, false, false, true,  false, false, false },  //Java
+    { JS_KEYWORDS,     JS_LITERALS,     u"//",   true,  u"\"'",  true,  false, false, true,  false, false, false },  //JavaScript
+    { TS_KEYWORDS,     JS_LITERALS,     u"//",   true,  u"\"'",  true,  false, false, true,  false, false, false },  //TypeScript
+    { GO_KEYWORDS,     GO_LITERALS,     u"//",   true,  u"\"'",  true,  false, false, false, false, false, false },  //Go
+    { RUST_KEYWORDS,   RUST_LITERALS,   u"//",   true,  u"\"",   false, false, true,  false, false, false, false },  //Rust
+    { KOTLIN_KEYWORDS, NULL_LITERALS,   u"//",   true,  u"\"'",  false, true,  false, true,  false, false, false },  //Kotlin
+    { SWIFT_KEYWORDS,  SWIFT_LITERALS,  u"//",   true,  u"\"",   false, true,  false, true,  false, false, false },  //Swift
+    { PYTHON_KEYWORDS, PYTHON_LITERALS, u"#",    false, u"\"'",  false, true,  false, true,  false, false, false },  //Python
+    { BASH_KEYWORDS,   BOOL_LITERALS,   u"#",    false, u"\"'",  false, false, false, false, true,  false, false },  //Bash
+    { {},              YAML_LITERALS,   u"#",    false, u"\"'",  false, false, false, false, false, true,  true  },  //Yaml
+    { {},              NULL_LITERALS,   nullptr, false, u"\"",   false, false, false, false, false, true,  false },  //Json
+    { SQL_KEYWORDS,    NULL_LITERALS,   u"--",   true,  u"'\"",  false, false, false, false, false, false, true  }   //Sql
+};
+
+/**
+ * @brief The names and aliases of languages, in lower case
+ * 
+*/
+static const struct
+{
+    const char* name;
+    HPECodeLexer::Language language;
+} LANGUAGE_NAMES[] = {
+    { "c", HPECodeLexer::C },               { "h", HPECodeLexer::C },
+    { "cpp", HPECodeLexer::Cpp },           { "c++", HPECodeLexer::Cpp },           { "cc", HPECodeLexer::Cpp },
+    { "cxx", HPECodeLexer::Cpp },           { "hpp", HPECodeLexer::Cpp },           { "arduino", HPECodeLexer::Cpp },
+    { "cs", HPECodeLexer::CSharp },         { "c#", HPECodeLexer::CSharp },         { "csharp", HPECodeLexer::CSharp },
+    { "java", HPECodeLexer::Java },
+    { "js", HPECodeLexer::JavaScript },     { "javascript", HPECodeLexer::JavaScript },
+    { "jsx", HPECodeLexer::JavaScript },    { "mjs", HPECodeLexer::JavaScript },
+    { "ts", HPECodeLexer::TypeScript },     { "typescript", HPECodeLexer::TypeScript },
+    { "tsx", HPECodeLexer::TypeScript },
+    { "go", HPECodeLexer::Go },             { "golang", HPECodeLexer::Go },
+    { "rs", HPECodeLexer::Rust },           { "rust", HPECodeLexer::Rust },
+    { "kt", HPECodeLexer::Kotlin },         { "kotlin", HPECodeLexer::Kotlin },
+    { "swift", HPECodeLexer::Swift },
+    { "py", HPECodeLexer::Python },         { "python", HPECodeLexer::Python },     { "python3", HPECodeLexer::Python },
+    { "sh", HPECodeLexer::Bash },           { "bash", HPECodeLexer::Bash },         { "shell", HPECodeLexer::Bash },
+    { "zsh", HPECodeLexer::Bash },
+    { "yml", HPECodeLexer::Yaml },          { "yaml", HPECodeLexer::Yaml },
+    { "json", HPECodeLexer::Json },         { "jsonc", HPECodeLexer::Json },
+    { "sql", HPECodeLexer::Sql },           { "mysql", HPECodeLexer::Sql },         { "postgresql", HPECodeLexer::Sql }
+};
+
+static inline bool isDigit(char16_t c)
+{
+    return c >= u'0' && c <= u'9';
+}
+
+static inline bool isSpace(char16_t c)
+{
+    return c == u' ' || c == u'\t';
+}
+
+static inline bool isIdentifierStart(char16_t c)
+{
+    return c == u'_' || (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || (c >= 0x80 && QChar::isLetter(c));
+}
+
+static inline bool isIdentifierPart(char16_t c)
+{
+    return isIdentifierStart(c) || isDigit(c);
+}
+
+/**
+ * @brief Returns whether the sorted table contains word, by binary search
+ * 
+*/
+static bool contains(const WordTable& table, QStringView word, Qt::CaseSensitivity cs)
+{
+    const char* const* end = table.words + table.count;
+    const char* const* found = std::lower_bound(table.words, end, word, [cs](const char* item, QStringView word){
+        return word.compare(QLatin1String(item), cs) > 0;
+    });
+    return found != end && word.compare(QLatin1String(*found), cs) == 0;
+}
+
+/**
+ * @brief Returns the position after the end of the construct of state from the position from,
+ * or -1 if it doesn't end in text
+ * 
+*/
+static int findEnd(QStringView text, int from, int state)
+{
+    qsizetype end = -1;
+    switch(state)
+    {
+    case HPECodeLexer::BlockComment:
+        end = text.indexOf(u"*/", from);
+        return end < 0 ? -1 : int(end) + 2;
+    case HPECodeLexer::TripleDoubleQuotes:
+        end = text.indexOf(u"\"\"\"", from);
+        return end < 0 ? -1 : int(end) + 3;
+    case HPECodeLexer::TripleSingleQuotes:
+        end = text.indexOf(u"'''", from);
+        return end < 0 ? -1 : int(end) + 3;
+    default:
+        for(int i = from; i < text.size(); ++i)
+        {
+            if(text.at(i) == u'\\')
+                ++i;
+            else if(text.at(i) == u'`')
+                return i + 1;
+        }
+        return -1;
+    }
+}
+
+HPECodeLexer::Language HPECodeLexer::languageOf(QStringView infoString)
+{
+    QStringView name = infoString.trimmed();
+    qsizetype length = 0;
+    while(length < name.size() && !name.at(length).isSpace() && name.at(length) != u'{' && name.at(length) != u',')
+        ++length;
+    name = name.left(length);
+    if(name.isEmpty())
+        return None;
+
+    for(const auto& entry : LANGUAGE_NAMES)
+        if(name.compare(QLatin1String(entry.name), Qt::CaseInsensitive) == 0)
+            return entry.language;
+    return None;
+}
+
+int HPECodeLexer::tokenize(Language language, QStringView text, int state, Tokens &tokens)
+{
+    tokens.clear();
+    const Syntax& syntax = SYNTAXES[language];
+    const char16_t* data = text.utf16();
+    const int size = int(text.size());
+    const Qt::CaseSensitivity cs = syntax.caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive;
+    int i = 0;
+
+    //the construct continued from the previous line
+    if(state != Normal)
+    {
+        int end = findEnd(text, 0, state);
+        tokens.append({ state == BlockComment ? Comment : String, 0, end < 0 ? size : end });
+        if(end < 0)
+            return state;
+        i = end;
+    }
+
+    int first = i;
+    while(first < size && isSpace(data[first]))
+        ++first;
+    if(i == 0 && syntax.preprocessor && first < size && data[first] == u'#')
+    {
+        tokens.append({ Meta, first, size - first });
+        return Normal;
+    }
+    //key: or - key: of YAML
+    if(i == 0 && syntax.keys && language == Yaml)
+    {
+        int keyStart = first;
+        if(keyStart + 1 < size && data[keyStart] == u'-' && data[keyStart + 1] == u' ')
+            for(keyStart += 2; keyStart < size && isSpace(data[keyStart]); ++keyStart) { }
+        for(int j = keyStart; j < size && data[j] != u'#'; ++j)
+            if(data[j] == u':' && (j + 1 == size || isSpace(data[j + 1])))
+            {
+                if(j > keyStart)
+                    tokens.append({ Key, keyStart, j - keyStart });
+                i = j + 1;
+                break;
+            }
+    }
+
+    while(i < size)
+    {
+        char16_t c = data[i];
+        if(syntax.lineComment && text.mid(i).startsWith(QStringView(syntax.lineComment))
+                && ((language != Bash && language != Yaml) || i == 0 || isSpace(data[i - 1])))
+        {
+            tokens.append({ Comment, i, size - i });
+            break;
+        }
+
+        //the constructs which may span lines
+        int spanning = Normal, delimiterLength = 1;
+        if(syntax.blockComments && c == u'/' && i + 1 < size && data[i + 1] == u'*')
+        {
+            spanning = BlockComment;
+            delimiterLength = 2;
+        }
+        else if(syntax.tripleQuotes && (c == u'"' || c == u'\'') && i + 2 < size && data[i + 1] == c && data[i + 2] == c)
+        {
+            spanning = c == u'"' ? TripleDoubleQuotes : TripleSingleQuotes;
+            delimiterLength = 3;
+        }
+        else if(syntax.backtickStrings && c == u'`')
+            spanning = BacktickString;
+        if(spanning != Normal)
+        {
+            int end = findEnd(text, i + delimiterLength, spanning);
+            tokens.append({ spanning == BlockComment ? Comment : String, i, (end < 0 ? size : end) - i });
+            if(end < 0)
+                return spanning;
+            i = end;
+            continue;
+        }
+
+        if(QStringView(syntax.quotes).contains(QChar(c)))
+        {
+            int end = i + 1;
+            while(end < size && data[end] != c)
+                end += data[end] == u'\\' ? 2 : 1;
+            end = qMin(end + 1, size);
+
+            //"key": of JSON
+            Kind kind = String;
+            if(syntax.keys)
+            {
+                int j = end;
+                while(j < size && isSpace(data[j]))
+                    ++j;
+                if(j < size && data[j] == u':')
+                    kind = Key;
+            }
+            tokens.append({ kind, i, end - i });
+            i = end;
+            continue;
+        }
+
+        if(isDigit(c) || (c == u'.' && i + 1 < size && isDigit(data[i + 1])))
+        {
+            int end = i + 1;
+            while(end < size && (isIdentifierPart(data[end]) || data[end] == u'.'))
+                ++end;
+            tokens.append({ Number, i, end - i });
+            i = end;
+            continue;
+        }
+
+        //$name, ${name}, $1, $@ ... of shells
+        if(syntax.variables && c == u'$' && i + 1 < size)
+        {
+            int end = i + 1;
+            if(data[end] == u'{')
+            {
+                while(end < size && data[end] != u'}')
+                    ++end;
+                end = qMin(end + 1, size);
+            }
+            else if(isIdentifierPart(data[end]))
+            {
+                while(end < size && isIdentifierPart(data[end]))
+                    ++end;
+            }
+            else if(QStringView(u"@#?$!*-").contains(QChar(data[end])))
+                ++end;
+            if(end > i + 1)
+            {
+                tokens.append({ Variable, i, end - i });
+                i = end;
+                continue;
+            }
+        }
+
+        if(syntax.decorators && c == u'@' && i + 1 < size && isIdentifierStart(data[i + 1]))
+        {
+            int end = i + 1;
+            while(end < size && (isIdentifierPart(data[end]) || data[end] == u'.'))
+                ++end;
+            tokens.append({ Meta, i, end - i });
+            i = end;
+            continue;
+        }
+
+        if(isIdentifierStart(c))
+        {
+            int end = i + 1;
+            while(end < size && isIdentifierPart(data[end]))
+                ++end;
+            QStringView word = text.mid(i, end - i);
+            if(contains(syntax.keywords, word, cs))
+                tokens.append({ Keyword, i, end - i });
+            else if(contains(syntax.literals, word, cs))
+                tokens.append({ Literal, i, end - i });
+            i = end;
+            continue;
+        }
+        ++i;
+    }
+    return Normal;
+}
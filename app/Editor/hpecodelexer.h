@@ -0,0 +1,134 @@
+/**
+ * @file hpecodelexer.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPECODELEXER_H
+#define HPECODELEXER_H
+
+#include <QStringView>
+#include <QVarLengthArray>
+
+/**
+ * @class HPECodeLexer
+ * @brief A line-by-line lexer for the code in fenced code blocks
+ * @since 1.0.0
+ * 
+ * @ingroup editor
+ * 
+ * HPECodeLexer finds the keywords, literals, numbers, strings, comments and a few
+ * language-specific spans (preprocessor lines, decorators, shell variables, keys of YAML and JSON)
+ * of a line of code, so HPESyntaxHighlighter highlights fenced code blocks natively
+ * for the common languages of HighlightJSLanguages::HighlightJSSupportedLanguages.
+ * 
+ * Every language is described by a syntax: its comment and string delimiters and its
+ * keyword and literal tables. The tables are sorted arrays compiled into the binary,
+ * looked up by binary search, so lexing allocates nothing.
+ * 
+ * A construct spanning lines (a block comment, a triple-quoted string of Python or
+ * a backtick string of JavaScript and Go) is carried to the next line by the returned state.
+ * 
+ * @code
+ *      HPECodeLexer::Language language = HPECodeLexer::languageOf(u"cpp");
+ *      HPECodeLexer::Tokens tokens;
+ *      int state = HPECodeLexer::Normal;
+ *      for(const QString& line : lines)
+ *          state = HPECodeLexer::tokenize(language, line, state, tokens);
+ * @endcode
+*/
+class HPECodeLexer
+{
+public:
+
+    /**
+     * @brief The supported languages, None for the others
+     * 
+    */
+    enum Language
+    {
+        None,
+        C,
+        Cpp,
+        CSharp,
+        Java,
+        JavaScript,
+        TypeScript,
+        Go,
+        Rust,
+        Kotlin,
+        Swift,
+        Python,
+        Bash,
+        Yaml,
+        Json,
+        Sql,
+        LanguageCount
+    };
+
+    /**
+     * @brief The kind of a token
+     * 
+    */
+    enum Kind
+    {
+        Keyword,
+        Literal,
+        Number,
+        String,
+        Comment,
+        Meta,       ///< preprocessor lines, decorators and attributes
+        Variable,   ///< shell variables
+        Key,        ///< keys of YAML and JSON
+        KindCount
+    };
+
+    /**
+     * @brief The construct a line ends in, at most StateMask
+     * 
+    */
+    enum State
+    {
+        Normal             = 0,
+        BlockComment       = 1,
+        TripleDoubleQuotes = 2,
+        TripleSingleQuotes = 3,
+        BacktickString     = 4,
+        StateMask          = 0x07
+    };
+
+    struct Token
+    {
+        Kind kind;
+        int start;
+        int length;
+    };
+
+    typedef QVarLengthArray<Token, 32> Tokens;
+
+    /**
+     * @brief Returns the language of the info string of a code fence, like "cpp", "C++" or "python {.line-numbers}".
+     * Names and common aliases are matched case-insensitively.
+     * 
+    */
+    static Language languageOf(QStringView infoString);
+
+    /**
+     * @brief Find the tokens of a line of code
+     * 
+     * @param[in] language Not None
+     * @param[in] text The text of a line
+     * @param[in] state The state the previous line ends in
+     * @param[out] tokens The tokens, ordered by position
+     * @return The state this line ends in
+    */
+    static int tokenize(Language language, QStringView text, int state, Tokens& tokens);
+};
+
+#endif // HPECODELEXER_H
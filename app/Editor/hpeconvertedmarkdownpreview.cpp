@@ -15,66 +15,180 @@
 #include <QTextBlock>
 #include <QVBoxLayout>
 #include <QScrollBar>
-#include <QRegularExpression>
+#include <QPlainTextEdit>
 
 #include "hpemarkdowneditor.h"
+#include "hpelinkindex.h"
 #include "Controller/hpesettings.h"
+#include "Controller/hpemarkdownconverter.h"
+#include "Controller/hpeassetresolver.h"
+#include "Controller/hpeimageproxy.h"
 
 HPEConvertedMarkdownPreview::HPEConvertedMarkdownPreview(HPEMarkdownEditor *connectedEditor, QWidget *parent)
     : QWidget{parent}
 {
-    m_preview = new HPEMarkdownEditor(this);
     if(!this->layout())
     {
         QVBoxLayout* layout = new QVBoxLayout(this);
         this->setLayout(layout);
     }
-    this->layout()->addWidget(m_preview);
 
-    m_preview->setReadOnly(true);
-    QFont font;
-    font.fromString(HPESettings::config()->value("markdownField/font").toString());
-    m_preview->setFont(font);
+    m_assetResolver = new HPEAssetResolver(this);
+    bool imageProxyEnabled = HPESettings::config()->value("preview/imageProxy", true).toBool();
+    //for the scroll synchronization inside preview blocks
+    m_renderer.setLineAnchors(true);
+    m_renderer.setImageResolver([this, imageProxyEnabled](const QString& path){
+        HPEAssetResolver::Asset asset = m_assetResolver->resolve(path);
+        return imageProxyEnabled ? HPEImageProxy::urlOf(asset) : asset.url;
+    });
+
+    //the converter lives in m_converterThread, all connections below are queued
+    m_converter = new HPEMarkdownConverter();
+    m_converter->setAssetResolver(m_assetResolver);
+    m_converter->setImageProxyEnabled(imageProxyEnabled);
+    m_converter->moveToThread(&m_converterThread);
+    connect(&m_converterThread, &QThread::finished, m_converter, &QObject::deleteLater);
+    connect(this, &HPEConvertedMarkdownPreview::resetRequested, m_converter, &HPEMarkdownConverter::reset);
+    connect(this, &HPEConvertedMarkdownPreview::changeRequested, m_converter, &HPEMarkdownConverter::applyChange);
+    connect(m_converter, &HPEMarkdownConverter::convertedAll, this, &HPEConvertedMarkdownPreview::onConvertedAll);
+    connect(m_converter, &HPEMarkdownConverter::convertedChanged, this, &HPEConvertedMarkdownPreview::onConvertedChanged);
+    connect(m_converter, &HPEMarkdownConverter::syncLost, this, &HPEConvertedMarkdownPreview::onSyncLost);
+    connect(m_assetResolver, &HPEAssetResolver::assetsChanged, this, &HPEConvertedMarkdownPreview::onAssetsChanged);
+    m_converterThread.start();
+
     connectEditor(connectedEditor);
 }
 
+HPEConvertedMarkdownPreview::~HPEConvertedMarkdownPreview()
+{
+    m_converter->invalidateBefore(++m_sourceVersion);
+    m_converterThread.quit();
+    m_converterThread.wait();
+}
+
 void HPEConvertedMarkdownPreview::connectEditor(HPEMarkdownEditor *connectedEditor)
 {
     m_connectedEditor = connectedEditor;
     if(m_connectedEditor)
     {
         m_connectedDocument = m_connectedEditor->document();
-        //connect(m_connectedDocument, &QTextDocument::contentsChange, this, &HPEConvertedMarkdownPreview::convertBlock);
-        connect(m_connectedDocument, &QTextDocument::contentsChanged, this, &HPEConvertedMarkdownPreview::analyze);
+        connect(m_connectedDocument, &QTextDocument::contentsChange, this, &HPEConvertedMarkdownPreview::onContentsChange);
         connect(m_connectedEditor->verticalScrollBar(), &QScrollBar::valueChanged, this, [this](int v){
-            m_preview->verticalScrollBar()->setValue(v);
+            if(isViewerVisible())
+                m_viewer->verticalScrollBar()->setValue(v);
         });
     }
 }
 
 void HPEConvertedMarkdownPreview::analyze()
 {
-    if(m_currentFileDir == QDir())
+    if(m_currentFileDir == QDir() || !m_connectedDocument)
         return;
 
-    m_preview->clear();
-    analyzeFrontMatter();
-    if(m_connectedDocument)
+    QStringList sourceLines;
+    sourceLines.reserve(m_connectedDocument->blockCount());
+    for(QTextBlock block = m_connectedDocument->begin(); block.isValid(); block = block.next())
+        sourceLines.append(block.text());
+
+    if(m_frontMatter.parse(sourceLines))
+        emit frontMatterChanged(m_frontMatter);
+
+    m_sourceBlockCount = sourceLines.size();
+    m_resetVersion = ++m_sourceVersion;
+    m_converter->invalidateBefore(m_resetVersion);
+    emit resetRequested(m_resetVersion, sourceLines);
+}
+
+void HPEConvertedMarkdownPreview::onContentsChange(int position, int /*charsRemoved*/, int charsAdded)
+{
+    if(m_currentFileDir == QDir() || !m_connectedDocument || m_sourceBlockCount == 0)
+        return;
+
+    QTextBlock firstBlock = m_connectedDocument->findBlock(position);
+    QTextBlock lastBlock  = m_connectedDocument->findBlock(position + charsAdded);
+    if(!firstBlock.isValid())
+        firstBlock = m_connectedDocument->lastBlock();
+    if(!lastBlock.isValid())
+        lastBlock = m_connectedDocument->lastBlock();
+
+    //blocks [first, first + removedCount) are replaced by blocks [first, first + addedCount)
+    int first = firstBlock.blockNumber();
+    int addedCount = lastBlock.blockNumber() - first + 1;
+    int removedCount = addedCount - (m_connectedDocument->blockCount() - m_sourceBlockCount);
+    if(removedCount < 1 || first + removedCount > m_sourceBlockCount)
     {
-        QTextBlock block = m_connectedDocument->findBlockByNumber(m_frontMatterBlockRange.getTo()).next();
-        while(block.isValid())
-        {
-            m_preview->appendPlainText(convertBlock(block));
-            QTextCursor cursor(m_preview->textCursor());
-            cursor.movePosition(QTextCursor::NextBlock);
-            m_preview->setTextCursor(cursor);
-            block = block.next();
-        }
-        //move to
-        //m_preview->setTextCursor(m_connectedEditor->textCursor());
+        //out of sync, convert the whole document
+        analyze();
+        return;
+    }
+
+    QStringList sourceLines;
+    sourceLines.reserve(addedCount);
+    QTextBlock block = firstBlock;
+    for(int i = 0; i < addedCount; ++i, block = block.next())
+        sourceLines.append(block.text());
+
+    if(m_frontMatter.isTouchedBy(first, sourceLines)
+            && m_frontMatter.parse([this](int i){ return m_connectedDocument->findBlockByNumber(i).text(); },
+                                   m_connectedDocument->blockCount()))
+        emit frontMatterChanged(m_frontMatter);
+
+    m_sourceBlockCount = m_connectedDocument->blockCount();
+    emit changeRequested(++m_sourceVersion, first, removedCount, sourceLines);
+}
+
+void HPEConvertedMarkdownPreview::onConvertedAll(int version, const QString &markdown)
+{
+    if(version < m_resetVersion)
+        return;
+
+    m_convertedLines = markdown.split('\n');
+    if(isViewerVisible())
+        m_viewer->setPlainText(markdown);
+    else
+        m_viewerOutdated = true;
+    emit convertedAll(markdown);
+}
+
+void HPEConvertedMarkdownPreview::onConvertedChanged(int version, int from, int to, const QStringList &lines)
+{
+    if(version < m_resetVersion)
+        return;
+
+    if(!replacePreviewLines(from, to - from, lines))
+    {
+        //out of sync, convert the whole document
+        analyze();
+        return;
+    }
+    emit convertedChanged(from, to, lines);
+}
+
+void HPEConvertedMarkdownPreview::onSyncLost(int version)
+{
+    if(version >= m_resetVersion)
+        analyze();
+}
+
+void HPEConvertedMarkdownPreview::onAssetsChanged(const QString &path)
+{
+    if(!m_connectedEditor || !m_connectedDocument || m_sourceBlockCount == 0)
+        return;
+
+    //a block is sent once however many of its images changed
+    const QString folder = path + "/";
+    int lastBlock = -1;
+    for(const HPELinkIndex::Entry& image : m_connectedEditor->linkIndex()->images())
+    {
+        if(image.blockNumber == lastBlock || image.blockNumber >= m_sourceBlockCount)
+            continue;
+        const QString filePath = m_assetResolver->resolve(image.url).filePath;
+        if(filePath.isEmpty() || (filePath != path && !filePath.startsWith(folder)))
+            continue;
+        lastBlock = image.blockNumber;
+        emit changeRequested(++m_sourceVersion, image.blockNumber, 1,
+                             { m_connectedDocument->findBlockByNumber(image.blockNumber).text() });
     }
-    m_convertedMarkdown = m_preview->toPlainText();
-    emit convertedAll(m_convertedMarkdown);
 }
 
 void HPEConvertedMarkdownPreview::filePathChanged(const QString &path)
@@ -92,80 +206,96 @@ void HPEConvertedMarkdownPreview::filePathChanged(const QString &path)
         }
     }
 
+    m_assetResolver->setFilePath(path);
     analyze();
 }
 
-void HPEConvertedMarkdownPreview::analyzeFrontMatter()
+bool HPEConvertedMarkdownPreview::replacePreviewLines(int from, int removedCount, const QStringList &lines)
 {
-    if(m_connectedEditor && m_connectedDocument)
+    if(from < 0 || removedCount < 1 || from + removedCount > m_convertedLines.size())
+        return false;
+
+    int diff = lines.size() - removedCount;
+    if(diff > 0)
+        m_convertedLines.insert(from, diff, QString());
+    else if(diff < 0)
+        m_convertedLines.remove(from, -diff);
+    for(int i = 0; i < lines.size(); ++i)
+        m_convertedLines[from + i] = lines.at(i);
+
+    if(!isViewerVisible())
     {
-        QTextCursor fmStartCursor = m_connectedDocument->find(QRegularExpression("^---$"));
-        int fmStart = fmStartCursor.blockNumber();
-        int fmEnd = m_connectedDocument->find(QRegularExpression("^---$"), fmStartCursor.movePosition(QTextCursor::NextBlock)).blockNumber();
-        m_frontMatterBlockRange.setRange(fmStart, fmEnd);
+        m_viewerOutdated = true;
+        return true;
+    }
 
-        convertTitle();
+    QTextDocument* viewerDocument = m_viewer->document();
+    QTextBlock fromBlock = viewerDocument->findBlockByNumber(from);
+    QTextBlock toBlock   = viewerDocument->findBlockByNumber(from + removedCount - 1);
+    if(!fromBlock.isValid() || !toBlock.isValid())
+    {
+        m_viewer->setPlainText(convertedText());
+        return true;
     }
+
+    QTextCursor cursor(viewerDocument);
+    cursor.setPosition(fromBlock.position());
+    cursor.setPosition(toBlock.position() + toBlock.length() - 1, QTextCursor::KeepAnchor);
+    cursor.insertText(lines.join('\n'));
+    return true;
 }
 
-void HPEConvertedMarkdownPreview::convertTitle()
+bool HPEConvertedMarkdownPreview::isViewerVisible() const
 {
-    //get title of the post
-    QRegularExpressionMatch match;
-    for (int i = m_frontMatterBlockRange.getFrom() + 1;i < m_frontMatterBlockRange.getTo(); ++i)
-    {
-        match = QRegularExpression("^[ ]*title: (.+)$").match(m_connectedDocument->findBlockByNumber(i).text());
-        if(match.hasMatch())
-        {
-            m_title = match.capturedTexts().at(1);
-            QTextCursor cursor(m_preview->textCursor());
-            cursor.movePosition(QTextCursor::Start);
-
-            //remove previous title
-            cursor.select(QTextCursor::BlockUnderCursor);
-            cursor.removeSelectedText();
-            m_preview->setTextCursor(cursor);
-
-            cursor.movePosition(QTextCursor::Start);
-            m_preview->setTextCursor(cursor);
-            m_preview->insertPlainText(QString("# %1").arg(m_title));
-
-            //cursor.movePosition(QTextCursor::NextBlock);
-            //m_preview->setTextCursor(cursor);
-            break;
-        }
-    }
+    return m_viewer && m_viewer->isVisible();
 }
 
-QString HPEConvertedMarkdownPreview::convertBlock(const QTextBlock &block)
+void HPEConvertedMarkdownPreview::showEvent(QShowEvent *event)
 {
-    if(m_frontMatterBlockRange.contains(block.blockNumber()))
+    QWidget::showEvent(event);
+    if(!m_viewer)
     {
-        analyzeFrontMatter();
-        return "";
+        m_viewer = new QPlainTextEdit(this);
+        m_viewer->setReadOnly(true);
+        m_viewer->setLineWrapMode(QPlainTextEdit::NoWrap);
+        QFont font;
+        font.fromString(HPESettings::config()->value("markdownField/font").toString());
+        m_viewer->setFont(font);
+        this->layout()->addWidget(m_viewer);
+        m_viewer->show();
     }
-
-    QString targetText = block.text();
-    QRegularExpression imagePattern = QRegularExpression(QString("\\!\\[.*\\]\\((.+)\\)"));
-    QRegularExpressionMatch imageMatch =imagePattern.match(targetText);
-    if(imageMatch.hasMatch())
+    if(m_viewerOutdated)
     {
-        QString assetsFolderName = QFileInfo(m_currentFilePath).baseName();
-        QString imagePath = imageMatch.capturedTexts().at(1);
-        if(!QRegularExpression("^[a-zA-z]+://[^\\s]+$").match(imagePath).hasMatch())
-        {
-            QString targetFile;
-            if(imagePath.startsWith("/images"))
-                targetFile = m_sourceDir.absolutePath() + imagePath;
-            else
-                targetFile = m_currentFileDir.absolutePath() + QString("/%1/%2").arg(assetsFolderName, imagePath);
-            targetText.replace(imageMatch.capturedStart(1), imageMatch.capturedLength(1),
-                                    QUrl::fromLocalFile(targetFile).toString());
-
-        }
-        //else if it's url, remain the same
-        return targetText;
+        m_viewer->setPlainText(convertedText());
+        m_viewerOutdated = false;
     }
-    else
-        return block.text();
+    if(m_connectedEditor)
+        m_viewer->verticalScrollBar()->setValue(m_connectedEditor->verticalScrollBar()->value());
+}
+
+const HPEFrontMatter &HPEConvertedMarkdownPreview::frontMatter() const
+{
+    return m_frontMatter;
+}
+
+HPEAssetResolver *HPEConvertedMarkdownPreview::assetResolver() const
+{
+    return m_assetResolver;
+}
+
+int HPEConvertedMarkdownPreview::outputLineOfSourceBlock(int blockNumber) const
+{
+    if(blockNumber < m_frontMatter.bodyStart())
+        return 0;
+    return blockNumber - m_frontMatter.bodyStart() + (m_frontMatter.title().isEmpty() ? 0 : 1);
+}
+
+QString HPEConvertedMarkdownPreview::convertedText() const
+{
+    return m_convertedLines.join('\n');
+}
+
+QString HPEConvertedMarkdownPreview::renderHtml(const QString &markdown) const
+{
+    return m_renderer.render(markdown);
 }
@@ -17,28 +17,17 @@
 #include <QDir>
 #include <QTextDocument>
 #include <QPageRanges>
+#include <QStringList>
+#include <QThread>
 
-class HPEMarkdownEditor;
+#include "Controller/hpemarkdownrenderer.h"
+#include "Controller/hpefrontmatter.h"
 
-struct BlockRange
-{
-private:
-    int from = 0;
-    int to = 0;
-public:
-    void setRange(int from, int to)
-    {
-        if(from > to) return;
-        this->from = from;
-        this->to = to;
-    }
-
-    bool contains(int number) { return number >= from && number <= to; }
-    int getFrom() { return from; }
-    int getTo()   { return to; }
-    int length()  { return to - from; }
-};
+class HPEMarkdownConverter;
+class HPEAssetResolver;
 
+class HPEMarkdownEditor;
+class QPlainTextEdit;
 
 /**
  * @class HPEConvertedMarkdownPreview
@@ -50,7 +39,7 @@ public:
  * 
  * HPEConvertedMarkdownPreview is a widget which can 
  * convert Hexo document (got from HPEMarkdownEditor) to standard Markdown text
- * and show the converted Markdown texts in m_preview(HPEMarkdownEditor).
+ * and show the converted Markdown texts in m_viewer.
  * 
  * @attention Providing an HPEMarkdownEditor (either provide in constructor or connectEditor())
  * is essential to other methods.
@@ -61,29 +50,30 @@ public:
  * Afer converting, HPEConvertedMarkdownPreview will emit convertedAll() signal to
  * tranfer converted Markdown texts.
  * 
- * @par Converting rules
+ * Converting is done by an HPEMarkdownConverter living in m_converterThread.
  * 
- * 1. analyze Hexo's Front-Matter and extract some useful information, such as
- * title, date, classification and tags.
+ * @see HPEMarkdownConverter for the converting rules
  * 
- * @note Visit https://hexo.io/docs/front-matter for more info
+ * @par Incremental converting
  * 
- * @todo in this version, only title will be analyzed.
+ * The converter keeps a snapshot of the source blocks. analyze() sends it all the blocks
+ * (used when a file is loaded), while onContentsChange() listens to QTextDocument::contentsChange
+ * and sends only the text of the blocks touched by the edit. Both are queued to the worker thread,
+ * so the cost of one keystroke on the GUI thread depends on the size of the edit
+ * instead of the document, and never includes converting.
  * 
- * 2. analyze Hexo's assets folder links and convert it
- * to local path.
+ * Front-Matter is also kept on the GUI thread in m_frontMatter,
+ * which is re-parsed only when an edit touches it.
  * 
- * @note Visit https://hexo.io/docs/asset-folders for more info
+ * The results come back by queued signals with the version of the job.
+ * Results older than the last analyze() are discarded, the others are applied to m_convertedLines
+ * and forwarded by convertedChanged() or convertedAll().
  * 
- * 3. analyze Hexo's tag plugin.
+ * @par Headless converting
  * 
- * @todo in this version, tag plugins are not processed.
- * 
- * @todo Once the text in m_connectedEditor is changed, method analyze()
- * will convert the whole document and return the whole processed document,
- * which might cause performance problem. A better way is to analyze and update one block by one block.
- * 
- * @note Visit https://hexo.io/docs/tag-plugins for more info
+ * The converted text is kept in a plain buffer (m_convertedLines), since it is mainly used to feed HPEDocument.
+ * m_viewer, a read-only QPlainTextEdit without highlighting or line numbers, is created
+ * the first time the widget is shown, and is updated only while it is visible.
 */
 class HPEConvertedMarkdownPreview : public QWidget
 {
@@ -99,43 +89,74 @@ public:
     */
     explicit HPEConvertedMarkdownPreview(HPEMarkdownEditor* connectedEditor = nullptr, QWidget *parent = nullptr);
 
+    /**
+     * @brief Stop the converter thread
+     * 
+    */
+    ~HPEConvertedMarkdownPreview();
+
 private:
 
     /**
-     * @brief Used to show converted texts
+     * @brief Used to show converted texts, created by showEvent()
      * 
     */
-    HPEMarkdownEditor* m_preview;
+    QPlainTextEdit* m_viewer = nullptr;
+
+    /**
+     * @brief Whether m_viewer misses changes made while it was hidden
+     * 
+    */
+    bool m_viewerOutdated = true;
+
+    /**
+     * @brief The converted Markdown text, one item a line
+     * 
+    */
+    QStringList m_convertedLines;
 
     /**
      * @brief Used to get document
      * 
     */
-    HPEMarkdownEditor* m_connectedEditor;
+    HPEMarkdownEditor* m_connectedEditor = nullptr;
 
     /**
      * @brief QTextDocument got from m_connectedEditor
      * 
     */
-    QTextDocument* m_connectedDocument;
+    QTextDocument* m_connectedDocument = nullptr;
+
+    /**
+     * @brief The converter and the worker thread it lives in
+     * 
+    */
+    HPEMarkdownConverter* m_converter = nullptr;
+    QThread m_converterThread;
 
     /**
-     * @brief Holds the block number of Front-Matter.
+     * @brief The number of blocks in the converter's snapshot
      * 
     */
-    BlockRange m_frontMatterBlockRange;
+    int m_sourceBlockCount = 0;
 
     /**
-     * @brief Stores converted Markdown texts
+     * @brief The version of the last job sent to the converter
      * 
     */
-    QString m_convertedMarkdown;
+    int m_sourceVersion = 0;
 
     /**
-     * @brief Stores extracted post title
+     * @brief The version of the last analyze(), results before it are stale
      * 
     */
-    QString m_title;
+    int m_resetVersion = 0;
+
+    /**
+     * @brief Front-Matter of m_connectedDocument, kept in sync by onContentsChange()
+     * 
+    */
+    HPEFrontMatter m_frontMatter;
 
     /**
      * @brief Stores the file path of current document
@@ -146,46 +167,95 @@ private:
 
     /**
      * @brief Stores the 'source' folder of current Hexo project.
-     * This property is used to link local paths of images stored in assets folder.
+     * This property is used to check if the post is in a Hexo project.
      * 
     */
     QDir m_sourceDir;
 
+    /**
+     * @brief Resolves images' paths for both m_converter and m_renderer
+     * 
+    */
+    HPEAssetResolver* m_assetResolver;
+
+    /**
+     * @brief Used to render converted Markdown to HTML natively.
+     * Images' sources are resolved by m_assetResolver.
+     * 
+     * @see renderHtml()
+    */
+    HPEMarkdownRenderer m_renderer;
+
 public:
 
     /**
      * @brief Set the editor to read document from
-     * and bind the target editor's scroll bar with m_preview's scroll bar
+     * and bind the target editor's scroll bar with m_viewer's scroll bar
      * 
      * @attention This method is essential to other following method
     */
     void connectEditor(HPEMarkdownEditor*);
 
-private:
+    /**
+     * @brief Render converted Markdown text to HTML by HPEMarkdownRenderer,
+     * with images' paths resolved by the same HPEAssetResolver as HPEMarkdownConverter.
+     * 
+     * @param[in] markdown Converted Markdown text
+     * @return HTML
+    */
+    QString renderHtml(const QString& markdown) const;
+
+    /**
+     * @brief Returns Front-Matter of the document in the connected editor
+     * 
+    */
+    const HPEFrontMatter& frontMatter() const;
+
+    /**
+     * @brief Returns the resolver of images' paths of the current post
+     * 
+    */
+    HPEAssetResolver* assetResolver() const;
+
+    /**
+     * @brief Returns the line in the converted text of the source block with blockNumber.
+     * Blocks in Front-Matter are mapped to the first line.
+     * 
+    */
+    int outputLineOfSourceBlock(int blockNumber) const;
 
     /**
-     * @brief Find Front-Matter's block number and call convertTitle()
+     * @brief Returns the converted Markdown text
      * 
-     * @pre connectEditor() is called
     */
-    void analyzeFrontMatter();
+    QString convertedText() const;
+
+protected:
 
     /**
-     * @brief Add a heading with title got from Front-Matter 
-     * at the start of m_preview
+     * @brief Create m_viewer on first show, and bring it up to date
      * 
     */
-    void convertTitle();
+    void showEvent(QShowEvent* event) override;
+
+private:
 
     /**
-     * @brief Handle and convert text in one block.
-     * This method will match and convert assets folder links. (and tag plugins)
+     * @brief Replace the lines [from, from + removedCount) of m_convertedLines with lines,
+     * and of m_viewer if it is visible.
      * 
-     * @return Converted Markdown text in a block
+     * @param[in] from The first line to be replaced
+     * @param[in] removedCount The number of lines to be replaced (at least 1)
+     * @param[in] lines New lines (at least 1)
+     * @return false if the lines are out of range
+    */
+    bool replacePreviewLines(int from, int removedCount, const QStringList& lines);
+
+    /**
+     * @brief Returns whether m_viewer exists and is visible
      * 
-     * @param[in] targetBlock The block to be processed 
     */
-    QString convertBlock(const QTextBlock&);
+    bool isViewerVisible() const;
 
 public slots:
 /**
@@ -194,15 +264,50 @@ public slots:
 */
 
     /**
-     * @brief This method will call analyzeFrontMatter() 
-     * and convert all blocks in m_connectedDocument by convertBlock().
-     * After process, it will emit convertedAll() signal
+     * @brief This method will send all blocks in m_connectedDocument to the converter.
+     * After converting, convertedAll() signal will be emitted
      * 
-     * @see analyzeFrontMatter(), convertBlock()
+     * @see HPEMarkdownConverter::reset()
      * 
     */
     void analyze();
 
+    /**
+     * @brief Executed when QTextDocument::contentsChange is emitted.
+     * Send the blocks in the changed range to the converter.
+     * 
+     * @param[in] position 
+     * @param[in] charsRemoved 
+     * @param[in] charsAdded 
+    */
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+    /**
+     * @brief Executed when the converter finishes a job converting the whole document
+     * 
+    */
+    void onConvertedAll(int version, const QString& markdown);
+
+    /**
+     * @brief Executed when the converter finishes a job converting some blocks
+     * 
+    */
+    void onConvertedChanged(int version, int from, int to, const QStringList& lines);
+
+    /**
+     * @brief Executed when the converter's snapshot doesn't match the document
+     * 
+    */
+    void onSyncLost(int version);
+
+    /**
+     * @brief Executed when an image file or a folder of them changes,
+     * converts the blocks showing any of them again so that the preview reloads them
+     * 
+     * @param[in] path The absolute path of the file or the folder
+    */
+    void onAssetsChanged(const QString& path);
+
     /**
      * @brief Executed when the file currently open in m_connectedEditor
      * got changed. This will set properties connected with file and call analyze() method to re-render.
@@ -218,6 +323,18 @@ signals:
  * @{
 */
 
+    /**
+     * @brief Emitted to queue a job converting the whole document to the converter
+     * 
+    */
+    void resetRequested(int version, const QStringList& sourceLines);
+
+    /**
+     * @brief Emitted to queue a job converting some blocks to the converter
+     * 
+    */
+    void changeRequested(int version, int firstBlock, int removedCount, const QStringList& sourceLines);
+
     /**
      * @brief This signal is emitted when analyze()
      * is done and transfer the whole converted Markdown document
@@ -225,6 +342,20 @@ signals:
     */
     void convertedAll(const QString&);
 
+    /**
+     * @brief This signal is emitted when some blocks are converted incrementally.
+     * Lines [from, to) of the last converted Markdown document are replaced by lines.
+     * 
+    */
+    void convertedChanged(int from, int to, const QStringList& lines);
+
+    /**
+     * @brief This signal is emitted when Front-Matter of the document changes
+     * 
+     * @see frontMatter()
+    */
+    void frontMatterChanged(const HPEFrontMatter& frontMatter);
+
     /**
      * @brief Emitted when error occurs and transfer error description
      * 
@@ -0,0 +1,178 @@
+/**
+ * @file hpefindbar.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpefindbar.h"
+
+#include <QCheckBox>
+#include <QGridLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+
+#include "hpemarkdowneditor.h"
+
+HPEFindBar::HPEFindBar(QWidget *parent)
+    : QFrame{parent}
+{
+    m_findField    = new QLineEdit(this);
+    m_replaceField = new QLineEdit(this);
+    m_caseSensitiveBox     = new QCheckBox(tr("Case"), this);
+    m_wholeWordsBox        = new QCheckBox(tr("Words"), this);
+    m_regularExpressionBox = new QCheckBox(tr("Regex"), this);
+    m_countLabel   = new QLabel(this);
+    QPushButton* previousButton   = new QPushButton(tr("Previous"), this);
+    QPushButton* nextButton       = new QPushButton(tr("Next"), this);
+    QPushButton* replaceButton    = new QPushButton(tr("Replace"), this);
+    m_replaceAllButton = new QPushButton(tr("Replace All"), this);
+
+    m_findField->setPlaceholderText(tr("Find"));
+    m_findField->setClearButtonEnabled(true);
+    m_replaceField->setPlaceholderText(tr("Replace"));
+
+    QGridLayout* layout = new QGridLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_findField,            0, 0);
+    layout->addWidget(previousButton,         0, 1);
+    layout->addWidget(nextButton,             0, 2);
+    layout->addWidget(m_countLabel,           0, 3, 1, 3);
+    layout->addWidget(m_replaceField,         1, 0);
+    layout->addWidget(replaceButton,          1, 1);
+    layout->addWidget(m_replaceAllButton,     1, 2);
+    layout->addWidget(m_caseSensitiveBox,     1, 3);
+    layout->addWidget(m_wholeWordsBox,        1, 4);
+    layout->addWidget(m_regularExpressionBox, 1, 5);
+    layout->setColumnStretch(0, 1);
+
+    connect(m_findField, &QLineEdit::textChanged, this, &HPEFindBar::updateSearch);
+    connect(m_caseSensitiveBox,     &QCheckBox::toggled, this, &HPEFindBar::updateSearch);
+    connect(m_wholeWordsBox,        &QCheckBox::toggled, this, &HPEFindBar::updateSearch);
+    connect(m_regularExpressionBox, &QCheckBox::toggled, this, &HPEFindBar::updateSearch);
+    connect(m_findField,    &QLineEdit::returnPressed, this, &HPEFindBar::findNext);
+    connect(m_replaceField, &QLineEdit::returnPressed, this, &HPEFindBar::replace);
+    connect(previousButton,     &QPushButton::clicked, this, &HPEFindBar::findPrevious);
+    connect(nextButton,         &QPushButton::clicked, this, &HPEFindBar::findNext);
+    connect(replaceButton,      &QPushButton::clicked, this, &HPEFindBar::replace);
+    connect(m_replaceAllButton, &QPushButton::clicked, this, &HPEFindBar::replaceAll);
+}
+
+void HPEFindBar::connectEditor(HPEMarkdownEditor *editor)
+{
+    m_connectedEditor = editor;
+}
+
+void HPEFindBar::keyPressEvent(QKeyEvent *event)
+{
+    if(event->key() != Qt::Key_Escape)
+    {
+        QFrame::keyPressEvent(event);
+        return;
+    }
+    this->hide();
+    if(m_connectedEditor)
+        m_connectedEditor->setFocus();
+}
+
+void HPEFindBar::hideEvent(QHideEvent *event)
+{
+    QFrame::hideEvent(event);
+    if(m_connectedEditor)
+        m_connectedEditor->clearSearch();
+}
+
+HPETextSearcher::Options HPEFindBar::options() const
+{
+    HPETextSearcher::Options options;
+    if(m_caseSensitiveBox->isChecked())
+        options |= HPETextSearcher::CaseSensitive;
+    if(m_wholeWordsBox->isChecked())
+        options |= HPETextSearcher::WholeWords;
+    if(m_regularExpressionBox->isChecked())
+        options |= HPETextSearcher::RegularExpression;
+    return options;
+}
+
+void HPEFindBar::activate()
+{
+    if(!m_connectedEditor)
+        return;
+
+    //a selection across lines cannot be matched
+    QString selection = m_connectedEditor->textCursor().selectedText();
+    if(!selection.isEmpty() && !selection.contains(QChar::ParagraphSeparator))
+        m_findField->setText(m_regularExpressionBox->isChecked() ? QRegularExpression::escape(selection) : selection);
+
+    this->show();
+    this->updateSearch();
+    m_findField->setFocus();
+    m_findField->selectAll();
+}
+
+void HPEFindBar::updateSearch()
+{
+    if(!m_connectedEditor || !this->isVisible())
+        return;
+
+    m_connectedEditor->setSearch(m_findField->text(), this->options());
+    this->updateCount();
+}
+
+void HPEFindBar::updateCount()
+{
+    if(!m_connectedEditor)
+        return;
+
+    //only the window of a large file is in the editor
+    const bool largeFileMode = m_connectedEditor->isLargeFileMode();
+    m_replaceAllButton->setEnabled(!largeFileMode);
+    m_replaceAllButton->setToolTip(largeFileMode ? tr("Not available for large files") : QString());
+
+    const HPETextSearcher& searcher = m_connectedEditor->searcher();
+    if(searcher.pattern().isEmpty())
+        m_countLabel->clear();
+    else if(!searcher.isValid())
+        m_countLabel->setText(searcher.errorString());
+    else if(largeFileMode)
+        m_countLabel->setText(tr("%n match(es) in window", "", m_connectedEditor->matchCount()));
+    else
+        m_countLabel->setText(tr("%n match(es)", "", m_connectedEditor->matchCount()));
+}
+
+void HPEFindBar::findNext()
+{
+    if(m_connectedEditor)
+        m_connectedEditor->findNext();
+}
+
+void HPEFindBar::findPrevious()
+{
+    if(m_connectedEditor)
+        m_connectedEditor->findNext(true);
+}
+
+void HPEFindBar::replace()
+{
+    if(!m_connectedEditor)
+        return;
+
+    m_connectedEditor->replaceCurrent(m_replaceField->text());
+    this->updateCount();
+}
+
+void HPEFindBar::replaceAll()
+{
+    if(!m_connectedEditor)
+        return;
+
+    m_connectedEditor->replaceAll(m_replaceField->text());
+    this->updateCount();
+}
@@ -0,0 +1,127 @@
+/**
+ * @file hpefindbar.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEFINDBAR_H
+#define HPEFINDBAR_H
+
+#include <QFrame>
+
+#include "Controller/hpetextsearcher.h"
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class HPEMarkdownEditor;
+
+/**
+ * @class HPEFindBar
+ * @brief The find and replace fields of an HPEMarkdownEditor
+ * @since 1.0.0
+ * 
+ * @ingroup widgets
+ * @ingroup editor
+ * 
+ * HPEFindBar passes what is typed to HPEMarkdownEditor::setSearch(), which highlights the visible matches,
+ * and its buttons to findNext(), replaceCurrent() and replaceAll().
+ * The search is cleared when the bar is hidden, by Escape.
+ * 
+ * In large-file mode the editor holds only a window of the file: the count is labeled as the window's,
+ * and Replace All is disabled.
+*/
+class HPEFindBar : public QFrame
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct a new HPEFindBar with parent
+     * 
+     * @param[in] parent
+    */
+    explicit HPEFindBar(QWidget* parent = nullptr);
+
+    /**
+     * @brief Search in editor
+     * 
+    */
+    void connectEditor(HPEMarkdownEditor* editor);
+
+protected:
+
+    /**
+     * @brief Hide the bar on Escape
+     * 
+    */
+    void keyPressEvent(QKeyEvent* event) override;
+
+    /**
+     * @brief Clear the search of the editor
+     * 
+    */
+    void hideEvent(QHideEvent* event) override;
+
+private:
+
+    /**
+     * @brief Returns the options checked
+     * 
+    */
+    HPETextSearcher::Options options() const;
+
+    HPEMarkdownEditor* m_connectedEditor = nullptr;
+
+    QLineEdit* m_findField;
+    QLineEdit* m_replaceField;
+    QCheckBox* m_caseSensitiveBox;
+    QCheckBox* m_wholeWordsBox;
+    QCheckBox* m_regularExpressionBox;
+    QLabel*    m_countLabel;
+    QPushButton* m_replaceAllButton;
+
+public slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Show the bar and focus the find field, filled with the selection of the editor
+     * 
+    */
+    void activate();
+
+private slots:
+
+    /**
+     * @brief Pass the pattern and the options to the editor
+     * 
+    */
+    void updateSearch();
+
+    /**
+     * @brief Show the number of matches, or why the pattern is invalid,
+     * and enable Replace All unless the editor is in large-file mode
+     * 
+    */
+    void updateCount();
+
+    void findNext();
+    void findPrevious();
+    void replace();
+    void replaceAll();
+/**
+ * @}
+*/
+};
+
+#endif // HPEFINDBAR_H
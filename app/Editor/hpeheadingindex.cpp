@@ -0,0 +1,107 @@
+/**
+ * @file hpeheadingindex.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpeheadingindex.h"
+
+#include <QTextBlock>
+
+#include <algorithm>
+
+HPEHeadingIndex::HPEHeadingIndex(QObject *parent)
+    : QAbstractListModel{parent} { }
+
+void HPEHeadingIndex::setHeading(const QTextBlock &block, int level, const QString &title)
+{
+    int from = lowerBound(block.position());
+    int to   = lowerBound(block.position() + block.length());
+
+    if(level > 0 && to == from + 1 && m_headings.at(from).cursor.position() == block.position())
+    {
+        //the heading is edited, or highlighted again
+        Entry& entry = m_headings[from];
+        if(entry.level != level || entry.title != title)
+        {
+            entry.level = level;
+            entry.title = title;
+            emit dataChanged(index(from), index(from));
+        }
+        return;
+    }
+
+    if(to > from)
+    {
+        beginRemoveRows(QModelIndex(), from, to - 1);
+        m_headings.remove(from, to - from);
+        endRemoveRows();
+    }
+    if(level > 0)
+    {
+        //text typed at the start of the block goes after the cursor
+        QTextCursor cursor(block);
+        cursor.setKeepPositionOnInsert(true);
+        beginInsertRows(QModelIndex(), from, from);
+        m_headings.insert(from, { cursor, level, title });
+        endInsertRows();
+    }
+}
+
+int HPEHeadingIndex::count() const
+{
+    return m_headings.size();
+}
+
+HPEHeadingIndex::Heading HPEHeadingIndex::heading(int i) const
+{
+    const Entry& entry = m_headings.at(i);
+    return { entry.level, entry.title, entry.cursor.blockNumber(), entry.cursor.position() };
+}
+
+int HPEHeadingIndex::sectionAt(int position) const
+{
+    auto it = std::upper_bound(m_headings.cbegin(), m_headings.cend(), position, [](int position, const Entry& entry){
+        return position < entry.cursor.position();
+    });
+    return int(it - m_headings.cbegin()) - 1;
+}
+
+int HPEHeadingIndex::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_headings.size();
+}
+
+QVariant HPEHeadingIndex::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_headings.size())
+        return QVariant();
+
+    const Entry& entry = m_headings.at(index.row());
+    switch(role)
+    {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        return entry.title;
+    case LevelRole:
+        return entry.level;
+    case BlockNumberRole:
+        return entry.cursor.blockNumber();
+    default:
+        return QVariant();
+    }
+}
+
+int HPEHeadingIndex::lowerBound(int position) const
+{
+    auto it = std::lower_bound(m_headings.cbegin(), m_headings.cend(), position, [](const Entry& entry, int position){
+        return entry.cursor.position() < position;
+    });
+    return int(it - m_headings.cbegin());
+}
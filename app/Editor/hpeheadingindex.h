@@ -0,0 +1,124 @@
+/**
+ * @file hpeheadingindex.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEHEADINGINDEX_H
+#define HPEHEADINGINDEX_H
+
+#include <QAbstractListModel>
+#include <QTextCursor>
+#include <QVector>
+
+class QTextBlock;
+
+/**
+ * @class HPEHeadingIndex
+ * @brief The headings of a document, as a list model ordered by position
+ * @since 1.0.0
+ * 
+ * @ingroup editor
+ * 
+ * HPEHeadingIndex is fed by HPESyntaxHighlighter: every block it highlights is passed to setHeading(),
+ * with the level of the heading it found, or 0. So the index reuses the highlighter's detection
+ * (headings in code fences or Front-Matter are not headings), and is updated only for the blocks
+ * an edit touches.
+ * 
+ * Each heading is kept with a QTextCursor at the start of its block, which the document moves
+ * with every edit, so the headings stay ordered by position without being renumbered.
+ * Finding a heading by position, like the section of the text cursor, is a binary search.
+ * 
+ * @par Removed blocks
+ * 
+ * The cursor of a removed heading collapses to where the text is removed, which is inside
+ * the first block the highlighter highlights again; setHeading() drops every heading
+ * inside the block it is given before adding the block's own.
+ * 
+ * @see HPEOutlinePanel
+*/
+class HPEHeadingIndex : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief The roles of data(), Qt::DisplayRole is the title
+     * 
+    */
+    enum Role
+    {
+        LevelRole = Qt::UserRole,
+        BlockNumberRole
+    };
+
+    struct Heading
+    {
+        int level;
+        QString title;
+        int blockNumber;
+        int position;
+    };
+
+    /**
+     * @brief Construct an empty HPEHeadingIndex with parent
+     * 
+     * @param[in] parent
+    */
+    explicit HPEHeadingIndex(QObject* parent = nullptr);
+
+    /**
+     * @brief Set the heading of block, level 0 if it isn't a heading
+     * 
+     * @param[in] block A block just highlighted
+     * @param[in] level From 1
+     * @param[in] title The text after the '#'s
+    */
+    void setHeading(const QTextBlock& block, int level, const QString& title);
+
+    /**
+     * @brief Returns the number of headings
+     * 
+    */
+    int count() const;
+
+    /**
+     * @brief Returns the i-th heading
+     * 
+    */
+    Heading heading(int i) const;
+
+    /**
+     * @brief Returns the heading whose section contains position, -1 if position is before all headings
+     * 
+    */
+    int sectionAt(int position) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+
+    struct Entry
+    {
+        QTextCursor cursor;
+        int level;
+        QString title;
+    };
+
+    /**
+     * @brief Returns the first heading not before position
+     * 
+    */
+    int lowerBound(int position) const;
+
+    QVector<Entry> m_headings;
+};
+
+#endif // HPEHEADINGINDEX_H
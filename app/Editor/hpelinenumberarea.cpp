@@ -12,17 +12,127 @@
 
 #include "hpelinenumberarea.h"
 
+#include <QPainter>
+#include <QPaintEvent>
+
 #include "hpemarkdowneditor.h"
 
 HPELineNumberArea::HPELineNumberArea(HPEMarkdownEditor* editor, QWidget* /*parent*/)
-    : QWidget(editor), editor(editor) {  }
+    : QWidget(editor), editor(editor)
+{
+    setDigitFont(editor->font());
+}
 
 QSize HPELineNumberArea::sizeHint() const
 {
     return QSize(editor->lineNumberAreaWidth(), 0);
 }
 
+int HPELineNumberArea::areaWidth() const
+{
+    return 3 + m_digitWidth * m_digitCount;
+}
+
+bool HPELineNumberArea::setDigitCount(int digits)
+{
+    if(digits == m_digitCount)
+        return false;
+    m_digitCount = digits;
+    return true;
+}
+
+void HPELineNumberArea::setDigitFont(const QFont &font)
+{
+    QFontMetrics metrics(font);
+    m_digitFont = font;
+    m_digitWidth = 0;
+    for(char digit = '0'; digit <= '9'; ++digit)
+        m_digitWidth = qMax(m_digitWidth, metrics.horizontalAdvance(QLatin1Char(digit)));
+    m_digitHeight = metrics.height();
+    m_digitAtlas = QPixmap();
+    update();
+}
+
+void HPELineNumberArea::setRows(const QVector<Row> &rows)
+{
+    //both are ordered by number, repaint the rows which appear, disappear or move
+    QRegion dirty;
+    int i = 0, j = 0;
+    while(i < m_rows.size() || j < rows.size())
+    {
+        if(j == rows.size() || (i < m_rows.size() && m_rows.at(i).number < rows.at(j).number))
+            dirty += rectOf(m_rows.at(i++));
+        else if(i == m_rows.size() || rows.at(j).number < m_rows.at(i).number)
+            dirty += rectOf(rows.at(j++));
+        else
+        {
+            if(m_rows.at(i) != rows.at(j))
+            {
+                dirty += rectOf(m_rows.at(i));
+                dirty += rectOf(rows.at(j));
+            }
+            ++i;
+            ++j;
+        }
+    }
+
+    m_rows = rows;
+    if(!dirty.isEmpty())
+        update(dirty);
+}
+
+void HPELineNumberArea::scrollRows(int dy)
+{
+    scroll(0, dy);
+    for(Row& row : m_rows)
+        row.top += dy;
+}
+
 void HPELineNumberArea::paintEvent(QPaintEvent *event)
 {
-    editor->lineNumberAreaPaintEvent(event);
+    if(m_digitAtlas.isNull() || m_digitAtlas.devicePixelRatio() != devicePixelRatioF())
+        renderDigitAtlas();
+
+    QPainter painter(this);
+    const QRect& rect = event->rect();
+    const qreal ratio = m_digitAtlas.devicePixelRatio();
+    for(const Row& row : qAsConst(m_rows))
+    {
+        if(row.top > rect.bottom())
+            break;
+        if(row.top + row.height < rect.top())
+            continue;
+
+        //right aligned, from the last digit
+        int x = width();
+        int number = row.number;
+        do
+        {
+            x -= m_digitWidth;
+            painter.drawPixmap(QRectF(x, row.top, m_digitWidth, m_digitHeight), m_digitAtlas,
+                               QRectF(number % 10 * m_digitWidth * ratio, 0, m_digitWidth * ratio, m_digitHeight * ratio));
+            number /= 10;
+        }
+        while(number > 0);
+    }
+}
+
+void HPELineNumberArea::renderDigitAtlas()
+{
+    const qreal ratio = devicePixelRatioF();
+    m_digitAtlas = QPixmap(QSize(m_digitWidth * 10, m_digitHeight) * ratio);
+    m_digitAtlas.setDevicePixelRatio(ratio);
+    m_digitAtlas.fill(Qt::transparent);
+
+    QPainter painter(&m_digitAtlas);
+    painter.setFont(m_digitFont);
+    painter.setPen(QColor(0, 0, 0, 30));
+    for(int digit = 0; digit < 10; ++digit)
+        painter.drawText(QRect(digit * m_digitWidth, 0, m_digitWidth, m_digitHeight),
+                         Qt::AlignHCenter | Qt::AlignTop, QString(QChar(u'0' + digit)));
+}
+
+QRect HPELineNumberArea::rectOf(const Row &row) const
+{
+    return QRect(0, row.top, width(), row.height);
 }
@@ -14,6 +14,7 @@
 #define HPELINENUMBERAREA_H
 
 #include <QWidget>
+#include <QPixmap>
 
 class HPEMarkdownEditor;
 
@@ -28,6 +29,19 @@ class HPEMarkdownEditor;
  * A widget set on the left side of an editor, showing line numbers.
  * This class overrides QWidget's sizeHint() and paintEvent().
  * 
+ * @par Rendering
+ * 
+ * The digits are rendered once into an atlas pixmap (again when the font or the device
+ * pixel ratio changes), and a number is painted by copying its digits from the atlas,
+ * so painting doesn't format or shape any text.
+ * 
+ * The editor passes the visible rows with setRows() on every update of its viewport.
+ * Only the rows whose number or geometry changed are repainted. When the editor scrolls,
+ * the painted rows are moved by scrollRows() and only the exposed rows are painted.
+ * 
+ * The width depends only on the digit count, so it is recomputed when the digit count
+ * or the font changes.
+ * 
  * Visit {https://doc.qt.io/qt-6/qtwidgets-widgets-codeeditor-example.html}{Code Editor Example}
  * for more information.
  * 
@@ -47,14 +61,92 @@ public:
     */
     explicit HPELineNumberArea(HPEMarkdownEditor* editor, QWidget *parent = nullptr);
 
+    /**
+     * @brief A visible line: its number (from 1) and its geometry in the area
+     * 
+    */
+    struct Row
+    {
+        int number;
+        int top;
+        int height;
+
+        bool operator==(const Row& other) const
+        {
+            return number == other.number && top == other.top && height == other.height;
+        }
+        bool operator!=(const Row& other) const { return !(*this == other); }
+    };
+
     /**
      * @brief Overrides QWidget::sizeHint()
     */
     QSize sizeHint() const override;
 
+    /**
+     * @brief Returns the width needed by the current digit count
+     * 
+    */
+    int areaWidth() const;
+
+    /**
+     * @brief Set the number of digits of the largest line number
+     * 
+     * @return true if areaWidth() changed
+    */
+    bool setDigitCount(int digits);
+
+    /**
+     * @brief Measure the digits of font, the font of the editor.
+     * The atlas is rendered again at the next paint.
+     * 
+    */
+    void setDigitFont(const QFont& font);
+
+    /**
+     * @brief Set the visible rows, ordered by number, and repaint the rows that changed
+     * 
+    */
+    void setRows(const QVector<Row>& rows);
+
+    /**
+     * @brief Scroll the painted rows by dy pixels
+     * 
+    */
+    void scrollRows(int dy);
+
 private:
     HPEMarkdownEditor* editor;
 
+    /**
+     * @brief Render the digits 0 - 9 into m_digitAtlas
+     * 
+    */
+    void renderDigitAtlas();
+
+    /**
+     * @brief Returns the rectangle of row in the area
+     * 
+    */
+    QRect rectOf(const Row& row) const;
+
+    QFont m_digitFont;
+    int m_digitWidth = 0;
+    int m_digitHeight = 0;
+    int m_digitCount = 1;
+
+    /**
+     * @brief The digits 0 - 9 from left to right, each in a cell of m_digitWidth
+     * 
+    */
+    QPixmap m_digitAtlas;
+
+    /**
+     * @brief The rows painted
+     * 
+    */
+    QVector<Row> m_rows;
+
 protected:
 
     /**
@@ -0,0 +1,176 @@
+/**
+ * @file hpelinkindex.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpelinkindex.h"
+
+#include <QTextDocument>
+
+#include "Controller/hpeassetresolver.h"
+
+#include <algorithm>
+
+/**
+ * @brief The matches of a block, registered in the index while the block lives
+ * 
+*/
+class HPELinkIndex::BlockData : public QTextBlockUserData
+{
+public:
+    BlockData(HPELinkIndex* index, const QTextBlock& block, const QVector<Entry>& entries)
+        : index(index), block(block), entries(entries)
+    {
+        index->m_blocks.insert(this);
+        index->m_count += entries.size();
+    }
+
+    ~BlockData() override
+    {
+        if(!index)
+            return;
+        index->m_blocks.remove(this);
+        index->m_count -= entries.size();
+    }
+
+    /**
+     * @brief Null once the index is destroyed
+     * 
+    */
+    HPELinkIndex* index;
+    QTextBlock block;
+    QVector<Entry> entries;
+};
+
+static bool isAny(HPELinkScanner::Kind)
+{
+    return true;
+}
+
+static bool isLink(HPELinkScanner::Kind kind)
+{
+    return kind == HPELinkScanner::Link;
+}
+
+static bool isImage(HPELinkScanner::Kind kind)
+{
+    return kind != HPELinkScanner::Link;
+}
+
+HPELinkIndex::HPELinkIndex(QTextDocument *document)
+    : QObject{document}, m_document(document)
+{
+    connect(m_document, &QTextDocument::contentsChange, this, &HPELinkIndex::onContentsChange);
+    for(QTextBlock block = m_document->begin(); block.isValid(); block = block.next())
+        indexBlock(block);
+}
+
+HPELinkIndex::~HPELinkIndex()
+{
+    //the blocks may outlive the index
+    for(BlockData* data : qAsConst(m_blocks))
+        data->index = nullptr;
+}
+
+QVector<HPELinkIndex::Entry> HPELinkIndex::links() const
+{
+    return collect(isLink);
+}
+
+QVector<HPELinkIndex::Entry> HPELinkIndex::images() const
+{
+    return collect(isImage);
+}
+
+QVector<HPELinkIndex::Entry> HPELinkIndex::entries(int firstBlock, int lastBlock) const
+{
+    QVector<Entry> result;
+    int blockNumber = qMax(0, firstBlock);
+    for(QTextBlock block = m_document->findBlockByNumber(blockNumber); block.isValid() && blockNumber <= lastBlock;
+        block = block.next(), ++blockNumber)
+        if(const BlockData* data = static_cast<const BlockData*>(block.userData()))
+            appendEntries(data, blockNumber, isAny, result);
+    return result;
+}
+
+QVector<HPELinkIndex::Entry> HPELinkIndex::missingImages(HPEAssetResolver *resolver) const
+{
+    QVector<Entry> result;
+    if(!resolver)
+        return result;
+
+    for(const Entry& entry : images())
+    {
+        HPEAssetResolver::Asset asset = resolver->resolve(entry.url);
+        if(!asset.exists && !asset.filePath.isEmpty())
+            result.append(entry);
+    }
+    return result;
+}
+
+int HPELinkIndex::count() const
+{
+    return m_count;
+}
+
+void HPELinkIndex::indexBlock(QTextBlock block)
+{
+    const QString text = block.text();
+    QVector<Entry> entries;
+    HPELinkScanner scanner(text);
+    HPELinkScanner::Match match;
+    while(scanner.next(match))
+        entries.append({ match.kind, -1, int(match.start), int(match.length),
+                         text.mid(match.textStart, match.textLength), text.mid(match.urlStart, match.urlLength) });
+
+    //the previous data of the block is deleted
+    block.setUserData(entries.isEmpty() ? nullptr : new BlockData(this, block, entries));
+}
+
+QVector<HPELinkIndex::Entry> HPELinkIndex::collect(bool (*accept)(HPELinkScanner::Kind)) const
+{
+    QVector<QPair<int, const BlockData*>> blocks;
+    blocks.reserve(m_blocks.size());
+    for(const BlockData* data : m_blocks)
+        blocks.append({ data->block.blockNumber(), data });
+    std::sort(blocks.begin(), blocks.end(), [](const QPair<int, const BlockData*>& a, const QPair<int, const BlockData*>& b){
+        return a.first < b.first;
+    });
+
+    QVector<Entry> result;
+    for(const QPair<int, const BlockData*>& block : qAsConst(blocks))
+        appendEntries(block.second, block.first, accept, result);
+    return result;
+}
+
+void HPELinkIndex::appendEntries(const BlockData *data, int blockNumber,
+                                 bool (*accept)(HPELinkScanner::Kind), QVector<Entry> &result)
+{
+    for(const Entry& entry : data->entries)
+        if(accept(entry.kind))
+        {
+            result.append(entry);
+            result.last().blockNumber = blockNumber;
+        }
+}
+
+void HPELinkIndex::onContentsChange(int position, int /*charsRemoved*/, int charsAdded)
+{
+    QTextBlock block = m_document->findBlock(position);
+    QTextBlock last  = m_document->findBlock(position + charsAdded);
+    if(!last.isValid())
+        last = m_document->lastBlock();
+    for(; block.isValid(); block = block.next())
+    {
+        indexBlock(block);
+        if(block == last)
+            break;
+    }
+}
@@ -0,0 +1,173 @@
+/**
+ * @file hpelinkindex.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPELINKINDEX_H
+#define HPELINKINDEX_H
+
+#include <QObject>
+#include <QSet>
+#include <QTextBlock>
+#include <QVector>
+
+#include "Controller/hpelinkscanner.h"
+
+class HPEAssetResolver;
+
+/**
+ * @class HPELinkIndex
+ * @brief A live index of the links and images of a QTextDocument
+ * @since 1.0.0
+ * 
+ * @ingroup editor
+ * 
+ * HPELinkIndex keeps the matches HPELinkScanner finds in every block of a document.
+ * It listens to QTextDocument::contentsChange and scans again only the blocks an edit touches,
+ * so keeping the index costs O(changes), never O(document).
+ * 
+ * The matches of a block are stored in the block's user data, which moves with the block
+ * and is deleted with it. The blocks having matches are also kept in a set, so
+ * the queries walk only those blocks, or the blocks of the asked range.
+ * 
+ * @code
+ *      HPELinkIndex* index = new HPELinkIndex(editor->document());
+ *      for(const HPELinkIndex::Entry& entry : index->missingImages(resolver))
+ *          qDebug() << entry.blockNumber << entry.url;
+ * @endcode
+ * 
+ * @note The block user data of the document is owned by HPELinkIndex.
+*/
+class HPELinkIndex : public QObject
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief A link or an image of the document
+     * 
+    */
+    struct Entry
+    {
+        HPELinkScanner::Kind kind;
+
+        int blockNumber;
+
+        /**
+         * @brief The whole link, image or tag, position is an offset into the block
+         * 
+        */
+        int position;
+        int length;
+
+        /**
+         * @brief The text of a link or the alt of an image
+         * 
+        */
+        QString text;
+
+        /**
+         * @brief The destination of a link or the source of an image
+         * 
+        */
+        QString url;
+    };
+
+    /**
+     * @brief Construct an HPELinkIndex of document, which becomes its parent.
+     * The existing text is indexed at once.
+     * 
+     * @param[in] document
+    */
+    explicit HPELinkIndex(QTextDocument* document);
+
+    ~HPELinkIndex();
+
+    /**
+     * @brief Returns the links, ordered by position
+     * 
+    */
+    QVector<Entry> links() const;
+
+    /**
+     * @brief Returns the images, raw <img> tags included, ordered by position
+     * 
+    */
+    QVector<Entry> images() const;
+
+    /**
+     * @brief Returns the links and images in the blocks [firstBlock, lastBlock], ordered by position
+     * 
+    */
+    QVector<Entry> entries(int firstBlock, int lastBlock) const;
+
+    /**
+     * @brief Returns the local images (not URLs) whose files don't exist, ordered by position
+     * 
+     * @param[in] resolver Resolves the sources of images, its cache makes this O(images)
+    */
+    QVector<Entry> missingImages(HPEAssetResolver* resolver) const;
+
+    /**
+     * @brief Returns the number of links and images
+     * 
+    */
+    int count() const;
+
+private:
+
+    class BlockData;
+
+    /**
+     * @brief Scan block and store its matches
+     * 
+    */
+    void indexBlock(QTextBlock block);
+
+    /**
+     * @brief Returns the entries of the indexed blocks whose kind passes accept, ordered by position
+     * 
+    */
+    QVector<Entry> collect(bool (*accept)(HPELinkScanner::Kind)) const;
+
+    /**
+     * @brief Append the entries of data whose kind passes accept to result
+     * 
+    */
+    static void appendEntries(const BlockData* data, int blockNumber,
+                              bool (*accept)(HPELinkScanner::Kind), QVector<Entry>& result);
+
+    QTextDocument* m_document;
+
+    /**
+     * @brief The user data of the blocks having matches
+     * 
+    */
+    QSet<BlockData*> m_blocks;
+
+    int m_count = 0;
+
+private slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Scan the blocks from position to position + charsAdded again
+     * 
+    */
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+/**
+ * @}
+*/
+};
+
+#endif // HPELINKINDEX_H
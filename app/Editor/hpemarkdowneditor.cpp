@@ -12,22 +12,47 @@
 
 #include "hpemarkdowneditor.h"
 
-#include <QPainter>
+#include <QScrollBar>
 #include <QTextBlock>
-#include <QRegularExpression>
 
+#include "hpeheadingindex.h"
 #include "hpelinenumberarea.h"
+#include "hpelinkindex.h"
 #include "hpesyntaxhighlighter.h"
+#include "Controller/hpepiecetable.h"
 
 HPEMarkdownEditor::HPEMarkdownEditor(QWidget* parent)
         : QPlainTextEdit(parent)
 {
     m_lineNumberArea = new HPELineNumberArea(this);
     m_highlighter = new HPESyntaxHighlighter(document());
+    m_linkIndex = new HPELinkIndex(document());
+    m_headingIndex = new HPEHeadingIndex(this);
+    m_highlighter->setHeadingIndex(m_headingIndex);
 
     connect(this, &HPEMarkdownEditor::blockCountChanged, this, &HPEMarkdownEditor::updateLineNumberAreaWidth);
     connect(this, &HPEMarkdownEditor::updateRequest, this, &HPEMarkdownEditor::updateLineNumberArea);
     connect(this, &HPEMarkdownEditor::cursorPositionChanged, this, &HPEMarkdownEditor::highlightCurrentLine);
+    connect(this->verticalScrollBar(), &QScrollBar::valueChanged, this, &HPEMarkdownEditor::highlightVisibleBlocks);
+    connect(this->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &HPEMarkdownEditor::slideWindow, Qt::QueuedConnection);
+    connect(this->document(), &QTextDocument::contentsChanged, this, [this]{ m_windowModified = true; });
+
+    //the matches are found again once the scrolling or the editing is done
+    m_matchSelectionTimer.setSingleShot(true);
+    m_matchSelectionTimer.setInterval(0);
+    connect(&m_matchSelectionTimer, &QTimer::timeout, this, &HPEMarkdownEditor::updateMatchSelections);
+    connect(this->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]{
+        if(m_searcher.isValid())
+            m_matchSelectionTimer.start();
+    });
+    connect(this->document(), &QTextDocument::contentsChanged, this, [this]{
+        m_matchCount = -1;
+        if(m_searcher.isValid())
+            m_matchSelectionTimer.start();
+    });
+    connect(m_highlighter, &HPESyntaxHighlighter::progressChanged,
+            this, &HPEMarkdownEditor::highlightingProgressChanged);
 
     this->setLineWidth(0);
     this->setFrameShape(QFrame::NoFrame);
@@ -36,9 +61,119 @@ HPEMarkdownEditor::HPEMarkdownEditor(QWidget* parent)
 
     //init line number
     this->updateLineNumberAreaWidth(0);
+    this->setViewportMargins(this->lineNumberAreaWidth(), 0, 0, 0);
     highlightCurrentLine();
 }
 
+HPEMarkdownEditor::~HPEMarkdownEditor() { }
+
+void HPEMarkdownEditor::loadText(const QString &text)
+{
+    m_pieceTable.reset();
+    m_windowFirst = m_windowLineCount = 0;
+    this->setDocumentText(text);
+}
+
+bool HPEMarkdownEditor::loadLargeFile(const QString &filePath, QString *errorString)
+{
+    QScopedPointer<HPEPieceTable> pieceTable(new HPEPieceTable);
+    if(!pieceTable->open(filePath))
+    {
+        if(errorString)
+            *errorString = pieceTable->errorString();
+        return false;
+    }
+
+    m_pieceTable.swap(pieceTable);
+    this->loadWindow(0);
+    this->document()->setModified(false);
+    return true;
+}
+
+bool HPEMarkdownEditor::saveLargeFile(const QString &filePath, QString *errorString)
+{
+    if(!m_pieceTable)
+        return false;
+
+    this->commitWindow();
+    if(!m_pieceTable->save(filePath))
+    {
+        if(errorString)
+            *errorString = m_pieceTable->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool HPEMarkdownEditor::isLargeFileMode() const
+{
+    return !m_pieceTable.isNull();
+}
+
+qint64 HPEMarkdownEditor::lineCount() const
+{
+    if(!m_pieceTable)
+        return this->blockCount();
+    return m_pieceTable->lineCount() - m_windowLineCount + this->blockCount();
+}
+
+void HPEMarkdownEditor::setDocumentText(const QString &text)
+{
+    m_highlighter->setHighlightingDeferred(text.size() >= DEFERRED_HIGHLIGHT_THRESHOLD);
+    this->setPlainText(text);
+    this->highlightVisibleBlocks();
+    m_windowModified = false;
+}
+
+void HPEMarkdownEditor::loadWindow(qint64 first)
+{
+    bool modified = this->document()->isModified() || m_pieceTable->isModified();
+    m_windowFirst = first;
+    m_windowLineCount = qMin(qint64(WINDOW_LINES), m_pieceTable->lineCount() - first);
+    this->setDocumentText(m_pieceTable->lines(first, m_windowLineCount));
+    this->document()->setModified(modified);
+    this->updateLineNumberAreaWidth(0);
+}
+
+void HPEMarkdownEditor::commitWindow()
+{
+    if(!m_pieceTable || !m_windowModified)
+        return;
+
+    m_pieceTable->replaceLines(m_windowFirst, m_windowLineCount, this->toPlainText());
+    m_windowLineCount = this->blockCount();
+    m_windowModified = false;
+}
+
+double HPEMarkdownEditor::highlightingProgress() const
+{
+    return m_highlighter->progress();
+}
+
+void HPEMarkdownEditor::beginEdit()
+{
+    if(m_editDepth++ > 0)
+        return;
+
+    //the edit block of the document holds the changes of every cursor
+    m_editCursor = QTextCursor(this->document());
+    m_editCursor.beginEditBlock();
+}
+
+void HPEMarkdownEditor::commitEdit()
+{
+    if(m_editDepth == 0 || --m_editDepth > 0)
+        return;
+
+    m_editCursor.endEditBlock();
+    m_editCursor = QTextCursor();
+}
+
+bool HPEMarkdownEditor::isEditing() const
+{
+    return m_editDepth > 0;
+}
+
 void HPEMarkdownEditor::wrapSelectionWithString(const QString& str)
 {
     this->wrapSelectionWithString(str, str);
@@ -47,6 +182,7 @@ void HPEMarkdownEditor::wrapSelectionWithString(const QString& str)
 void HPEMarkdownEditor::wrapSelectionWithString(const QString& leftStr, const QString& rightStr)
 {
     QTextCursor newCursor(this->textCursor());
+    this->beginEdit();
     if(this->textCursor().hasSelection())
     {
         int start = this->textCursor().selectionStart();
@@ -56,103 +192,232 @@ void HPEMarkdownEditor::wrapSelectionWithString(const QString& leftStr, const QS
         newCursor.insertText(" " + leftStr);
         newCursor.setPosition(end + 1 + leftStr.length());
         newCursor.insertText(rightStr + " ");
-        this->setTextCursor(newCursor);
     }
     else
     {
         int start = this->textCursor().position();
         newCursor.insertText(" " + leftStr + rightStr + " ");
         newCursor.setPosition(start + 1 + leftStr.length());
-        this->setTextCursor(newCursor);
     }
+    this->commitEdit();
+    this->setTextCursor(newCursor);
 }
 
 void HPEMarkdownEditor::insertString(const QString& str, bool atNewLine)
 {
     QTextCursor newCursor(this->textCursor());
+    this->beginEdit();
     if(atNewLine)
     {
         bool isAtLineStart = this->textCursor().atBlockStart();
-        if(!isAtLineStart)
-            newCursor.movePosition(QTextCursor::Down);
-
-        newCursor.movePosition(QTextCursor::StartOfLine);
-        newCursor.insertText(str);
-
-        if(!isAtLineStart)
+        if(!isAtLineStart && !newCursor.block().next().isValid())
         {
+            //there is no next line to insert before, add one after the last
+            newCursor.movePosition(QTextCursor::EndOfBlock);
             newCursor.insertBlock();
-            newCursor.movePosition(QTextCursor::Up);
-            newCursor.movePosition(QTextCursor::EndOfLine);
+            newCursor.insertText(str);
+        }
+        else
+        {
+            if(!isAtLineStart)
+                newCursor.movePosition(QTextCursor::NextBlock);
+
+            newCursor.movePosition(QTextCursor::StartOfBlock);
+            newCursor.insertText(str);
+
+            if(!isAtLineStart)
+            {
+                newCursor.insertBlock();
+                newCursor.movePosition(QTextCursor::PreviousBlock);
+                newCursor.movePosition(QTextCursor::EndOfBlock);
+            }
         }
-        this->setTextCursor(newCursor);
     }
     else
     {
         newCursor.insertText(" " + str);
-        this->setTextCursor(newCursor);
     }
+    this->commitEdit();
+    this->setTextCursor(newCursor);
 }
 
-/**
- * @brief HPEMarkdownEditor::lineNumberAreaWidth
- * @return
- *
- * calculates the width of the LineNumberArea widget.
- * We take the number of digits in the last line of the editor and multiply that
- * with the maximum width of a digit
- */
-int HPEMarkdownEditor::lineNumberAreaWidth()
+int HPEMarkdownEditor::lineNumberAreaWidth() const
 {
-    int digits = 1;
-    int max = qMax(1, this->blockCount());
-    while (max >= 10) {
-        max /= 10;
-        ++digits;
-    }
-
-    int space = 3 + this->fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
-
-    return space;
+    return m_lineNumberArea->areaWidth();
 }
 
-void HPEMarkdownEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
+void HPEMarkdownEditor::updateLineNumberRows()
 {
-    QPainter painter(m_lineNumberArea);
-    painter.setFont(this->font());
-    //painter.fillRect(event->rect(), Qt::lightGray);
-
+    QVector<HPELineNumberArea::Row> rows;
     QTextBlock block = this->firstVisibleBlock();
     int blockNumber = block.blockNumber();
-    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
-    int bottom = top + qRound(blockBoundingRect(block).height());
-    while (block.isValid() && top <= event->rect().bottom()) {
-        if (block.isVisible() && bottom >= event->rect().top()) {
-            QString number = QString::number(blockNumber + 1);
-            painter.setPen(QColor(0, 0, 0, 30));
-            painter.drawText(0, top, m_lineNumberArea->width(), this->fontMetrics().height(),
-                             Qt::AlignRight, number);
-        }
+    qreal top = blockBoundingGeometry(block).translated(contentOffset()).top();
+    const int bottom = m_lineNumberArea->height();
+    while (block.isValid() && top <= bottom) {
+        qreal height = blockBoundingRect(block).height();
+        if (block.isVisible())
+            rows.append({ int(m_windowFirst) + blockNumber + 1, qRound(top), qRound(height) });
 
         block = block.next();
-        top = bottom;
-        bottom = top + qRound(blockBoundingRect(block).height());
+        top += height;
         ++blockNumber;
     }
+    m_lineNumberArea->setRows(rows);
 }
 
 QList<HPEMarkdownEditor::Link> HPEMarkdownEditor::getDocumentLinks()
 {
     QList<HPEMarkdownEditor::Link> res;
-    QRegularExpressionMatchIterator iterator =
-            QRegularExpression("\\[(.+)\\]\\((.+)\\)").globalMatch(this->toPlainText());
-    while(iterator.hasNext())
+    for(const HPELinkIndex::Entry& entry : m_linkIndex->links())
+        res.append(HPEMarkdownEditor::Link(entry.text, entry.url));
+
+    return res;
+}
+
+HPELinkIndex *HPEMarkdownEditor::linkIndex() const
+{
+    return m_linkIndex;
+}
+
+HPEHeadingIndex *HPEMarkdownEditor::headingIndex() const
+{
+    return m_headingIndex;
+}
+
+bool HPEMarkdownEditor::setSearch(const QString &pattern, HPETextSearcher::Options options)
+{
+    m_searcher = HPETextSearcher(pattern, options);
+    m_matchCount = -1;
+    this->updateMatchSelections();
+    return pattern.isEmpty() || m_searcher.isValid();
+}
+
+void HPEMarkdownEditor::clearSearch()
+{
+    this->setSearch(QString());
+}
+
+const HPETextSearcher &HPEMarkdownEditor::searcher() const
+{
+    return m_searcher;
+}
+
+bool HPEMarkdownEditor::findNext(bool backward)
+{
+    if(!m_searcher.isValid())
+        return false;
+
+    const QTextCursor current = this->textCursor();
+    const int from = backward ? current.selectionStart() : current.selectionEnd();
+    QTextBlock block = this->document()->findBlock(from);
+
+    //the block of the selection is visited again at last, for the matches on its other side
+    HPETextSearcher::Match match;
+    for(int i = 0, count = this->blockCount(); i <= count; ++i)
+    {
+        const QString text = block.text();
+        bool found = backward
+                ? m_searcher.findLast(text, i == 0 ? from - block.position() : text.size(), match)
+                : m_searcher.find(text, i == 0 ? from - block.position() : 0, match);
+        if(found)
+        {
+            QTextCursor cursor(block);
+            cursor.setPosition(block.position() + int(match.start));
+            cursor.setPosition(block.position() + int(match.start + match.length), QTextCursor::KeepAnchor);
+            this->setTextCursor(cursor);
+            this->ensureCursorVisible();
+            return true;
+        }
+
+        block = backward ? block.previous() : block.next();
+        if(!block.isValid())
+            block = backward ? this->document()->lastBlock() : this->document()->firstBlock();
+    }
+    return false;
+}
+
+int HPEMarkdownEditor::matchCount()
+{
+    if(m_matchCount < 0)
     {
-        QRegularExpressionMatch match = iterator.next();
-        res.append(HPEMarkdownEditor::Link(match.captured(1), match.captured(2)));
+        m_matchCount = 0;
+        if(m_searcher.isValid())
+            for(QTextBlock block = this->document()->firstBlock(); block.isValid(); block = block.next())
+                m_matchCount += m_searcher.findAll(block.text()).size();
     }
+    return m_matchCount;
+}
 
-    return res;
+bool HPEMarkdownEditor::replaceCurrent(const QString &replacement)
+{
+    bool replaced = false;
+    QTextCursor cursor = this->textCursor();
+    if(m_searcher.isValid() && cursor.hasSelection())
+    {
+        QTextBlock block = this->document()->findBlock(cursor.selectionStart());
+        const QString text = block.text();
+        HPETextSearcher::Match match;
+        if(m_searcher.find(text, cursor.selectionStart() - block.position(), match)
+                && block.position() + match.start == cursor.selectionStart()
+                && block.position() + match.start + match.length == cursor.selectionEnd())
+        {
+            cursor.insertText(m_searcher.replacement(text, match, replacement));
+            this->setTextCursor(cursor);
+            replaced = true;
+        }
+    }
+    this->findNext();
+    return replaced;
+}
+
+int HPEMarkdownEditor::replaceAll(const QString &replacement)
+{
+    //the document is only the window
+    if(!m_searcher.isValid() || this->isLargeFileMode())
+        return 0;
+
+    struct Replacement
+    {
+        int position;
+        int length;
+        QString text;
+    };
+    QVector<Replacement> replacements;
+    for(QTextBlock block = this->document()->firstBlock(); block.isValid(); block = block.next())
+    {
+        const QString text = block.text();
+        for(const HPETextSearcher::Match& match : m_searcher.findAll(text))
+            replacements.append({ block.position() + int(match.start), int(match.length),
+                                  m_searcher.replacement(text, match, replacement) });
+    }
+    if(replacements.isEmpty())
+        return 0;
+
+    //from the last match, so the positions of the others stay valid
+    QTextCursor cursor(this->document());
+    this->beginEdit();
+    for(auto it = replacements.crbegin(); it != replacements.crend(); ++it)
+    {
+        cursor.setPosition(it->position);
+        cursor.setPosition(it->position + it->length, QTextCursor::KeepAnchor);
+        cursor.insertText(it->text);
+    }
+    this->commitEdit();
+    return replacements.size();
+}
+
+int HPEMarkdownEditor::firstVisibleBlockNumber() const
+{
+    return this->firstVisibleBlock().blockNumber();
+}
+
+double HPEMarkdownEditor::firstVisibleBlockOffset() const
+{
+    QTextBlock block = this->firstVisibleBlock();
+    QRectF geometry = this->blockBoundingGeometry(block).translated(this->contentOffset());
+    if(geometry.height() <= 0)
+        return 0.0;
+    return qBound(0.0, -geometry.top() / geometry.height(), 1.0);
 }
 
 void HPEMarkdownEditor::resizeEvent(QResizeEvent *event)
@@ -162,6 +427,10 @@ void HPEMarkdownEditor::resizeEvent(QResizeEvent *event)
     QRect contentRect = this->contentsRect();
     m_lineNumberArea->setGeometry(QRect(contentRect.left(), contentRect.top(),
                                         this->lineNumberAreaWidth(), contentRect.height()));
+    this->updateLineNumberRows();
+    this->highlightVisibleBlocks();
+    if(m_searcher.isValid())
+        m_matchSelectionTimer.start();
 }
 
 void HPEMarkdownEditor::wheelEvent(QWheelEvent *event)
@@ -182,14 +451,37 @@ void HPEMarkdownEditor::keyPressEvent(QKeyEvent *event)
     }
 }
 
+void HPEMarkdownEditor::changeEvent(QEvent *event)
+{
+    QPlainTextEdit::changeEvent(event);
+    if(event->type() == QEvent::FontChange)
+    {
+        m_lineNumberArea->setDigitFont(this->font());
+        this->setViewportMargins(this->lineNumberAreaWidth(), 0, 0, 0);
+    }
+}
+
 void HPEMarkdownEditor::updateLineNumberAreaWidth(int /*newBlockCount*/)
 {
+    int digits = 1;
+    qint64 max = qMax(qint64(1), this->lineCount());
+    while (max >= 10) {
+        max /= 10;
+        ++digits;
+    }
+
+    if(!m_lineNumberArea->setDigitCount(digits))
+        return;
     this->setViewportMargins(this->lineNumberAreaWidth(), 0, 0, 0);
+    QRect contentRect = this->contentsRect();
+    m_lineNumberArea->setGeometry(QRect(contentRect.left(), contentRect.top(),
+                                        this->lineNumberAreaWidth(), contentRect.height()));
 }
 
 void HPEMarkdownEditor::highlightCurrentLine()
 {
     QVector<QTextEdit::ExtraSelection> extraSelections;
+    extraSelections.reserve(m_matchSelections.size() + 1);
 
     if(!this->isReadOnly())
     {
@@ -203,16 +495,92 @@ void HPEMarkdownEditor::highlightCurrentLine()
         selection.cursor.clearSelection();
         extraSelections.append(selection);
     }
+    extraSelections.append(m_matchSelections);
     this->setExtraSelections(extraSelections);
 }
 
 void HPEMarkdownEditor::updateLineNumberArea(const QRect &rect, int deltaY)
 {
     if (deltaY)
-        m_lineNumberArea->scroll(0, deltaY);
-    else
-        m_lineNumberArea->update(0, rect.y(), m_lineNumberArea->width(), rect.height());
+        m_lineNumberArea->scrollRows(deltaY);
+    this->updateLineNumberRows();
 
     if (rect.contains(viewport()->rect()))
         updateLineNumberAreaWidth(0);
 }
+
+void HPEMarkdownEditor::highlightVisibleBlocks()
+{
+    if(!m_highlighter->isDeferring())
+        return;
+
+    QTextBlock first = this->firstVisibleBlock();
+    QTextBlock last = first;
+    qreal bottom = this->blockBoundingGeometry(first).translated(this->contentOffset()).bottom();
+    while(last.next().isValid() && bottom < this->viewport()->height())
+    {
+        last = last.next();
+        bottom += this->blockBoundingRect(last).height();
+    }
+    m_highlighter->highlightVisibleBlocks(first, last);
+}
+
+void HPEMarkdownEditor::slideWindow()
+{
+    if(!m_pieceTable || this->isEditing())
+        return;
+
+    int first = this->firstVisibleBlockNumber();
+    int last  = this->cursorForPosition(QPoint(0, this->viewport()->height())).blockNumber();
+    bool nearTop    = m_windowFirst > 0 && first < WINDOW_MARGIN;
+    bool nearBottom = m_windowFirst + this->blockCount() < this->lineCount()
+            && last >= this->blockCount() - WINDOW_MARGIN;
+    if(!nearTop && !nearBottom)
+        return;
+
+    //keep the top line and the cursor where they are in the file
+    qint64 top = m_windowFirst + first;
+    qint64 cursorLine = m_windowFirst + this->textCursor().blockNumber();
+    int cursorColumn = this->textCursor().positionInBlock();
+
+    this->commitWindow();
+    this->loadWindow(qBound(qint64(0), top - WINDOW_LINES / 2, qMax(qint64(0), this->lineCount() - WINDOW_LINES)));
+
+    QTextBlock cursorBlock = this->document()->findBlockByNumber(
+                int(qBound(qint64(0), cursorLine - m_windowFirst, qint64(this->blockCount() - 1))));
+    QTextCursor cursor(cursorBlock);
+    cursor.setPosition(cursorBlock.position() + qMin(cursorColumn, cursorBlock.length() - 1));
+    this->setTextCursor(cursor);
+    this->verticalScrollBar()->setValue(this->document()->findBlockByNumber(int(top - m_windowFirst)).firstLineNumber());
+}
+
+void HPEMarkdownEditor::updateMatchSelections()
+{
+    m_matchSelections.clear();
+    if(m_searcher.isValid())
+    {
+        QTextCharFormat format;
+        format.setBackground(QColor(255, 200, 0, 120));
+
+        QTextBlock block = this->firstVisibleBlock();
+        qreal top = blockBoundingGeometry(block).translated(contentOffset()).top();
+        const int bottom = this->viewport()->height();
+        while(block.isValid() && top <= bottom)
+        {
+            if(block.isVisible())
+                for(const HPETextSearcher::Match& match : m_searcher.findAll(block.text()))
+                {
+                    QTextEdit::ExtraSelection selection;
+                    selection.format = format;
+                    selection.cursor = QTextCursor(block);
+                    selection.cursor.setPosition(block.position() + int(match.start));
+                    selection.cursor.setPosition(block.position() + int(match.start + match.length), QTextCursor::KeepAnchor);
+                    m_matchSelections.append(selection);
+                }
+
+            top += blockBoundingRect(block).height();
+            block = block.next();
+        }
+    }
+    this->highlightCurrentLine();
+}
@@ -14,9 +14,16 @@
 #define HPEMARKDOWNEDITOR_H
 
 #include <QPlainTextEdit>
+#include <QScopedPointer>
+#include <QTimer>
 
+#include "Controller/hpetextsearcher.h"
+
+class HPEHeadingIndex;
 class HPELineNumberArea;
+class HPELinkIndex;
 class HPESyntaxHighlighter;
+class HPEPieceTable;
 
 /**
  * @class HPEMarkdownEditor
@@ -26,7 +33,25 @@ class HPESyntaxHighlighter;
  * @ingroup widgets
  * @ingroup editor
  * 
+ * @par Large-file mode
+ * 
+ * A file of LARGE_FILE_THRESHOLD bytes or more is opened by loadLargeFile(): the file is kept
+ * by an HPEPieceTable, and the document holds only a window of WINDOW_LINES lines around the view.
+ * When the view gets within WINDOW_MARGIN lines of an edge of the window, the edits of the window
+ * are written to the piece table and the window is moved, so laying out and highlighting
+ * only ever see the window, whatever the size of the file.
+ * The line numbers are the lines of the file; the document, and so the preview and the link index, is the window.
+ * 
+ * @par Find and replace
  * 
+ * setSearch() sets the HPETextSearcher of the editor. Its matches are highlighted only in the visible blocks,
+ * found again when the view scrolls or the text changes, and counted only when matchCount() is called.
+ * replaceAll() replaces every match in one edit block: it is one undo step, and the document
+ * is laid out and highlighted again once.
+ * In large-file mode, only the window is searched and counted, and replaceAll() replaces nothing:
+ * it would miss the rest of the file. HPEFindBar labels the count and disables Replace All then.
+ * 
+ * @note Undo does not cross a move of the window.
 */
 class HPEMarkdownEditor : public QPlainTextEdit
 {
@@ -61,6 +86,97 @@ private:
     */
     HPESyntaxHighlighter* m_highlighter;
 
+    /**
+     * @brief HPELinkIndex of the document
+     * 
+    */
+    HPELinkIndex* m_linkIndex;
+
+    /**
+     * @brief HPEHeadingIndex of the document, fed by m_highlighter
+     * 
+    */
+    HPEHeadingIndex* m_headingIndex;
+
+    /**
+     * @brief The size (characters) from which a text loaded by loadText()
+     * is highlighted in the background
+     * 
+    */
+    static constexpr int DEFERRED_HIGHLIGHT_THRESHOLD = 64 * 1024;
+
+    /**
+     * @brief The piece table of the file in large-file mode, null otherwise
+     * 
+    */
+    QScopedPointer<HPEPieceTable> m_pieceTable;
+
+    /**
+     * @brief The line of the file where the document starts in large-file mode
+     * 
+    */
+    qint64 m_windowFirst = 0;
+
+    /**
+     * @brief The number of lines of the file the document replaces in large-file mode
+     * 
+    */
+    qint64 m_windowLineCount = 0;
+
+    /**
+     * @brief Whether the document is edited since the window is loaded
+     * 
+    */
+    bool m_windowModified = false;
+
+    /**
+     * @brief The number of lines in the window of large-file mode
+     * 
+    */
+    static constexpr int WINDOW_LINES = 4000;
+
+    /**
+     * @brief The window moves when the view gets within WINDOW_MARGIN lines of its edges
+     * 
+    */
+    static constexpr int WINDOW_MARGIN = 500;
+
+    /**
+     * @brief The searcher of find and replace, invalid if nothing is searched
+     * 
+    */
+    HPETextSearcher m_searcher;
+
+    /**
+     * @brief The highlighted matches in the visible blocks
+     * 
+    */
+    QVector<QTextEdit::ExtraSelection> m_matchSelections;
+
+    /**
+     * @brief Collects the changes of the view and the text, and finds the visible matches once they are done
+     * 
+    */
+    QTimer m_matchSelectionTimer;
+
+    /**
+     * @brief The number of matches, -1 if the text changed since they were counted
+     * 
+    */
+    int m_matchCount = -1;
+
+    /**
+     * @brief Holds the edit block of the open edit transaction
+     * 
+    */
+    QTextCursor m_editCursor;
+
+    /**
+     * @brief The number of nested beginEdit() not committed yet
+     * 
+    */
+    int m_editDepth = 0;
+
     /**
      * @brief A constant QMap stores the chars to be completed by editor
      * auto-ly.
@@ -82,8 +198,87 @@ public:
     */
     HPEMarkdownEditor(QWidget *parent = nullptr);
 
+    ~HPEMarkdownEditor();
+
 public:
+
+    /**
+     * @brief The size (bytes) from which a file is opened by loadLargeFile()
+     * 
+    */
+    static constexpr qint64 LARGE_FILE_THRESHOLD = 8 * 1024 * 1024;
+
+    /**
+     * @brief Replace the text of the editor with text, like setPlainText().
+     * A large text is highlighted in the background, the visible blocks first,
+     * so the first screen shows up at once.
+     * 
+     * @param[in] text
+     * @see highlightingProgress()
+    */
+    void loadText(const QString& text);
+
+    /**
+     * @brief Open the file at filePath in large-file mode. The file is memory-mapped,
+     * and only the lines around the view are loaded into the document.
+     * 
+     * @param[in] filePath
+     * @param[out] errorString The reason if the file cannot be opened
+     * @return false if the file cannot be opened
+    */
+    bool loadLargeFile(const QString& filePath, QString* errorString = nullptr);
+
+    /**
+     * @brief Write the file of large-file mode to filePath
+     * 
+     * @param[in] filePath
+     * @param[out] errorString The reason if the file cannot be written
+     * @return false if the file cannot be written
+    */
+    bool saveLargeFile(const QString& filePath, QString* errorString = nullptr);
+
+    /**
+     * @brief Returns whether the file is opened by loadLargeFile()
+     * 
+    */
+    bool isLargeFileMode() const;
+
+    /**
+     * @brief Returns the number of lines of the file, which is blockCount() if not in large-file mode
+     * 
+    */
+    qint64 lineCount() const;
+
+    /**
+     * @brief Returns the progress of the background highlighting, from 0.0 to 1.0
+     * 
+    */
+    double highlightingProgress() const;
     
+    /**
+     * @brief Open an edit transaction. Until the matching commitEdit(), the mutations of the document
+     * are one undo step, and the document emits contentsChange() once at commitEdit(): so it is laid out,
+     * highlighted, indexed and sent to the preview once, for the blocks from the first to the last mutation.
+     * Transactions can be nested, only the outermost one is committed.
+     * 
+     * @note Commit the transaction before returning to the event loop, and move the text cursor after it,
+     * as the document isn't laid out again until then
+     * @see commitEdit()
+    */
+    void beginEdit();
+
+    /**
+     * @brief Commit the edit transaction opened by beginEdit()
+     * 
+    */
+    void commitEdit();
+
+    /**
+     * @brief Returns whether an edit transaction is open
+     * 
+    */
+    bool isEditing() const;
+
     /**
      * @brief Wrap the selection in editor with str.
      * 
@@ -110,30 +305,99 @@ public:
     void insertString(const QString& str, bool atNewLine = false);
 
     /**
-     * @brief Calculates the width of the HPELineNumberArea widget. 
-     * We take the number of digits in the last line of the editor and multiply that with the maximum width of a digit.
+     * @brief Returns the width of the HPELineNumberArea widget: the number of digits in
+     * the last line of the editor multiplied by the maximum width of a digit.
+     * It is cached by HPELineNumberArea, and recomputed only when the digit count or the font changes.
      * 
      * @return The width of the HPELineNumberArea widget.  
      * 
      * @note Visit https://doc.qt.io/qt-6/qtwidgets-widgets-codeeditor-example.html for more info
     */
-    int lineNumberAreaWidth();
+    int lineNumberAreaWidth() const;
+
+    /**
+     * @brief Get all Links (images excluded) from the link index
+     * 
+     * @return A list of Link written in editor
+    */
+    QList<Link> getDocumentLinks();
 
     /**
-     * @brief Called from HPELineNumberArea whenever it receives a paint event.
+     * @brief Returns the index of the links and images of the document, kept up to date with every edit
      * 
-     * @param[in] event Got from HPELineNumberArea
+    */
+    HPELinkIndex* linkIndex() const;
+
+    /**
+     * @brief Returns the index of the headings of the document, kept up to date by the highlighter
      * 
-     * @note Visit https://doc.qt.io/qt-6/qtwidgets-widgets-codeeditor-example.html for more info
     */
-    void lineNumberAreaPaintEvent(QPaintEvent* event);
+    HPEHeadingIndex* headingIndex() const;
 
     /**
-     * @brief Iterate the document and get all Links
+     * @brief Search pattern, and highlight its matches in the visible blocks
      * 
-     * @return A list of Link written in editor
+     * @param[in] pattern Nothing is searched if it is empty
+     * @param[in] options
+     * @return false if pattern is an invalid regular expression
     */
-    QList<Link> getDocumentLinks();
+    bool setSearch(const QString& pattern, HPETextSearcher::Options options = HPETextSearcher::NoOptions);
+
+    /**
+     * @brief Stop searching, and remove the highlights of the matches
+     * 
+    */
+    void clearSearch();
+
+    /**
+     * @brief Returns the searcher set by setSearch()
+     * 
+    */
+    const HPETextSearcher& searcher() const;
+
+    /**
+     * @brief Select the next match after the selection, or the previous one, from the other end
+     * of the document if there are none
+     * 
+     * @param[in] backward
+     * @return false if there are no matches
+    */
+    bool findNext(bool backward = false);
+
+    /**
+     * @brief Returns the number of matches in the document, which are counted again only after the text changes.
+     * In large-file mode, the number of matches in the window.
+     * 
+    */
+    int matchCount();
+
+    /**
+     * @brief Replace the selection with replacement if it is a match, and select the next match
+     * 
+     * @param[in] replacement
+     * @return Whether the selection is replaced
+    */
+    bool replaceCurrent(const QString& replacement);
+
+    /**
+     * @brief Replace every match with replacement, as one undo step. Nothing is replaced in large-file mode.
+     * 
+     * @param[in] replacement \\0 to \\9 are the captures if the pattern is a regular expression
+     * @return The number of replaced matches
+    */
+    int replaceAll(const QString& replacement);
+
+    /**
+     * @brief Returns the number of the first visible block
+     * 
+    */
+    int firstVisibleBlockNumber() const;
+
+    /**
+     * @brief Returns how much of the first visible block is scrolled out, from 0.0 to 1.0
+     * 
+    */
+    double firstVisibleBlockOffset() const;
 
 protected:
 
@@ -155,6 +419,38 @@ protected:
     */
     void keyPressEvent(QKeyEvent*) override;
 
+    /**
+     * @brief Measure the digits of the line number area again when the font changes
+     * 
+    */
+    void changeEvent(QEvent*) override;
+
+private:
+
+    /**
+     * @brief Pass the visible rows to HPELineNumberArea, which repaints those that changed
+     * 
+    */
+    void updateLineNumberRows();
+
+    /**
+     * @brief Replace the document with text, a large text is highlighted in the background
+     * 
+    */
+    void setDocumentText(const QString& text);
+
+    /**
+     * @brief Load the lines of the file from first into the document
+     * 
+    */
+    void loadWindow(qint64 first);
+
+    /**
+     * @brief Write the edits of the window to the piece table
+     * 
+    */
+    void commitWindow();
+
 private slots:
 /**
  * @defgroup slots
@@ -162,7 +458,8 @@ private slots:
 */
 
     /**
-     * @brief Executed when the number of lines in the editor changes
+     * @brief Executed when the number of lines in the editor changes.
+     * The viewport margins are set only if the digit count changes.
      * 
      * @param[in] newBlockCount 
      * 
@@ -186,6 +483,25 @@ private slots:
      * @note Visit https://doc.qt.io/qt-6/qtwidgets-widgets-codeeditor-example.html for more info
     */
     void updateLineNumberArea(const QRect &rect, int deltaY);
+
+    /**
+     * @brief Highlight the visible blocks at once if the highlighting is deferred
+     * 
+     * @see loadText()
+    */
+    void highlightVisibleBlocks();
+
+    /**
+     * @brief Move the window of large-file mode if the view is near its edges
+     * 
+    */
+    void slideWindow();
+
+    /**
+     * @brief Find the matches in the visible blocks, and highlight them with the current line
+     * 
+    */
+    void updateMatchSelections();
 /**
  * @}
 */
@@ -200,6 +516,13 @@ signals:
      * 
     */
     void scrollVerticallyBy(double dy);
+
+    /**
+     * @brief This signal is emitted while a text loaded by loadText() is highlighted in the background
+     * 
+     * @param[in] progress From 0.0 to 1.0, 1.0 when it is done
+    */
+    void highlightingProgressChanged(double progress);
 /**
  * @}
 */
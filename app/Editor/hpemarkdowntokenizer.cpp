@@ -0,0 +1,131 @@
+/**
+ * @file hpemarkdowntokenizer.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-27
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpemarkdowntokenizer.h"
+
+void HPEMarkdownTokenizer::tokenize(QStringView text, Tokens &tokens)
+{
+    tokens.clear();
+    const char16_t* data = text.utf16();
+    const int size = int(text.size());
+
+    //the first opening tokens
+    int firstBracket = -1, firstImage = -1, firstAutoLink = -1;
+    int firstUnderline = -1, firstStrike = -1, firstTag = -1;
+    //the last closing tokens
+    int lastParenthesis = -1, lastGreater = -1;
+    int lastUnderline = -1, lastStrike = -1, lastTag = -1;
+    //the last two "](", and the last one at least 3 characters before lastParenthesis
+    int lastMiddle = -1, previousMiddle = -1, linkMiddle = -1;
+    //'*' and "**" in the current word
+    int firstStar = -1, lastStar = -1, firstDoubleStar = -1, lastDoubleStar = -1;
+
+    Tokens italics, bolds;
+    for(int i = 0; i <= size; ++i)
+    {
+        char16_t c = i < size ? data[i] : u' ';
+        switch(c)
+        {
+        case u' ':
+            //the end of a word
+            if(firstStar >= 0 && lastStar >= firstStar + 2)
+                italics.append({ Italic, firstStar, lastStar + 1 - firstStar });
+            if(firstDoubleStar >= 0 && lastDoubleStar >= firstDoubleStar + 3)
+                bolds.append({ Bold, firstDoubleStar, lastDoubleStar + 2 - firstDoubleStar });
+            firstStar = lastStar = firstDoubleStar = lastDoubleStar = -1;
+            break;
+        case u'*':
+            if(firstStar < 0)
+                firstStar = i;
+            lastStar = i;
+            if(i > 0 && data[i - 1] == u'*')
+            {
+                if(firstDoubleStar < 0)
+                    firstDoubleStar = i - 1;
+                lastDoubleStar = i - 1;
+            }
+            break;
+        case u'[':
+            if(firstBracket < 0)
+                firstBracket = i;
+            if(firstImage < 0 && i > 0 && data[i - 1] == u'!')
+                firstImage = i - 1;
+            break;
+        case u'(':
+            if(i > 0 && data[i - 1] == u']')
+            {
+                previousMiddle = lastMiddle;
+                lastMiddle = i - 1;
+            }
+            break;
+        case u')':
+            lastParenthesis = i;
+            linkMiddle = lastMiddle <= i - 3 ? lastMiddle : previousMiddle;
+            break;
+        case u'<':
+            if(firstAutoLink < 0 && text.mid(i + 1, 4) == u"http")
+                firstAutoLink = i;
+            if(firstUnderline < 0 && text.mid(i + 1, 2) == u"u>")
+                firstUnderline = i;
+            break;
+        case u'>':
+            lastGreater = i;
+            if(i >= 3 && text.mid(i - 3, 3) == u"</u")
+                lastUnderline = i - 3;
+            break;
+        case u'~':
+            if(i > 0 && data[i - 1] == u'~')
+            {
+                if(firstStrike < 0)
+                    firstStrike = i - 1;
+                lastStrike = i - 1;
+            }
+            break;
+        case u'{':
+            if(firstTag < 0 && text.mid(i + 1, 2) == u"% ")
+                firstTag = i;
+            break;
+        case u'}':
+            if(i >= 2 && data[i - 1] == u'%' && data[i - 2] == u' ')
+                lastTag = i - 2;
+            break;
+        default:
+            break;
+        }
+    }
+
+    int hashes = 0;
+    while(hashes < size && data[hashes] == u'#')
+        ++hashes;
+    if(hashes > 0 && hashes < size && data[hashes] == u' ')
+        tokens.append({ Heading, 0, size });
+
+    tokens.append(italics.constData(), italics.size());
+    tokens.append(bolds.constData(), bolds.size());
+
+    if(firstUnderline >= 0 && lastUnderline >= firstUnderline + 3)
+        tokens.append({ Underline, firstUnderline, lastUnderline + 4 - firstUnderline });
+    if(firstStrike >= 0 && lastStrike >= firstStrike + 2)
+        tokens.append({ Strike, firstStrike, lastStrike + 2 - firstStrike });
+    if(size > 0 && data[0] == u'>')
+        tokens.append({ Quote, 0, size });
+    if(text == u"- - -")
+        tokens.append({ HorizontalRule, 0, size });
+    if(firstTag >= 0 && lastTag >= firstTag + 4)
+        tokens.append({ TagPlugin, firstTag, lastTag + 3 - firstTag });
+    if(firstBracket >= 0 && linkMiddle >= firstBracket + 2)
+        tokens.append({ Link, firstBracket, lastParenthesis + 1 - firstBracket });
+    if(firstAutoLink >= 0 && lastGreater >= firstAutoLink + 6)
+        tokens.append({ AutoLink, firstAutoLink, lastGreater + 1 - firstAutoLink });
+    if(firstImage >= 0 && linkMiddle >= firstImage + 2)
+        tokens.append({ Image, firstImage, lastParenthesis + 1 - firstImage });
+}
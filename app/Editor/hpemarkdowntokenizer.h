@@ -0,0 +1,90 @@
+/**
+ * @file hpemarkdowntokenizer.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-27
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEMARKDOWNTOKENIZER_H
+#define HPEMARKDOWNTOKENIZER_H
+
+#include <QStringView>
+#include <QVarLengthArray>
+
+/**
+ * @class HPEMarkdownTokenizer
+ * @brief A single-pass tokenizer finding the Markdown spans highlighted in the editor
+ * @since 1.0.0
+ * 
+ * @ingroup editor
+ * 
+ * HPEMarkdownTokenizer finds the spans of a line highlighted by HPESyntaxHighlighter
+ * in one linear scan, with the same results as the regular expressions it replaces:
+ * @code
+ *      Heading         ^#+ (.*)$
+ *      Italic          \*([^ ]+)\*
+ *      Bold            \*\*([^ ]+)\*\*
+ *      Underline       <u>(.*)</u>
+ *      Strike          ~~(.*)~~
+ *      Quote           ^>(.*)$
+ *      HorizontalRule  ^- - -$
+ *      TagPlugin       \{% (.+) %\}
+ *      Link            \[(.+)\]\((.+)\)
+ *      AutoLink        <http(.+)>
+ *      Image           !\[(.*)\]\((.+)\)
+ * @endcode
+ * 
+ * The greedy patterns match from the first opening token to the last closing one,
+ * so the scan only records the first and the last positions of every token.
+ * Italic and bold never cross a space, they are found word by word.
+ * 
+ * Tokens are returned in the order above, a later token overrides an earlier one where they overlap.
+*/
+class HPEMarkdownTokenizer
+{
+public:
+
+    /**
+     * @brief The kind of a token, also the order of tokens
+     * 
+    */
+    enum Kind
+    {
+        Heading,
+        Italic,
+        Bold,
+        Underline,
+        Strike,
+        Quote,
+        HorizontalRule,
+        TagPlugin,
+        Link,
+        AutoLink,
+        Image,
+        KindCount
+    };
+
+    struct Token
+    {
+        Kind kind;
+        int start;
+        int length;
+    };
+
+    typedef QVarLengthArray<Token, 16> Tokens;
+
+    /**
+     * @brief Find the tokens of a line
+     * 
+     * @param[in] text The text of a line
+     * @param[out] tokens The tokens, ordered by kind and then by position
+    */
+    static void tokenize(QStringView text, Tokens& tokens);
+};
+
+#endif // HPEMARKDOWNTOKENIZER_H
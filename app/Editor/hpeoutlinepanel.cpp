@@ -0,0 +1,100 @@
+/**
+ * @file hpeoutlinepanel.cpp
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#include "hpeoutlinepanel.h"
+
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+#include <QTextBlock>
+
+#include "hpeheadingindex.h"
+#include "hpemarkdowneditor.h"
+
+/**
+ * @brief Indents a heading by its level
+ * 
+*/
+class HPEOutlineDelegate : public QStyledItemDelegate
+{
+public:
+    HPEOutlineDelegate(int indent, QObject* parent)
+        : QStyledItemDelegate{parent}, m_indent(indent) { }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override
+    {
+        QStyleOptionViewItem indented = option;
+        int level = index.data(HPEHeadingIndex::LevelRole).toInt();
+        indented.rect.adjust(m_indent * qMax(0, level - 1), 0, 0, 0);
+        if(level == 1)
+            indented.font.setBold(true);
+        QStyledItemDelegate::paint(painter, indented, index);
+    }
+
+private:
+    int m_indent;
+};
+
+HPEOutlinePanel::HPEOutlinePanel(QWidget *parent)
+    : QListView{parent}
+{
+    this->setFrameShape(QFrame::NoFrame);
+    this->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->setUniformItemSizes(true);
+    this->setItemDelegate(new HPEOutlineDelegate(LEVEL_INDENT, this));
+
+    connect(this, &HPEOutlinePanel::clicked, this, &HPEOutlinePanel::jumpToHeading);
+    connect(this, &HPEOutlinePanel::activated, this, &HPEOutlinePanel::jumpToHeading);
+}
+
+void HPEOutlinePanel::connectEditor(HPEMarkdownEditor *editor)
+{
+    m_connectedEditor = editor;
+    if(!m_connectedEditor)
+        return;
+
+    this->setModel(m_connectedEditor->headingIndex());
+    connect(m_connectedEditor, &HPEMarkdownEditor::cursorPositionChanged, this, &HPEOutlinePanel::selectCurrentSection);
+}
+
+void HPEOutlinePanel::showEvent(QShowEvent *event)
+{
+    QListView::showEvent(event);
+    this->selectCurrentSection();
+}
+
+void HPEOutlinePanel::jumpToHeading(const QModelIndex &index)
+{
+    if(!m_connectedEditor || !index.isValid())
+        return;
+
+    HPEHeadingIndex::Heading heading = m_connectedEditor->headingIndex()->heading(index.row());
+    QTextBlock block = m_connectedEditor->document()->findBlock(heading.position);
+    m_connectedEditor->setTextCursor(QTextCursor(block));
+    m_connectedEditor->verticalScrollBar()->setValue(block.firstLineNumber());
+    m_connectedEditor->setFocus();
+}
+
+void HPEOutlinePanel::selectCurrentSection()
+{
+    if(!m_connectedEditor || !this->isVisible())
+        return;
+
+    int section = m_connectedEditor->headingIndex()->sectionAt(m_connectedEditor->textCursor().position());
+    if(section < 0)
+    {
+        this->clearSelection();
+        return;
+    }
+    QModelIndex index = this->model()->index(section, 0);
+    this->setCurrentIndex(index);
+    this->scrollTo(index);
+}
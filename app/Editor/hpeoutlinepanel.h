@@ -0,0 +1,90 @@
+/**
+ * @file hpeoutlinepanel.h
+ * @brief This file is part of HPEWidgets
+ * @version 1.0.0
+ * @date 2022-02-28
+ * 
+ * @author Tomortec (everything@tomortec.com)
+ * @copyright Copyright © 2021 - 2022 Tomortec.
+ * @website https://tomortec.com
+ * @license GPL v3 (https://www.gnu.org/licenses/gpl-3.0.html)
+*/
+
+#ifndef HPEOUTLINEPANEL_H
+#define HPEOUTLINEPANEL_H
+
+#include <QListView>
+
+class HPEMarkdownEditor;
+
+/**
+ * @class HPEOutlinePanel
+ * @brief A list of the headings of an HPEMarkdownEditor, indented by level
+ * @since 1.0.0
+ * 
+ * @ingroup widgets
+ * @ingroup editor
+ * 
+ * HPEOutlinePanel shows the HPEHeadingIndex of the connected editor.
+ * Clicking a heading scrolls the editor to it, and the section the text cursor is in
+ * is kept selected; both are O(log n) lookups in the index.
+*/
+class HPEOutlinePanel : public QListView
+{
+    Q_OBJECT
+public:
+
+    /**
+     * @brief Construct a new HPEOutlinePanel with parent
+     * 
+     * @param[in] parent
+    */
+    explicit HPEOutlinePanel(QWidget* parent = nullptr);
+
+    /**
+     * @brief Show the outline of editor
+     * 
+    */
+    void connectEditor(HPEMarkdownEditor* editor);
+
+protected:
+
+    /**
+     * @brief The current section isn't followed while hidden, select it when shown
+     * 
+    */
+    void showEvent(QShowEvent* event) override;
+
+private:
+
+    /**
+     * @brief The indentation (px) of a level
+     * 
+    */
+    static constexpr int LEVEL_INDENT = 12;
+
+    HPEMarkdownEditor* m_connectedEditor = nullptr;
+
+private slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Move the text cursor of the editor to the heading, and scroll it to the top
+     * 
+    */
+    void jumpToHeading(const QModelIndex& index);
+
+    /**
+     * @brief Select the heading of the section the text cursor is in
+     * 
+    */
+    void selectCurrentSection();
+/**
+ * @}
+*/
+};
+
+#endif // HPEOUTLINEPANEL_H
@@ -12,6 +12,148 @@
 
 #include "hpesyntaxhighlighter.h"
 
+#include <QTextBlock>
+
+#include "hpeheadingindex.h"
+
+/**
+ * @brief Returns the position of the first non-space character of text,
+ * or -1 if text is indented by more than 3 spaces
+ * 
+*/
+static qsizetype indentationOf(QStringView text)
+{
+    qsizetype i = 0;
+    while(i < text.size() && text.at(i) == u' ')
+        ++i;
+    return i <= 3 ? i : -1;
+}
+
+static bool isBlank(QStringView text)
+{
+    return text.trimmed().isEmpty();
+}
+
+/**
+ * @brief Returns whether text starts with the tag name tag (case-insensitively),
+ * followed by a space, '>', "/>" or the end of text
+ * 
+*/
+static bool startsWithTagName(QStringView text, QLatin1String tag)
+{
+    if(!text.startsWith(tag, Qt::CaseInsensitive))
+        return false;
+    QStringView rest = text.mid(tag.size());
+    return rest.isEmpty() || rest.front() == u' ' || rest.front() == u'\t' || rest.front() == u'>'
+            || rest.startsWith(u"/>");
+}
+
+static bool containsHtmlRawEnd(QStringView text)
+{
+    for(const char* tag : { "</script>", "</pre>", "</style>", "</textarea>" })
+        if(text.contains(QLatin1String(tag), Qt::CaseInsensitive))
+            return true;
+    return false;
+}
+
+/**
+ * @brief Returns the state opened by text if it starts a multi-line construct, or Normal.
+ * closed is set if the construct also ends in text.
+ * 
+*/
+static int openingStateOf(QStringView text, bool& closed)
+{
+    closed = false;
+    qsizetype indentation = indentationOf(text);
+    if(indentation < 0 || indentation == text.size())
+        return HPESyntaxHighlighter::Normal;
+    QStringView line = text.mid(indentation);
+    char16_t first = line.front().unicode();
+
+    //code fence: ``` or ~~~, an info string after backticks can't contain '`'
+    if(first == u'`' || first == u'~')
+    {
+        qsizetype length = 1;
+        while(length < line.size() && line.at(length) == first)
+            ++length;
+        QStringView info = line.mid(length);
+        if(length < 3 || (first == u'`' && info.contains(u'`')))
+            return HPESyntaxHighlighter::Normal;
+        return HPESyntaxHighlighter::CodeFence | (first == u'~' ? HPESyntaxHighlighter::TildeFence : 0)
+                | (int(qMin<qsizetype>(length, 255)) << HPESyntaxHighlighter::FenceLengthShift)
+                | (HPECodeLexer::languageOf(info) << HPESyntaxHighlighter::LanguageShift);
+    }
+
+    //math block: $$ on its own, or a formula starting with $$ (closed if it also ends with $$)
+    QStringView trimmed = line.trimmed();
+    if(trimmed.startsWith(u"$$"))
+    {
+        closed = trimmed.size() >= 4 && trimmed.endsWith(u"$$");
+        return HPESyntaxHighlighter::MathBlock;
+    }
+
+    if(first != u'<')
+        return HPESyntaxHighlighter::Normal;
+    QStringView tag = line.mid(1);
+    if(tag.startsWith(u"!--"))
+    {
+        closed = tag.indexOf(u"-->", 3) >= 0;
+        return HPESyntaxHighlighter::HtmlComment;
+    }
+    for(const char* name : { "script", "pre", "style", "textarea" })
+        if(startsWithTagName(tag, QLatin1String(name)))
+        {
+            closed = containsHtmlRawEnd(tag);
+            return HPESyntaxHighlighter::HtmlRawBlock;
+        }
+
+    //block-level elements, https://spec.commonmark.org/0.30/#html-blocks
+    if(tag.startsWith(u'/'))
+        tag = tag.mid(1);
+    for(const char* name : { "address", "article", "aside", "blockquote", "center", "details", "dialog",
+                             "div", "dl", "fieldset", "figcaption", "figure", "footer", "form",
+                             "h1", "h2", "h3", "h4", "h5", "h6", "header", "hr", "iframe", "li",
+                             "main", "nav", "ol", "p", "section", "summary", "table", "tbody",
+                             "td", "tfoot", "th", "thead", "tr", "ul" })
+        if(startsWithTagName(tag, QLatin1String(name)))
+            return HPESyntaxHighlighter::HtmlBlock;
+    return HPESyntaxHighlighter::Normal;
+}
+
+/**
+ * @brief Returns whether text closes the construct of state, text being inside the construct
+ * 
+*/
+static bool closesState(QStringView text, int state)
+{
+    switch(state & HPESyntaxHighlighter::KindMask)
+    {
+    case HPESyntaxHighlighter::FrontMatter:
+        return text == QLatin1String("---");
+    case HPESyntaxHighlighter::CodeFence:
+    {
+        //the same character, at least as long as the opening fence, followed only by spaces
+        qsizetype indentation = indentationOf(text);
+        if(indentation < 0)
+            return false;
+        char16_t fence = (state & HPESyntaxHighlighter::TildeFence) ? u'~' : u'`';
+        qsizetype i = indentation;
+        while(i < text.size() && text.at(i) == fence)
+            ++i;
+        return i - indentation >= ((state >> HPESyntaxHighlighter::FenceLengthShift) & 0xFF) && isBlank(text.mid(i));
+    }
+    case HPESyntaxHighlighter::MathBlock:
+        return text.trimmed().endsWith(u"$$");
+    case HPESyntaxHighlighter::HtmlBlock:
+        return isBlank(text);
+    case HPESyntaxHighlighter::HtmlRawBlock:
+        return containsHtmlRawEnd(text);
+    case HPESyntaxHighlighter::HtmlComment:
+        return text.contains(u"-->");
+    }
+    return true;
+}
+
 HPESyntaxHighlighter::HPESyntaxHighlighter(QTextDocument *parent)
     : QSyntaxHighlighter{parent}
 {
@@ -40,87 +182,257 @@ HPESyntaxHighlighter::HPESyntaxHighlighter(QTextDocument *parent)
     tagPluginFormat.setFontUnderline(true);
     tagPluginFormat.setForeground(QBrush(QColor(208, 208, 208)));
 
-    HighlightRule rule;
-    rule.pattern = QRegularExpression("^#+ (.*)$");
-    rule.format = headingFormat;
-    highlightingRules.append(rule);
+    codeFormat.setForeground(QBrush(QColor(0, 0, 0, 160)));
+    codeFormat.setBackground(QBrush(QColor(0, 0, 0, 8)));
+
+    mathFormat.setFontItalic(true);
+    mathFormat.setForeground(QBrush(QColor(0, 0, 0, 160)));
+
+    htmlFormat.setForeground(QBrush(QColor(0, 0, 0, 100)));
+
+    for(QTextCharFormat& format : codeTokenFormats)
+        format = codeFormat;
+    codeTokenFormats[HPECodeLexer::Keyword].setForeground(QBrush(QColor(0, 92, 197)));
+    codeTokenFormats[HPECodeLexer::Literal].setForeground(QBrush(QColor(111, 66, 193)));
+    codeTokenFormats[HPECodeLexer::Number].setForeground(QBrush(QColor(111, 66, 193)));
+    codeTokenFormats[HPECodeLexer::String].setForeground(QBrush(QColor(3, 47, 98)));
+    codeTokenFormats[HPECodeLexer::Comment].setForeground(QBrush(QColor(0, 0, 0, 80)));
+    codeTokenFormats[HPECodeLexer::Comment].setFontItalic(true);
+    codeTokenFormats[HPECodeLexer::Meta].setForeground(QBrush(QColor(227, 98, 9)));
+    codeTokenFormats[HPECodeLexer::Variable].setForeground(QBrush(QColor(0, 128, 128)));
+    codeTokenFormats[HPECodeLexer::Key].setForeground(QBrush(QColor(34, 134, 58)));
+
+    tokenFormats[HPEMarkdownTokenizer::Heading]        = headingFormat;
+    tokenFormats[HPEMarkdownTokenizer::Italic]         = italicFormat;
+    tokenFormats[HPEMarkdownTokenizer::Bold]           = boldFormat;
+    tokenFormats[HPEMarkdownTokenizer::Underline]      = underlineFormat;
+    tokenFormats[HPEMarkdownTokenizer::Strike]         = strikeFormat;
+    tokenFormats[HPEMarkdownTokenizer::Quote]          = quoteFormat;
+    tokenFormats[HPEMarkdownTokenizer::HorizontalRule] = hRuleFormat;
+    tokenFormats[HPEMarkdownTokenizer::TagPlugin]      = tagPluginFormat;
+    tokenFormats[HPEMarkdownTokenizer::Link]           = insertionFormat;   //link
+    tokenFormats[HPEMarkdownTokenizer::AutoLink]       = insertionFormat;
+    tokenFormats[HPEMarkdownTokenizer::Image]          = insertionFormat;   //image
+
+    m_horizon     = QTextCursor(parent);
+    m_visibleFrom = QTextCursor(parent);
+    m_visibleTo   = QTextCursor(parent);
 
-    rule.pattern = QRegularExpression("\\*([^ ]+)\\*");
-    rule.format = italicFormat;
-    highlightingRules.append(rule);
+    m_sliceTimer.setSingleShot(true);
+    m_sliceTimer.setInterval(0);
+    connect(&m_sliceTimer, &QTimer::timeout, this, &HPESyntaxHighlighter::highlightNextSlice);
 
-    rule.pattern = QRegularExpression("\\*\\*([^ ]+)\\*\\*");
-    rule.format = boldFormat;
-    highlightingRules.append(rule);
+    m_codeBudgetTimer.setSingleShot(true);
+    m_codeBudgetTimer.setInterval(0);
+    connect(&m_codeBudgetTimer, &QTimer::timeout, this, &HPESyntaxHighlighter::highlightPendingCode);
+}
 
-    rule.pattern = QRegularExpression("<u>(.*)</u>");
-    rule.format = underlineFormat;
-    highlightingRules.append(rule);
+void HPESyntaxHighlighter::setHighlightingDeferred(bool deferred)
+{
+    m_deferring = deferred;
+    if(!deferred)
+    {
+        m_sliceTimer.stop();
+        return;
+    }
 
-    rule.pattern = QRegularExpression("~~(.*)~~");
-    rule.format = strikeFormat;
-    highlightingRules.append(rule);
+    m_horizon.setPosition(0);
+    m_visibleFrom.setPosition(0);
+    m_visibleTo.setPosition(0);
+    m_sliceTimer.start();
+    emit progressChanged(0.0);
+}
+
+void HPESyntaxHighlighter::highlightVisibleBlocks(const QTextBlock &first, const QTextBlock &last)
+{
+    if(!m_deferring || !first.isValid() || !last.isValid())
+        return;
 
-    rule.pattern = QRegularExpression("^>(.*)$");
-    rule.format = quoteFormat;
-    highlightingRules.append(rule);
+    m_visibleFrom.setPosition(first.position());
+    m_visibleTo.setPosition(last.position());
+    //the cascade highlights the following deferred blocks of the range
+    for(QTextBlock block = first; block.isValid() && block.position() <= last.position(); block = block.next())
+        if(block.userState() == Deferred)
+            rehighlightBlock(block);
+}
+
+bool HPESyntaxHighlighter::isDeferring() const
+{
+    return m_deferring;
+}
+
+double HPESyntaxHighlighter::progress() const
+{
+    if(!m_deferring)
+        return 1.0;
+    return double(m_horizon.block().blockNumber()) / qMax(1, document()->blockCount());
+}
 
-    rule.pattern = QRegularExpression("^- - -$");
-    rule.format = hRuleFormat;
-    highlightingRules.append(rule);
+void HPESyntaxHighlighter::setHeadingIndex(HPEHeadingIndex *index)
+{
+    m_headingIndex = index;
+}
 
-    rule.pattern = QRegularExpression("\\{% (.+) %\\}");
-    rule.format = tagPluginFormat;
-    highlightingRules.append(rule);
+void HPESyntaxHighlighter::highlightNextSlice()
+{
+    if(!m_deferring)
+        return;
 
-    const QString insertionRE[] = {
-        "\\[(.+)\\]\\((.+)\\)", "<http(.+)>",   //link
-        "!\\[(.*)\\]\\((.+)\\)"                //image
-    };
-    for(const QString &pattern : insertionRE)
+    QElapsedTimer timer;
+    timer.start();
+    QTextBlock block = m_horizon.block();
+    while(block.isValid() && timer.elapsed() < TIME_SLICE)
     {
-        rule.pattern = QRegularExpression(pattern);
-        rule.format  = insertionFormat;
-        highlightingRules.append(rule);
+        QTextBlock end = block;
+        for(int i = 0; i < CHUNK_BLOCKS && end.isValid(); ++i)
+            end = end.next();
+        if(end.isValid())
+            m_horizon.setPosition(end.position());
+        else
+            m_deferring = false;
+
+        //the cascade from the first deferred block stops at the horizon
+        for(; block.isValid() && block != end; block = block.next())
+            if(block.userState() == Deferred)
+                rehighlightBlock(block);
     }
+
+    if(m_deferring)
+        m_sliceTimer.start();
+    emit progressChanged(progress());
+}
+
+void HPESyntaxHighlighter::highlightPendingCode()
+{
+    m_codeBudget.invalidate();
+    if(m_pendingCode.isNull())
+        return;
+
+    QTextBlock block = m_pendingCode.block();
+    m_pendingCode = QTextCursor();
+    rehighlightBlock(block);
+}
+
+bool HPESyntaxHighlighter::isDeferred(const QTextBlock &block) const
+{
+    int position = block.position();
+    if(position < m_horizon.position())
+        return false;
+    return position < m_visibleFrom.position() || position > m_visibleTo.position();
 }
 
 void HPESyntaxHighlighter::highlightBlock(const QString &text)
-{   
-    for (const HighlightRule &rule : qAsConst(highlightingRules)) {
-        QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-        while (matchIterator.hasNext()) {
-            QRegularExpressionMatch match = matchIterator.next();
-            setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+{
+    // The state depends only on the previous state and the text, never on the position,
+    // so the cascade stops at the first block whose state doesn't change
+
+    // ---                          BlockState: FrontMatter (the first block only)
+    // title: Hello                             FrontMatter
+    // ---                                      -1
+    // ```                                      CodeFence
+    // code                                     CodeFence
+    // ```                                      -1
+    // OTHER CONTENTS                           -1
+    if(m_deferring && isDeferred(currentBlock()))
+    {
+        setCurrentBlockState(Deferred);
+        return;
+    }
+
+    //a deferred previous block is supposed not to be inside any construct
+    int state = qMax(previousBlockState(), int(Normal));
+    if(state != Normal)
+    {
+        //a blank line ends an HTML block and isn't part of it
+        bool closed = closesState(text, state);
+        if(!(closed && (state & KindMask) == HtmlBlock))
+        {
+            setFormat(0, text.length(), formatOfState(state));
+            if(!closed && (state & KindMask) == CodeFence)
+                state = highlightCode(text, state);
+            setCurrentBlockState(closed ? Normal : state);
+            updateHeading(text, 0);
+            return;
         }
     }
 
-    //match frontMatter
-    // Front-matter is a block of YAML at the beginning of the file
-
-    // OTHER CONTENTS               BlockState: -1
-    // ---                                      0
-    // FrontMatter contents                     0
-    // ···                                      0
-    // ---                                      1
-    // OTHER CONTENTS               BlockState: -1
-    QRegularExpression frontMatterPattern("^---$");
-    int index = text.indexOf(frontMatterPattern);
-    if(index != -1 && previousBlockState() == -1)    //start
+    //Front-Matter is a block of YAML at the beginning of the file
+    if(!currentBlock().previous().isValid() && text == QLatin1String("---"))
     {
         setFormat(0, 3, frontMatterFormat);
-        setCurrentBlockState(0);
+        setCurrentBlockState(FrontMatter);
+        updateHeading(text, 0);
+        return;
     }
-    else if(index != -1 && previousBlockState() == 0) //end
+
+    bool closed = false;
+    state = openingStateOf(text, closed);
+    if(state != Normal)
     {
-        setFormat(0, 3, frontMatterFormat);
-        setCurrentBlockState(1);
+        setFormat(0, text.length(), formatOfState(state));
+        setCurrentBlockState(closed ? Normal : state);
+        updateHeading(text, 0);
+        return;
+    }
+
+    //tokens are ordered, the later ones override the earlier ones
+    int headingLevel = 0;
+    HPEMarkdownTokenizer::tokenize(text, tokens);
+    for (const HPEMarkdownTokenizer::Token &token : qAsConst(tokens))
+    {
+        setFormat(token.start, token.length, tokenFormats[token.kind]);
+        if(token.kind == HPEMarkdownTokenizer::Heading)
+            while(text.at(headingLevel) == u'#')
+                ++headingLevel;
+    }
+    setCurrentBlockState(Normal);
+    updateHeading(text, headingLevel);
+}
+
+void HPESyntaxHighlighter::updateHeading(const QString &text, int level)
+{
+    if(m_headingIndex)
+        m_headingIndex->setHeading(currentBlock(), level, level > 0 ? text.mid(level + 1).trimmed() : QString());
+}
+
+int HPESyntaxHighlighter::highlightCode(const QString &text, int state)
+{
+    HPECodeLexer::Language language = HPECodeLexer::Language((state >> LanguageShift) & 0xFF);
+    //a very long line (minified code) is left plain, and doesn't change the state
+    if(language == HPECodeLexer::None || text.size() > CODE_LENGTH_LIMIT)
+        return state;
+
+    //background highlighting has its own time slices
+    if(!m_deferring)
+    {
+        if(!m_codeBudget.isValid())
+        {
+            m_codeBudget.start();
+            m_codeBudgetTimer.start();
+        }
+        else if(m_codeBudget.elapsed() > CODE_TIME_BUDGET)
+        {
+            //keep the old state to stop the cascade, and go on from here in the next turn
+            if(m_pendingCode.isNull() || currentBlock().position() < m_pendingCode.position())
+                m_pendingCode = QTextCursor(currentBlock());
+            return currentBlockState();
+        }
     }
-    else if(index == -1 && previousBlockState() == 0)   //content
+
+    int lexerState = (state >> LexerStateShift) & HPECodeLexer::StateMask;
+    lexerState = HPECodeLexer::tokenize(language, text, lexerState, codeTokens);
+    for(const HPECodeLexer::Token& token : qAsConst(codeTokens))
+        setFormat(token.start, token.length, codeTokenFormats[token.kind]);
+    return (state & ~(HPECodeLexer::StateMask << LexerStateShift)) | (lexerState << LexerStateShift);
+}
+
+const QTextCharFormat &HPESyntaxHighlighter::formatOfState(int state) const
+{
+    switch(state & KindMask)
     {
-        setFormat(0, text.length(), frontMatterFormat);
-        setCurrentBlockState(0);
+    case FrontMatter: return frontMatterFormat;
+    case CodeFence:   return codeFormat;
+    case MathBlock:   return mathFormat;
+    default:          return htmlFormat;
     }
-    else
-        setCurrentBlockState(-1);
 }
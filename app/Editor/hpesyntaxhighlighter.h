@@ -15,10 +15,16 @@
 
 #include <QSyntaxHighlighter>
 #include <QTextDocument>
-#include <QRegularExpression>
 #include <QTextCharFormat>
+#include <QTextCursor>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "hpemarkdowntokenizer.h"
+#include "hpecodelexer.h"
 
 class HPEHexoPostAnalyzer;
+class HPEHeadingIndex;
 
 /**
  * @class HPESyntaxHighlighter
@@ -29,21 +35,49 @@ class HPEHexoPostAnalyzer;
  * @ingroup editor
  * 
  * Render the editor's (document) text by using
- * QRegularExpression and QTextCharFormat.
+ * HPEMarkdownTokenizer and QTextCharFormat.
  * 
  * @par Add Single Line Matching and Rendering Rules
  * 
- * For single line regular expression match, the matching and rendering rules
- * are stored in HPESyntaxHighlighter::highlightingRules.
+ * Single line spans are found by HPEMarkdownTokenizer in one scan of the line,
+ * and rendered with the format of their kind in HPESyntaxHighlighter::tokenFormats.
  * 
- * Therefore, to add rendering rules that match a single line at a time, just
- * append the RE matching rules and char rendering to the HPESyntaxHighlighter::highlightingRules.
+ * Therefore, to add rendering rules that match a single line at a time, add a kind
+ * to HPEMarkdownTokenizer and its char rendering to HPESyntaxHighlighter::tokenFormats.
  * 
- * @attention The adding process should be done in HPESyntaxHighlighter's constructor.
+ * @attention The formats should be set in HPESyntaxHighlighter's constructor.
  * 
  * @par Add multi-Line Matching and Rendering Rules
  * 
- * Should match in highlightBlock()
+ * Multi-line constructs (Front-Matter, code fences, math blocks and HTML blocks)
+ * are matched in highlightBlock(). The construct a block ends in is stored in its block state
+ * (see HPESyntaxHighlighter::BlockState), and the state of a block depends only on
+ * the state of the previous block and its own text.
+ * 
+ * QSyntaxHighlighter highlights the next block only if the state of a block changes,
+ * so typing inside a code fence of thousands of lines highlights only the edited block,
+ * while opening or closing a construct highlights the blocks up to where the states meet again.
+ * Inline tokens are not rendered inside multi-line constructs.
+ * 
+ * The code of a code fence whose info string names a language known by HPECodeLexer
+ * is highlighted line by line, within the time budget CODE_TIME_BUDGET.
+ * 
+ * @par Highlighting in the Background
+ * 
+ * Highlighting a large document at once freezes the UI, so setHighlightingDeferred() can be called
+ * before loading it. Then highlightBlock() only marks blocks as Deferred, except those before
+ * the horizon and the visible ones passed to highlightVisibleBlocks(). The horizon advances
+ * from the first block in time slices of TIME_SLICE ms, scheduled by a zero timer, that is,
+ * whenever the event loop is idle, and progressChanged() is emitted after each slice.
+ * 
+ * A visible block highlighted before the horizon reaches it supposes that it isn't inside
+ * a multi-line construct. It is highlighted again when the horizon reaches it and its real
+ * previous state is known, and the cascade fixes the blocks after it if needed.
+ * 
+ * @par Headings
+ * 
+ * Every block highlightBlock() highlights is passed to the HPEHeadingIndex set by setHeadingIndex(),
+ * with the level of its heading or 0, so the outline follows the edits without scanning the document.
  * 
  * For more information, visit {https://doc.qt.io/qt-6/qtwidgets-richtext-syntaxhighlighter-example.html}{Syntax Highlighter Example}
 */
@@ -62,6 +96,78 @@ public:
     */
     explicit HPESyntaxHighlighter(QTextDocument *parent);
 
+    /**
+     * @brief If deferred, the blocks changed from now on are highlighted in the background,
+     * until the end of the document is reached. Call it before loading a large text.
+     * Otherwise blocks are highlighted at once as usual.
+     * 
+     * @param[in] deferred
+    */
+    void setHighlightingDeferred(bool deferred);
+
+    /**
+     * @brief Highlight the deferred blocks from first to last (both included) immediately,
+     * and keep them highlighted when they are edited
+     * 
+     * @param[in] first The first visible block
+     * @param[in] last The last visible block
+    */
+    void highlightVisibleBlocks(const QTextBlock& first, const QTextBlock& last);
+
+    /**
+     * @brief Returns whether blocks are still highlighted in the background
+     * 
+    */
+    bool isDeferring() const;
+
+    /**
+     * @brief Returns the ratio of the blocks before the horizon, from 0.0 to 1.0.
+     * It is 1.0 if nothing is deferred.
+     * 
+    */
+    double progress() const;
+
+    /**
+     * @brief Report the headings of the blocks highlighted from now on to index
+     * 
+     * @param[in] index Null to stop reporting
+    */
+    void setHeadingIndex(HPEHeadingIndex* index);
+
+    /**
+     * @brief The kind of the multi-line construct a block ends in, stored in the lowest 4 bits of
+     * the block state. For CodeFence, the state also stores the opening fence:
+     * TildeFence if it is made of '~', its length in the 8 bits from FenceLengthShift,
+     * the HPECodeLexer::Language of its info string in the 8 bits from LanguageShift,
+     * and the HPECodeLexer::State the line of code ends in from LexerStateShift.
+     * 
+     * A block not inside any construct has the default state -1.
+     * 
+     * For a fence of three backticks with the info string "cpp", whose second line opens a block comment
+     * that the third line closes:
+     * 
+     *      line 1, the opening fence       CodeFence | (3 << FenceLengthShift) | (Cpp << LanguageShift)
+     *      line 2, opens the comment       ... | (BlockComment << LexerStateShift)
+     *      line 3, closes the comment      CodeFence | (3 << FenceLengthShift) | (Cpp << LanguageShift)
+     *      line 4, the closing fence       -1
+    */
+    enum BlockState
+    {
+        Deferred         = -2,  ///< not highlighted yet, see setHighlightingDeferred()
+        Normal           = -1,
+        FrontMatter      = 1,
+        CodeFence        = 2,
+        MathBlock        = 3,
+        HtmlBlock        = 4,   ///< ends at a blank line
+        HtmlRawBlock     = 5,   ///< <script>, <pre>, <style> or <textarea>, ends at the closing tag
+        HtmlComment      = 6,   ///< ends at '-->'
+        KindMask         = 0x0F,
+        TildeFence       = 0x10,
+        FenceLengthShift = 8,
+        LanguageShift    = 16,
+        LexerStateShift  = 24
+    };
+
 protected:
 
     /**
@@ -71,19 +177,146 @@ protected:
     */
     void highlightBlock(const QString &text) override;
 
+private slots:
+/**
+ * @defgroup slots
+ * @{
+*/
+
+    /**
+     * @brief Highlight the blocks from the horizon for TIME_SLICE ms, and schedule
+     * the next slice if the end of the document isn't reached
+     * 
+    */
+    void highlightNextSlice();
+
+    /**
+     * @brief Start a new time budget of code, and highlight the code left by the last one
+     * 
+     * @see CODE_TIME_BUDGET
+    */
+    void highlightPendingCode();
+/**
+ * @}
+*/
+
+signals:
+/**
+ * @defgroup signals
+ * @{
+*/
+
+    /**
+     * @brief This signal is emitted after each slice of background highlighting
+     * 
+     * @param[in] progress See progress(), 1.0 when all blocks are highlighted
+    */
+    void progressChanged(double progress);
+/**
+ * @}
+*/
+
 private:
 
-    struct HighlightRule
-    {
-        QRegularExpression pattern;
-        QTextCharFormat format;
-    };
+    /**
+     * @brief Returns whether block should be left to the background highlighting
+     * 
+    */
+    bool isDeferred(const QTextBlock& block) const;
+
+    /**
+     * @brief Highlight the code of a block inside the code fence of state
+     * 
+     * @param[in] text
+     * @param[in] state The state of the previous block
+     * @return The state of this block
+    */
+    int highlightCode(const QString& text, int state);
+
+    /**
+     * @brief Returns the format of the blocks inside the construct of state
+     * 
+    */
+    const QTextCharFormat& formatOfState(int state) const;
+
+    /**
+     * @brief Pass the heading of the current block to m_headingIndex
+     * 
+     * @param[in] text
+     * @param[in] level 0 if the block isn't a heading
+    */
+    void updateHeading(const QString& text, int level);
+
+    /**
+     * @brief This property stores the format of each kind of HPEMarkdownTokenizer::Token
+     * 
+    */
+    QTextCharFormat tokenFormats[HPEMarkdownTokenizer::KindCount];
 
     /**
-     * @brief This property stores all single-line-matching and rendering rules
+     * @brief Reused by highlightBlock()
      * 
     */
-    QVector<HighlightRule> highlightingRules;
+    HPEMarkdownTokenizer::Tokens tokens;
+
+    /**
+     * @brief The length (ms) of a slice of background highlighting, and the number of blocks
+     * the horizon advances at a time in a slice
+     * 
+    */
+    static constexpr int TIME_SLICE   = 8;
+    static constexpr int CHUNK_BLOCKS = 128;
+
+    /**
+     * @brief Whether blocks are highlighted in the background
+     * 
+    */
+    bool m_deferring = false;
+
+    /**
+     * @brief The blocks before the horizon and the visible blocks are highlighted as usual.
+     * Cursors follow the edits of the document.
+     * 
+    */
+    QTextCursor m_horizon;
+    QTextCursor m_visibleFrom;
+    QTextCursor m_visibleTo;
+
+    QTimer m_sliceTimer;
+
+    /**
+     * @brief This property stores the format of each kind of HPECodeLexer::Token
+     * 
+    */
+    QTextCharFormat codeTokenFormats[HPECodeLexer::KindCount];
+
+    /**
+     * @brief Reused by highlightCode()
+     * 
+    */
+    HPECodeLexer::Tokens codeTokens;
+
+    /**
+     * @brief The time (ms) code may be lexed in a turn of the event loop, and the length
+     * from which a line of code is left plain.
+     * 
+     * Opening a block comment in a huge listing changes the state of every line after it.
+     * When the budget is used up, the cascade is stopped by keeping the old state of the block,
+     * and goes on from that block in the next turn, so typing never stalls.
+    */
+    static constexpr int CODE_TIME_BUDGET = 12;
+    static constexpr int CODE_LENGTH_LIMIT = 4096;
+
+    QElapsedTimer m_codeBudget;
+    QTimer m_codeBudgetTimer;
+
+    /**
+     * @brief The first block left by the last time budget, null if none
+     * 
+    */
+    QTextCursor m_pendingCode;
+
+    HPEHeadingIndex* m_headingIndex = nullptr;
 
     QTextCharFormat headingFormat;
     QTextCharFormat boldFormat;
@@ -96,6 +329,10 @@ private:
 
     QTextCharFormat frontMatterFormat;
     QTextCharFormat tagPluginFormat;
+
+    QTextCharFormat codeFormat;
+    QTextCharFormat mathFormat;
+    QTextCharFormat htmlFormat;
 };
 
 #endif // HPESYNTAXHIGHLIGHTER_H
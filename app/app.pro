@@ -26,17 +26,34 @@ SOURCES += \
     Dialogs/hpetabledialogform.cpp \
     ThirdParty/Terminal/qterminalprocess.cpp \
     ThirdParty/Terminal/qterminalwidget.cpp \
+    Editor/hpecodelexer.cpp \
     Editor/hpeconvertedmarkdownpreview.cpp \
+    Controller/hpeassetresolver.cpp \
     Controller/hpedocument.cpp \
+    Controller/hpedocumentschemehandler.cpp \
+    Editor/hpefindbar.cpp \
+    Controller/hpefrontmatter.cpp \
+    Editor/hpeheadingindex.cpp \
     Controller/hpehexocontroller.cpp \
+    Controller/hpehtmlcache.cpp \
+    Controller/hpeimageproxy.cpp \
     Editor/hpelinenumberarea.cpp \
+    Editor/hpelinkindex.cpp \
+    Controller/hpelinkscanner.cpp \
     Controller/hpelocalresources.cpp \
+    Controller/hpemarkdownconverter.cpp \
+    Controller/hpemarkdownrenderer.cpp \
+    Editor/hpeoutlinepanel.cpp \
+    Controller/hpepiecetable.cpp \
+    Controller/hpepreviewscheduler.cpp \
     Editor/hpemarkdowneditor.cpp \
+    Editor/hpemarkdowntokenizer.cpp \
     Frame/hpeprettyframe.cpp \
     Controller/hpepreviewpage.cpp \
     Controller/hpesettings.cpp \
     Frame/hpesplitter.cpp \
     Editor/hpesyntaxhighlighter.cpp \
+    Controller/hpetextsearcher.cpp \
     main.cpp \
     hpemainwindow.cpp
 
@@ -54,18 +71,35 @@ HEADERS += \
     Dialogs/hpetabledialogform.h \
     ThirdParty/Terminal/qterminalprocess.h \
     ThirdParty/Terminal/qterminalwidget.h \
+    Editor/hpecodelexer.h \
     Editor/hpeconvertedmarkdownpreview.h \
+    Controller/hpeassetresolver.h \
     Controller/hpedocument.h \
+    Controller/hpedocumentschemehandler.h \
+    Editor/hpefindbar.h \
+    Controller/hpefrontmatter.h \
+    Editor/hpeheadingindex.h \
     Controller/hpehexocontroller.h \
+    Controller/hpehtmlcache.h \
+    Controller/hpeimageproxy.h \
     Editor/hpelinenumberarea.h \
+    Editor/hpelinkindex.h \
+    Controller/hpelinkscanner.h \
     Controller/hpelocalresources.h \
+    Controller/hpemarkdownconverter.h \
+    Controller/hpemarkdownrenderer.h \
+    Editor/hpeoutlinepanel.h \
+    Controller/hpepiecetable.h \
+    Controller/hpepreviewscheduler.h \
     hpemainwindow.h \
     Editor/hpemarkdowneditor.h \
+    Editor/hpemarkdowntokenizer.h \
     Frame/hpeprettyframe.h \
     Controller/hpepreviewpage.h \
     Controller/hpesettings.h \
     Frame/hpesplitter.h \
-    Editor/hpesyntaxhighlighter.h
+    Editor/hpesyntaxhighlighter.h \
+    Controller/hpetextsearcher.h
 
 FORMS += \
     Dialogs/hpeaboutdialog.ui \
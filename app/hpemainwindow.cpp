@@ -14,13 +14,19 @@
 #include "ui_hpemainwindow.h"
 
 #include "Controller/hpedocument.h"
+#include "Controller/hpedocumentschemehandler.h"
+#include "Controller/hpeimageproxy.h"
 #include "Controller/hpepreviewpage.h"
+#include "Controller/hpepreviewscheduler.h"
 #include "Controller/hpesettings.h"
 #include "Controller/hpehexocontroller.h"
 #include "Controller/hpelocalresources.h"
 
 #include "Editor/hpemarkdowneditor.h"
+#include "Editor/hpelinkindex.h"
 #include "Editor/hpeconvertedmarkdownpreview.h"
+#include "Editor/hpefindbar.h"
+#include "Editor/hpeoutlinepanel.h"
 
 #include "Dialogs/hpedialog.h"
 #include "Dialogs/hpestartupdialog.h"
@@ -28,6 +34,8 @@
 
 #include "ThirdParty/Terminal/qterminalwidget.h"
 
+#include <QScrollBar>
+
 HPEMainWindow::HPEMainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::HPEMainWindow)
@@ -41,8 +49,24 @@ HPEMainWindow::HPEMainWindow(QWidget *parent)
 
     //init pointers
     m_document = new HPEDocument();
+    if(HPESettings::config()->value("preview/renderer", "marked").toString() == "native")
+        m_document->setHtmlRenderer([this](const QString& markdown){
+            return ui->convertedMarkdownPreview->renderHtml(markdown);
+        });
+    m_previewScheduler = new HPEPreviewScheduler(m_document, this);
 
     HPEPreviewPage* page = new HPEPreviewPage(this);
+    //large updates are fetched by the page from 'hpe://doc/<version>'
+    if(!page->profile()->urlSchemeHandler(HPEDocumentSchemeHandler::SCHEME))
+        page->profile()->installUrlSchemeHandler(HPEDocumentSchemeHandler::SCHEME,
+                                                 new HPEDocumentSchemeHandler(m_document, this));
+    //large local images are loaded downscaled from 'hpe-image://image/<path>'
+    if(!page->profile()->urlSchemeHandler(HPEImageProxy::SCHEME))
+    {
+        HPEImageProxy* imageProxy = new HPEImageProxy(getAssetResolver(), this);
+        imageProxy->watchWidth(ui->markdownPreview);
+        page->profile()->installUrlSchemeHandler(HPEImageProxy::SCHEME, imageProxy);
+    }
     ui->markdownPreview->setPage(page);
     ui->markdownPreview->setUrl(HPELocalResources::getLocalURLWithName("index.html"));
 
@@ -54,6 +78,8 @@ HPEMainWindow::HPEMainWindow(QWidget *parent)
 
     createLogPanel();
     createTerminal();
+    createOutlinePanel();
+    createFindBar();
 
     m_hexoController = new HPEHexoController(m_terminalWidget->getProcess(), QDir(""), this);
 
@@ -87,6 +113,11 @@ QString HPEMainWindow::getFilePath() const
     return m_filePath;
 }
 
+HPEAssetResolver *HPEMainWindow::getAssetResolver() const
+{
+    return ui->convertedMarkdownPreview->assetResolver();
+}
+
 void HPEMainWindow::loadQSSFile()
 {
     QFile file(":/resources/style.qss");
@@ -129,10 +160,17 @@ void HPEMainWindow::bindingMenuEvents()
 void HPEMainWindow::bindingEditorEvents()
 {
     ui->convertedMarkdownPreview->connectEditor(ui->markdownField);
-    connect(this, &HPEMainWindow::fileLoaded, ui->convertedMarkdownPreview, &HPEConvertedMarkdownPreview::filePathChanged);
-    connect(ui->convertedMarkdownPreview, &HPEConvertedMarkdownPreview::convertedAll, this, [this](const QString& preview){
-        m_document->setText(preview);
+    connect(ui->markdownField, &HPEMarkdownEditor::highlightingProgressChanged, this, [this](double progress){
+        if(progress >= 1.0)
+            QLOG_INFO() << QString("File %1 highlighted").arg(m_filePath);
     });
+    connect(this, &HPEMainWindow::fileLoaded, m_document, &HPEDocument::setRenderContext);
+    connect(this, &HPEMainWindow::fileLoaded, ui->convertedMarkdownPreview, &HPEConvertedMarkdownPreview::filePathChanged);
+    //the scheduler coalesces the changes before they reach m_document
+    connect(ui->convertedMarkdownPreview, &HPEConvertedMarkdownPreview::convertedAll,
+            m_previewScheduler, &HPEPreviewScheduler::setText);
+    connect(ui->convertedMarkdownPreview, &HPEConvertedMarkdownPreview::convertedChanged,
+            m_previewScheduler, &HPEPreviewScheduler::applyChange);
     connect(ui->actionMenuStrong, &QAction::triggered, ui->markdownField,
             [this]() { ui->markdownField->wrapSelectionWithString("**"); });
     connect(ui->actionMenuItalic, &QAction::triggered, ui->markdownField,
@@ -200,20 +238,13 @@ void HPEMainWindow::bindingHexoControllerEvents()
 
 void HPEMainWindow::synchronizeEditorScrollWithPage()
 {
-    connect(ui->markdownField, &HPEMarkdownEditor::scrollVerticallyBy, this, [this](double d){
-        double delta = d;
-#ifdef Q_OS_MACOS
-        //on macOS, the delta hasgot inverted
-        delta *= -1.0;
-#endif
-
-        ui->markdownPreview->page()->runJavaScript(
-                    QString("window.scrollBy({left:0,top: %1 *document.body.clientHeight,behavior: 'smooth'})")
-                    .arg(delta / ui->markdownField->geometry().height()));
-        //it's weird to scroll server page syncly
-        //ui->postPreview->page()->runJavaScript(
-        //            QString("window.scrollBy({left:0,top: %1 *document.body.clientHeight,behavior: 'smooth'})")
-        //            .arg(double(delta) / ui->markdownField->geometry().height()));
+    //the page scrolls to the element of the block at the top of the editor,
+    //and the blocks there are previewed first
+    connect(ui->markdownField->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]{
+        int blockNumber = ui->markdownField->firstVisibleBlockNumber();
+        double offset = blockNumber < ui->convertedMarkdownPreview->frontMatter().bodyStart()
+                ? 0.0 : ui->markdownField->firstVisibleBlockOffset();
+        m_document->scrollToLine(ui->convertedMarkdownPreview->outputLineOfSourceBlock(blockNumber), offset);
     });
 }
 
@@ -242,9 +273,32 @@ void HPEMainWindow::openFile(const QString &path)
     m_fileDir = QDir(QFileInfo(m_filePath).absoluteDir());
 
     m_hexoController->setDir(m_fileDir);
-    ui->markdownField->setPlainText(f.readAll());
+    if(f.size() >= HPEMarkdownEditor::LARGE_FILE_THRESHOLD)
+    {
+        //the file is mapped rather than read
+        f.close();
+        QString errorString;
+        if(!ui->markdownField->loadLargeFile(path, &errorString))
+        {
+            QMessageBox::warning(this, windowTitle(),
+                                 tr("Could not open file %1: %2").arg(
+                                     QDir::toNativeSeparators(path), errorString));
+            return;
+        }
+    }
+    else
+        ui->markdownField->loadText(QString::fromUtf8(f.readAll()));
     QLOG_INFO() << QString("File %1 loaded").arg(m_filePath);
     emit fileLoaded(m_filePath);
+
+    //one line however many are missing, the list at debug level
+    const QVector<HPELinkIndex::Entry> missingImages = ui->markdownField->linkIndex()->missingImages(getAssetResolver());
+    if(missingImages.isEmpty())
+        return;
+    QLOG_WARN() << QString("%1 image(s) not found, the first one %2 (line %3)").arg(missingImages.size())
+                   .arg(missingImages.first().url).arg(missingImages.first().blockNumber + 1);
+    for(const HPELinkIndex::Entry& image : missingImages)
+        QLOG_DEBUG() << QString("Image %1 not found (line %2)").arg(image.url).arg(image.blockNumber + 1);
 }
 
 void HPEMainWindow::setWindowSizeState(const QString &state)
@@ -310,6 +364,22 @@ void HPEMainWindow::createTerminal()
     ui->terminalPage->layout()->addWidget(m_terminalWidget);
 }
 
+void HPEMainWindow::createOutlinePanel()
+{
+    HPEOutlinePanel* outlinePanel = new HPEOutlinePanel(ui->tabWidget);
+    outlinePanel->connectEditor(ui->markdownField);
+    ui->tabWidget->addTab(outlinePanel, tr("Outline"));
+}
+
+void HPEMainWindow::createFindBar()
+{
+    HPEFindBar* findBar = new HPEFindBar(ui->leftFrame);
+    findBar->connectEditor(ui->markdownField);
+    findBar->hide();
+    ui->leftFrame->layout()->addWidget(findBar);
+    connect(ui->actionMenuFind, &QAction::triggered, findBar, &HPEFindBar::activate);
+}
+
 void HPEMainWindow::onLogUpdate(const QString &msg, int level)
 {
     QPlainTextEdit* logPanel = ui->loggerPage->findChild<QPlainTextEdit*>();
@@ -350,16 +420,30 @@ void HPEMainWindow::onFileSave()
         return;
     }
 
-    QFile f(m_filePath);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+    if (ui->markdownField->isLargeFileMode())
     {
-        QMessageBox::warning(this, windowTitle(),
-                             tr("Could not write to file %1: %2").arg(
-                             QDir::toNativeSeparators(m_filePath), f.errorString()));
-        return;
+        QString errorString;
+        if (!ui->markdownField->saveLargeFile(m_filePath, &errorString))
+        {
+            QMessageBox::warning(this, windowTitle(),
+                                 tr("Could not write to file %1: %2").arg(
+                                 QDir::toNativeSeparators(m_filePath), errorString));
+            return;
+        }
+    }
+    else
+    {
+        QFile f(m_filePath);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            QMessageBox::warning(this, windowTitle(),
+                                 tr("Could not write to file %1: %2").arg(
+                                 QDir::toNativeSeparators(m_filePath), f.errorString()));
+            return;
+        }
+        QTextStream str(&f);
+        str << ui->markdownField->toPlainText();
     }
-    QTextStream str(&f);
-    str << ui->markdownField->toPlainText();
 
     ui->markdownField->document()->setModified(false);
     QLOG_INFO() << QString("File %1 saved").arg(m_filePath);
@@ -29,6 +29,8 @@ QT_END_NAMESPACE
 
 class HPEMarkdownEditor;
 class HPEDocument;
+class HPEPreviewScheduler;
+class HPEAssetResolver;
 class HPEDialog;
 class HPEAboutDialog;
 class HPEHexoController;
@@ -47,8 +49,9 @@ class QTerminalWidget;
  * HPEMainWindow has 1 HPEMarkdownEditor(ui->markdownField) for input,
  * 1 QWebEngineView(ui->markdownPreview) for viewing rendered Markdown,
  * 1 QWebEngineView(ui->postPreview) for viewing Hexo posts' preview page (the one running by Hexo's local server),
- * 1 HPEMarkdownEditor(ui->convertedMarkdownPreview) for viewing the source of Markdown (converted from Hexo's post),
+ * 1 HPEConvertedMarkdownPreview(ui->convertedMarkdownPreview) for viewing the source of Markdown (converted from Hexo's post),
  * 1 QTerminalWidget*(m_terminalWidget),
+ * 1 HPEOutlinePanel for navigating the headings of ui->markdownField,
  * 1 ui->loggerPage for showing runtime logs.
  * 
  * @note * Actually, using LXQt's QTermWidget(https://github.com/lxqt/qtermwidget) which is much more stable is better,
@@ -70,8 +73,8 @@ class QTerminalWidget;
  * 
  * @par Exposure
  * 
- * HPEMainWindow exposes ui->markdownField and the path of current file
- * by getEditor() and getFilePath().
+ * HPEMainWindow exposes ui->markdownField, the path of current file and the resolver of its images
+ * by getEditor(), getFilePath() and getAssetResolver().
  * 
  * It also exposes openFile() method to load file.
 */
@@ -109,6 +112,13 @@ private:
     */
     HPEDocument* m_document = nullptr;
 
+    /**
+     * @brief Coalesces the converted changes, and decides when they reach m_document and the web page
+     * 
+     * @see HPEPreviewScheduler
+    */
+    HPEPreviewScheduler* m_previewScheduler = nullptr;
+
     /**
      * @brief The absolute path of current file
      * 
@@ -147,6 +157,13 @@ public:
     */
     QString getFilePath() const;
 
+    /**
+     * @brief Return the resolver of images' paths of the file loaded
+     * 
+     * @return The HPEAssetResolver shared with the converter
+    */
+    HPEAssetResolver* getAssetResolver() const;
+
     /**
      * @brief Open a new file with path.
      * This method will stop Hexo server if the Hexo directory has changed.
@@ -250,6 +267,18 @@ private:
     */
     void createTerminal();
 
+    /**
+     * @brief Create an HPEOutlinePanel of ui->markdownField in a new tab
+     * 
+    */
+    void createOutlinePanel();
+
+    /**
+     * @brief Create an HPEFindBar of ui->markdownField under it, shown by ui->actionMenuFind
+     * 
+    */
+    void createFindBar();
+
 private slots:
 /**
  * @defgroup slots
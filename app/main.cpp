@@ -33,9 +33,15 @@
 #include <QTranslator>
 
 #include "Dialogs/hpestartupdialog.h"
+#include "Controller/hpedocumentschemehandler.h"
+#include "Controller/hpeimageproxy.h"
 
 int main(int argc, char *argv[])
 {
+    //custom schemes must be registered before QApplication is constructed
+    HPEDocumentSchemeHandler::registerUrlScheme();
+    HPEImageProxy::registerUrlScheme();
+
     QApplication a(argc, argv);
 
     //Core application settings
@@ -0,0 +1,42 @@
+QT += gui
+QT += widgets
+QT += testlib
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+INCLUDE_DIR = ../../app
+
+INCLUDEPATH += $$INCLUDE_DIR
+HEADERS += \
+        $$INCLUDE_DIR/Controller/hpeassetresolver.h \
+        $$INCLUDE_DIR/Controller/hpelinkscanner.h \
+        $$INCLUDE_DIR/Controller/hpemarkdownrenderer.h \
+        $$INCLUDE_DIR/Controller/hpepiecetable.h \
+        $$INCLUDE_DIR/Controller/hpetextsearcher.h \
+        $$INCLUDE_DIR/Editor/hpecodelexer.h \
+        $$INCLUDE_DIR/Editor/hpeheadingindex.h \
+        $$INCLUDE_DIR/Editor/hpelinenumberarea.h \
+        $$INCLUDE_DIR/Editor/hpelinkindex.h \
+        $$INCLUDE_DIR/Editor/hpemarkdowneditor.h \
+        $$INCLUDE_DIR/Editor/hpemarkdowntokenizer.h \
+        $$INCLUDE_DIR/Editor/hpesyntaxhighlighter.h
+SOURCES += \
+        main.cpp \
+        $$INCLUDE_DIR/Controller/hpeassetresolver.cpp \
+        $$INCLUDE_DIR/Controller/hpelinkscanner.cpp \
+        $$INCLUDE_DIR/Controller/hpemarkdownrenderer.cpp \
+        $$INCLUDE_DIR/Controller/hpepiecetable.cpp \
+        $$INCLUDE_DIR/Controller/hpetextsearcher.cpp \
+        $$INCLUDE_DIR/Editor/hpecodelexer.cpp \
+        $$INCLUDE_DIR/Editor/hpeheadingindex.cpp \
+        $$INCLUDE_DIR/Editor/hpelinenumberarea.cpp \
+        $$INCLUDE_DIR/Editor/hpelinkindex.cpp \
+        $$INCLUDE_DIR/Editor/hpemarkdowneditor.cpp \
+        $$INCLUDE_DIR/Editor/hpemarkdowntokenizer.cpp \
+        $$INCLUDE_DIR/Editor/hpesyntaxhighlighter.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
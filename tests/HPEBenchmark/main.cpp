@@ -0,0 +1,938 @@
+#include <QtTest>
+#include <QRegularExpression>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QBuffer>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextLayout>
+
+#include "Controller/hpeassetresolver.h"
+#include "Controller/hpelinkscanner.h"
+#include "Controller/hpemarkdownrenderer.h"
+#include "Controller/hpepiecetable.h"
+#include "Controller/hpetextsearcher.h"
+#include "Editor/hpecodelexer.h"
+#include "Editor/hpeheadingindex.h"
+#include "Editor/hpelinkindex.h"
+#include "Editor/hpemarkdowneditor.h"
+#include "Editor/hpemarkdowntokenizer.h"
+#include "Editor/hpesyntaxhighlighter.h"
+
+/**
+ * @brief An HPESyntaxHighlighter counting the highlighted blocks
+ * 
+*/
+class CountingHighlighter : public HPESyntaxHighlighter
+{
+public:
+    using HPESyntaxHighlighter::HPESyntaxHighlighter;
+    int count = 0;
+
+protected:
+    void highlightBlock(const QString &text) override
+    {
+        ++count;
+        HPESyntaxHighlighter::highlightBlock(text);
+    }
+};
+
+/**
+ * @brief Benchmarks of the hot paths of converting and previewing
+ * 
+*/
+class HPEBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QStringList m_lines;
+    QString m_text;
+
+    /**
+     * @brief The lines of a real post (the README of the repository)
+     * 
+    */
+    QStringList m_postLines;
+
+    /**
+     * @brief The rules HPESyntaxHighlighter used before HPEMarkdownTokenizer, in the same order
+     * 
+    */
+    QList<QRegularExpression> m_highlightRules;
+
+    /**
+     * @brief Returns the tokens of line found by m_highlightRules
+     * 
+    */
+    QList<QList<int>> tokensByRegex(const QString& line) const
+    {
+        QList<QList<int>> tokens;
+        for(int kind = 0; kind < m_highlightRules.size(); ++kind)
+        {
+            QRegularExpressionMatchIterator iterator = m_highlightRules.at(kind).globalMatch(line);
+            while(iterator.hasNext())
+            {
+                QRegularExpressionMatch match = iterator.next();
+                tokens.append({ kind, int(match.capturedStart()), int(match.capturedLength()) });
+            }
+        }
+        return tokens;
+    }
+
+    static QList<QList<int>> tokensByTokenizer(const QString& line)
+    {
+        QList<QList<int>> tokens;
+        HPEMarkdownTokenizer::Tokens found;
+        HPEMarkdownTokenizer::tokenize(line, found);
+        for(const HPEMarkdownTokenizer::Token& token : qAsConst(found))
+            tokens.append({ int(token.kind), token.start, token.length });
+        return tokens;
+    }
+
+    /**
+     * @brief Returns the block numbers, positions and URLs of all matches in document, scanned from scratch
+     * 
+    */
+    static QList<QList<QVariant>> linksOf(const QTextDocument& document)
+    {
+        QList<QList<QVariant>> links;
+        for(QTextBlock block = document.begin(); block.isValid(); block = block.next())
+        {
+            const QString text = block.text();
+            HPELinkScanner scanner(text);
+            HPELinkScanner::Match match;
+            while(scanner.next(match))
+                links.append({ block.blockNumber(), int(match.start), text.mid(match.urlStart, match.urlLength) });
+        }
+        return links;
+    }
+
+    static QList<QList<QVariant>> linksOf(const HPELinkIndex& index, int blockCount)
+    {
+        QList<QList<QVariant>> links;
+        for(const HPELinkIndex::Entry& entry : index.entries(0, blockCount))
+            links.append({ entry.blockNumber, entry.position, entry.url });
+        return links;
+    }
+
+    static QList<QList<QVariant>> headingsOf(const HPEHeadingIndex& index)
+    {
+        QList<QList<QVariant>> headings;
+        for(int i = 0; i < index.count(); ++i)
+        {
+            HPEHeadingIndex::Heading heading = index.heading(i);
+            headings.append({ heading.level, heading.title, heading.blockNumber });
+        }
+        return headings;
+    }
+
+    static QList<QList<int>> matchesOf(const QTextDocument& document, const HPETextSearcher& searcher)
+    {
+        QList<QList<int>> matches;
+        for(QTextBlock block = document.firstBlock(); block.isValid(); block = block.next())
+            for(const HPETextSearcher::Match& match : searcher.findAll(block.text()))
+                matches.append({ block.position() + int(match.start), int(match.length) });
+        return matches;
+    }
+
+    static QList<QList<int>> matchesOf(const QTextDocument& document, const QRegularExpression& pattern,
+                                       QTextDocument::FindFlags flags)
+    {
+        QList<QList<int>> matches;
+        for(QTextCursor cursor = document.find(pattern, 0, flags); !cursor.isNull(); cursor = document.find(pattern, cursor, flags))
+            matches.append({ cursor.selectionStart(), cursor.selectionEnd() - cursor.selectionStart() });
+        return matches;
+    }
+
+    static QList<QList<int>> codeTokensOf(HPECodeLexer::Language language, const QString& line, int& state)
+    {
+        QList<QList<int>> tokens;
+        HPECodeLexer::Tokens found;
+        state = HPECodeLexer::tokenize(language, line, state, found);
+        for(const HPECodeLexer::Token& token : qAsConst(found))
+            tokens.append({ int(token.kind), token.start, token.length });
+        return tokens;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        //a long post with images and links in every few lines
+        for(int i = 0; i < 5000; ++i)
+        {
+            switch(i % 4)
+            {
+            case 0: m_lines.append(QString("Some text with a [link %1](https://example.com/%1) in it.").arg(i)); break;
+            case 1: m_lines.append(QString("![image %1](image-%1.png \"title\") and ![another](/images/%1.jpg)").arg(i)); break;
+            case 2: m_lines.append(QString("<img src=\"image-%1.png\" alt=\"raw\"> followed by `[code](span)`").arg(i)); break;
+            default: m_lines.append(QString("A plain paragraph line number %1 without any links at all.").arg(i)); break;
+            }
+        }
+        m_text = m_lines.join('\n');
+
+        QFile post(QFINDTESTDATA("../../README.md"));
+        if(post.open(QIODevice::ReadOnly | QIODevice::Text))
+            m_postLines = QString::fromUtf8(post.readAll()).split('\n');
+        m_postLines.append(m_lines.mid(0, 200));
+
+        for(const char* pattern : { "^#+ (.*)$", "\\*([^ ]+)\\*", "\\*\\*([^ ]+)\\*\\*", "<u>(.*)</u>", "~~(.*)~~",
+                                    "^>(.*)$", "^- - -$", "\\{% (.+) %\\}", "\\[(.+)\\]\\((.+)\\)", "<http(.+)>",
+                                    "!\\[(.*)\\]\\((.+)\\)" })
+            m_highlightRules.append(QRegularExpression(pattern));
+    }
+
+    void scanImagesByRegex()
+    {
+        int count = 0;
+        QBENCHMARK {
+            for(const QString& line : qAsConst(m_lines))
+            {
+                QRegularExpressionMatch match = QRegularExpression(QString("\\!\\[.*\\]\\((.+)\\)")).match(line);
+                if(match.hasMatch() && QRegularExpression("^[a-zA-z]+://[^\\s]+$").match(match.captured(1)).hasMatch())
+                    ++count;
+            }
+        }
+        Q_UNUSED(count)
+    }
+
+    void scanImagesByScanner()
+    {
+        int count = 0;
+        QBENCHMARK {
+            for(const QString& line : qAsConst(m_lines))
+            {
+                HPELinkScanner scanner(line);
+                HPELinkScanner::Match match;
+                while(scanner.next(match))
+                    if(match.kind != HPELinkScanner::Link
+                            && HPELinkScanner::isUrl(QStringView(line).mid(match.urlStart, match.urlLength)))
+                        ++count;
+            }
+        }
+        Q_UNUSED(count)
+    }
+
+    void listLinksByRegex()
+    {
+        int count = 0;
+        QBENCHMARK {
+            QRegularExpressionMatchIterator iterator = QRegularExpression("\\[(.+)\\]\\((.+)\\)").globalMatch(m_text);
+            while(iterator.hasNext())
+            {
+                QRegularExpressionMatch match = iterator.next();
+                count += match.captured(1).size() + match.captured(2).size();
+            }
+        }
+        Q_UNUSED(count)
+    }
+
+    void listLinksByScanner()
+    {
+        int count = 0;
+        QBENCHMARK {
+            HPELinkScanner scanner(m_text);
+            HPELinkScanner::Match match;
+            while(scanner.next(match))
+                if(match.kind == HPELinkScanner::Link)
+                    count += m_text.mid(match.textStart, match.textLength).size()
+                            + m_text.mid(match.urlStart, match.urlLength).size();
+        }
+        Q_UNUSED(count)
+    }
+
+    void listLinksByIndex()
+    {
+        QTextDocument document(m_text);
+        HPELinkIndex index(&document);
+        QTextCursor cursor(document.findBlockByNumber(2500));
+        int count = 0;
+        QBENCHMARK {
+            //an edit, then a query
+            cursor.insertText("x");
+            count += index.links().size();
+        }
+        Q_UNUSED(count)
+    }
+
+    void encodeAsWebChannelMessage()
+    {
+        //the encoding QWebChannel does in process: a signal becomes a JSON message, which is parsed back
+        qsizetype size = 0;
+        QBENCHMARK {
+            QJsonObject message;
+            message["type"] = 1;
+            message["object"] = "content";
+            message["signal"] = 5;
+            message["args"] = QJsonArray({ m_text });
+            QByteArray data = QJsonDocument(message).toJson(QJsonDocument::Compact);
+            size += QJsonDocument::fromJson(data).object().value("args").toArray().at(0).toString().size();
+        }
+        Q_UNUSED(size)
+    }
+
+    void encodeAsPayload()
+    {
+        //the encoding of a payload in process: HPEDocumentSchemeHandler replies a UTF-8 buffer, which is decoded,
+        //the fetch by the web page is not timed
+        qsizetype size = 0;
+        QBENCHMARK {
+            QBuffer buffer;
+            buffer.setData(m_text.toUtf8());
+            buffer.open(QIODevice::ReadOnly);
+            size += QString::fromUtf8(buffer.readAll()).size();
+        }
+        Q_UNUSED(size)
+    }
+
+    void highlightByRegex()
+    {
+        int count = 0;
+        QBENCHMARK {
+            for(const QString& line : qAsConst(m_postLines))
+                for(const QRegularExpression& rule : qAsConst(m_highlightRules))
+                {
+                    QRegularExpressionMatchIterator iterator = rule.globalMatch(line);
+                    while(iterator.hasNext())
+                        count += iterator.next().capturedLength();
+                }
+        }
+        Q_UNUSED(count)
+    }
+
+    void highlightByTokenizer()
+    {
+        int count = 0;
+        HPEMarkdownTokenizer::Tokens tokens;
+        QBENCHMARK {
+            for(const QString& line : qAsConst(m_postLines))
+            {
+                HPEMarkdownTokenizer::tokenize(line, tokens);
+                for(const HPEMarkdownTokenizer::Token& token : qAsConst(tokens))
+                    count += token.length;
+            }
+        }
+        Q_UNUSED(count)
+    }
+
+    void tokenizerMatchesRegex()
+    {
+        QStringList lines = m_postLines;
+        lines << "**bold** and *italic* *a b* ***x***" << "~~~" << "~~a~~ ~~b~~" << "<u>a</u> <u>b</u>"
+              << "![a](b) [c](d))" << "[a](b)](" << "{% a %} {% b %}" << "<https://a> <http>" << "### heading *x*"
+              << "> quote [a](b)" << "- - -" << "#no heading" << "**" << "*a*b*";
+        for(const QString& line : qAsConst(lines))
+            QCOMPARE(tokensByTokenizer(line), tokensByRegex(line));
+    }
+
+    void highlightInsideFence()
+    {
+        //a post with a code fence of 5000 lines in the middle
+        QStringList lines({ "---", "title: Fence", "---", "Before" });
+        lines << "```cpp" << m_lines << "```" << "$$" << "x^2" << "$$" << "<div>" << "**not bold**" << "" << "After";
+        QTextDocument document(lines.join('\n'));
+        CountingHighlighter highlighter(&document);
+        highlighter.rehighlight();
+
+        //typing inside the fence highlights only the edited block
+        QTextCursor cursor(document.findBlockByNumber(2000));
+        highlighter.count = 0;
+        cursor.insertText("**typing** `inside` ```");
+        QCOMPARE(highlighter.count, 1);
+
+        QCOMPARE(document.findBlockByNumber(0).userState(), int(HPESyntaxHighlighter::FrontMatter));
+        QCOMPARE(document.findBlockByNumber(2).userState(), int(HPESyntaxHighlighter::Normal));
+        QCOMPARE(document.findBlockByNumber(4).userState() & HPESyntaxHighlighter::KindMask,
+                 int(HPESyntaxHighlighter::CodeFence));
+        QCOMPARE(document.lastBlock().userState(), int(HPESyntaxHighlighter::Normal));
+
+        //closing the fence in an empty line highlights up to the end,
+        //as the old closing fence opens another one and every state after it changes
+        cursor.insertBlock();
+        cursor.insertBlock();
+        cursor.movePosition(QTextCursor::PreviousCharacter);
+        highlighter.count = 0;
+        cursor.insertText("```");
+        QCOMPARE(highlighter.count, document.blockCount() - 2001);
+        QCOMPARE(document.findBlockByNumber(2001).userState(), int(HPESyntaxHighlighter::Normal));
+        QCOMPARE(document.lastBlock().userState() & HPESyntaxHighlighter::KindMask,
+                 int(HPESyntaxHighlighter::CodeFence));
+    }
+
+    void highlightInBackground()
+    {
+        QStringList lines({ "---", "title: Background", "---" });
+        for(int i = 0; i < 8; ++i)
+            lines << m_lines << "```" << "code" << m_lines.mid(0, 100) << "```" << "<!--" << "comment" << "-->";
+        QString text = lines.join('\n');
+
+        QTextDocument expected(text);
+        HPESyntaxHighlighter expectedHighlighter(&expected);
+        expectedHighlighter.rehighlight();
+
+        //only the visible blocks are highlighted at once, these are inside a code fence
+        //but it isn't known until the blocks before them are highlighted
+        QTextDocument document;
+        HPESyntaxHighlighter highlighter(&document);
+        highlighter.setHighlightingDeferred(true);
+        document.setPlainText(text);
+        highlighter.highlightVisibleBlocks(document.findBlockByNumber(20330), document.findBlockByNumber(20380));
+        QCOMPARE(document.findBlockByNumber(10000).userState(), int(HPESyntaxHighlighter::Deferred));
+        QCOMPARE(document.findBlockByNumber(20350).userState(), int(HPESyntaxHighlighter::Normal));
+        QVERIFY(highlighter.progress() < 1.0);
+
+        //the rest is highlighted when the event loop is idle, into the same states
+        QSignalSpy progressSpy(&highlighter, &HPESyntaxHighlighter::progressChanged);
+        QTRY_VERIFY_WITH_TIMEOUT(!highlighter.isDeferring(), 60000);
+        QVERIFY(progressSpy.size() > 1);
+        QCOMPARE(progressSpy.last().at(0).toDouble(), 1.0);
+        for(QTextBlock block = document.begin(), other = expected.begin(); block.isValid();
+            block = block.next(), other = other.next())
+        {
+            QCOMPARE(block.userState(), other.userState());
+            QVERIFY(block.layout()->formats() == other.layout()->formats());
+        }
+    }
+
+    void highlightPost()
+    {
+        QTextDocument document(m_postLines.join('\n'));
+        HPESyntaxHighlighter highlighter(&document);
+        QBENCHMARK {
+            highlighter.rehighlight();
+        }
+    }
+
+    void lexCode()
+    {
+        QStringList lines;
+        for(int i = 0; i < 5000; ++i)
+            lines.append(QString("    if(value%1 != nullptr) return \"line %1\" + 0x%1; // comment %1").arg(i));
+        int count = 0;
+        HPECodeLexer::Tokens tokens;
+        QBENCHMARK {
+            int state = HPECodeLexer::Normal;
+            for(const QString& line : qAsConst(lines))
+            {
+                state = HPECodeLexer::tokenize(HPECodeLexer::Cpp, line, state, tokens);
+                count += tokens.size();
+            }
+        }
+        Q_UNUSED(count)
+    }
+
+    void codeLexerFindsTokens()
+    {
+        QCOMPARE(HPECodeLexer::languageOf(u"C++"), HPECodeLexer::Cpp);
+        QCOMPARE(HPECodeLexer::languageOf(u" python {.line-numbers}"), HPECodeLexer::Python);
+        QCOMPARE(HPECodeLexer::languageOf(u"Brainfuck"), HPECodeLexer::None);
+
+        int state = HPECodeLexer::Normal;
+        QCOMPARE(codeTokensOf(HPECodeLexer::Cpp, "return nullptr; /* open", state),
+                 QList<QList<int>>({ { HPECodeLexer::Keyword, 0, 6 }, { HPECodeLexer::Literal, 7, 7 },
+                                     { HPECodeLexer::Comment, 16, 7 } }));
+        QCOMPARE(state, int(HPECodeLexer::BlockComment));
+        QCOMPARE(codeTokensOf(HPECodeLexer::Cpp, "*/ 42", state),
+                 QList<QList<int>>({ { HPECodeLexer::Comment, 0, 2 }, { HPECodeLexer::Number, 3, 2 } }));
+        QCOMPARE(state, int(HPECodeLexer::Normal));
+
+        QCOMPARE(codeTokensOf(HPECodeLexer::Python, "s = '''doc", state),
+                 QList<QList<int>>({ { HPECodeLexer::String, 4, 6 } }));
+        QCOMPARE(state, int(HPECodeLexer::TripleSingleQuotes));
+        QCOMPARE(codeTokensOf(HPECodeLexer::Python, "more''' if True  # c", state),
+                 QList<QList<int>>({ { HPECodeLexer::String, 0, 7 }, { HPECodeLexer::Keyword, 8, 2 },
+                                     { HPECodeLexer::Literal, 11, 4 }, { HPECodeLexer::Comment, 17, 3 } }));
+
+        QCOMPARE(codeTokensOf(HPECodeLexer::Bash, "echo $HOME a#b # c", state),
+                 QList<QList<int>>({ { HPECodeLexer::Keyword, 0, 4 }, { HPECodeLexer::Variable, 5, 5 },
+                                     { HPECodeLexer::Comment, 15, 3 } }));
+        QCOMPARE(codeTokensOf(HPECodeLexer::Json, "{ \"key\": \"value\" }", state),
+                 QList<QList<int>>({ { HPECodeLexer::Key, 2, 5 }, { HPECodeLexer::String, 9, 7 } }));
+    }
+
+    void highlightCodeWithinBudget()
+    {
+        QStringList lines({ "```cpp" });
+        for(int i = 0; i < 50000; ++i)
+            lines << QString("int value%1 = %1; // line %1").arg(i);
+        QTextDocument document(lines.join('\n'));
+        CountingHighlighter highlighter(&document);
+        const int fenceState = HPESyntaxHighlighter::CodeFence | (3 << HPESyntaxHighlighter::FenceLengthShift)
+                | (HPECodeLexer::Cpp << HPESyntaxHighlighter::LanguageShift);
+        highlighter.rehighlight();
+        QTRY_COMPARE_WITH_TIMEOUT(document.lastBlock().userState(), fenceState, 60000);
+
+        //opening a block comment changes the state of every line after it,
+        //the cascade stops when the time budget is used up and goes on in the next turns
+        QTextCursor cursor(document.findBlockByNumber(1));
+        highlighter.count = 0;
+        cursor.insertText("/* ");
+        QVERIFY(highlighter.count < document.blockCount() - 1);
+        QTRY_COMPARE_WITH_TIMEOUT(document.lastBlock().userState(),
+                                  fenceState | (HPECodeLexer::BlockComment << HPESyntaxHighlighter::LexerStateShift), 60000);
+    }
+
+    void openLargeFile()
+    {
+        //about 40 MB
+        QTemporaryDir dir;
+        QFile file(dir.filePath("large.md"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QByteArray chunk = m_text.toUtf8() + '\n';
+        for(int i = 0; i < 150; ++i)
+            file.write(chunk);
+        file.close();
+
+        HPEPieceTable table;
+        QBENCHMARK {
+            QVERIFY(table.open(file.fileName()));
+            QCOMPARE(table.lines(table.lineCount() / 2, 2), m_lines.mid(0, 2).join('\n'));
+        }
+        QCOMPARE(table.lineCount(), qint64(150 * m_lines.size() + 1));
+    }
+
+    void pieceTableEdits()
+    {
+        QTemporaryDir dir;
+        QFile file(dir.filePath("post.md"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("---\r\ntitle: Edits\r\n---\n" + m_text.toUtf8());
+        file.close();
+
+        QStringList lines = QStringList({ "---", "title: Edits", "---" }) + m_lines;
+        HPEPieceTable table;
+        QVERIFY(table.open(file.fileName()));
+        QCOMPARE(table.lines(0, 4), lines.mid(0, 4).join('\n'));
+
+        //windows are replaced like the editor does in large-file mode
+        for(int i = 0; i < 200; ++i)
+        {
+            int first = (i * 7919) % (lines.size() - 50);
+            QStringList window = lines.mid(first, 40);
+            window[i % 40] = QString("edited %1").arg(i);
+            window.insert(i % 7, QString("inserted %1\n").arg(i));
+            table.replaceLines(first, 40, window.join('\n'));
+            window = window.join('\n').split('\n');
+
+            lines.remove(first, 40);
+            for(int j = 0; j < window.size(); ++j)
+                lines.insert(first + j, window.at(j));
+            QCOMPARE(table.lineCount(), qint64(lines.size()));
+            QCOMPARE(table.lines(qMax(0, first - 1), window.size() + 2), lines.mid(qMax(0, first - 1), window.size() + 2).join('\n'));
+        }
+        QVERIFY(table.isModified());
+
+        QVERIFY(table.save(file.fileName()));
+        QVERIFY(!table.isModified());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(QString::fromUtf8(file.readAll()).replace("\r\n", "\n"), lines.join('\n'));
+    }
+
+    void pieceTableKeepsLineBreaks()
+    {
+        QTemporaryDir dir;
+        QFile file(dir.filePath("crlf.md"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(m_lines.join("\r\n").toUtf8());
+        file.close();
+
+        HPEPieceTable table;
+        QVERIFY(table.open(file.fileName()));
+        QCOMPARE(table.lineBreak(), QByteArray("\r\n"));
+
+        //about 2.5 MB of windows, the added buffer is compacted on the way
+        QStringList lines = m_lines;
+        for(int i = 0; i < 1000; ++i)
+        {
+            int first = (i * 7919) % (lines.size() - 50);
+            QStringList window = lines.mid(first, 40);
+            window[i % 40] += QString(" %1").arg(i);
+            table.replaceLines(first, 40, window.join('\n'));
+            for(int j = 0; j < window.size(); ++j)
+                lines[first + j] = window.at(j);
+        }
+        QCOMPARE(table.lines(0, table.lineCount()), lines.join('\n'));
+
+        QVERIFY(table.save(file.fileName()));
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QByteArray saved = file.readAll();
+        file.close();
+        QCOMPARE(saved.count("\r\n"), saved.count('\n'));
+        QCOMPARE(QString::fromUtf8(saved), lines.join("\r\n"));
+    }
+
+    void linkIndexFollowsEdits()
+    {
+        QTextDocument document(m_lines.mid(0, 400).join('\n'));
+        HPELinkIndex index(&document);
+        QCOMPARE(linksOf(index, document.blockCount()), linksOf(document));
+
+        QTextCursor cursor(&document);
+        for(int i = 0; i < 100; ++i)
+        {
+            cursor.setPosition((i * 7919) % document.characterCount());
+            switch(i % 4)
+            {
+            case 0: cursor.insertText(QString("[new %1](new-%1.md) ").arg(i)); break;
+            case 1: cursor.insertText("\n![split](split.png)\n"); break;
+            case 2: cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, 3); cursor.removeSelectedText(); break;
+            default: cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor, 5); cursor.insertText("<img src=\"r.png\">"); break;
+            }
+            QCOMPARE(linksOf(index, document.blockCount()), linksOf(document));
+        }
+        QCOMPARE(index.count(), linksOf(document).size());
+        QCOMPARE(index.links().size() + index.images().size(), index.count());
+
+        //images are resolved against the assets folder of the post
+        QTemporaryDir dir;
+        QVERIFY(QDir(dir.path()).mkpath("post"));
+        QFile image(dir.filePath("post/exists.png"));
+        QVERIFY(image.open(QIODevice::WriteOnly));
+        image.close();
+        HPEAssetResolver resolver;
+        resolver.setFilePath(dir.filePath("post.md"));
+        document.setPlainText("![a](exists.png) ![b](missing.png)\n[c](missing.md) ![d](https://example.com/d.png)");
+        QVector<HPELinkIndex::Entry> missing = index.missingImages(&resolver);
+        QCOMPARE(missing.size(), 1);
+        QCOMPARE(missing.first().url, QString("missing.png"));
+        QCOMPARE(missing.first().position, 17);
+    }
+
+    void headingIndexFollowsEdits()
+    {
+        QStringList lines({ "---", "# not a heading", "---" });
+        for(int i = 0; i < 200; ++i)
+            lines << QString("## Section %1").arg(i) << m_lines.mid(i * 5, 5)
+                  << (i % 10 == 0 ? "```bash" : "### Sub") << "# comment" << (i % 10 == 0 ? "```" : "text");
+        QTextDocument document(lines.join('\n'));
+        HPESyntaxHighlighter highlighter(&document);
+        HPEHeadingIndex index;
+        highlighter.setHeadingIndex(&index);
+        highlighter.rehighlight();
+        QCOMPARE(index.heading(0).title, QString("Section 0"));
+        QCOMPARE(index.heading(0).blockNumber, 3);
+        //the comment in the fence is skipped
+        QCOMPARE(index.heading(1).title, QString("Section 1"));
+        QCOMPARE(index.heading(3).level, 1);
+
+        QTextCursor cursor(&document);
+        for(int i = 0; i < 60; ++i)
+        {
+            cursor.setPosition((i * 7919) % document.characterCount());
+            switch(i % 4)
+            {
+            case 0: cursor.insertText(QString("\n# New %1\n").arg(i)); break;
+            case 1: cursor.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor, 4); cursor.removeSelectedText(); break;
+            case 2: cursor.movePosition(QTextCursor::StartOfBlock); cursor.insertText("#"); break;
+            default: cursor.insertText("\n```\n"); break;
+            }
+
+            QTextDocument expected(document.toPlainText());
+            HPESyntaxHighlighter expectedHighlighter(&expected);
+            HPEHeadingIndex expectedIndex;
+            expectedHighlighter.setHeadingIndex(&expectedIndex);
+            expectedHighlighter.rehighlight();
+            QCOMPARE(headingsOf(index), headingsOf(expectedIndex));
+        }
+
+        //the section of a position is found by binary search
+        QVERIFY(index.count() > 100);
+        int position = index.heading(100).position;
+        QCOMPARE(index.sectionAt(position), 100);
+        QCOMPARE(index.sectionAt(position - 1), 99);
+        QCOMPARE(index.sectionAt(0), -1);
+        int section = 0;
+        QBENCHMARK {
+            section += index.sectionAt(position);
+        }
+        Q_UNUSED(section)
+    }
+
+    void findByDocument()
+    {
+        QTextDocument document(m_text);
+        int count = 0;
+        QBENCHMARK {
+            for(QTextCursor cursor = document.find("Image"); !cursor.isNull(); cursor = document.find("Image", cursor))
+                ++count;
+        }
+        Q_UNUSED(count)
+    }
+
+    void findBySearcher()
+    {
+        QTextDocument document(m_text);
+        HPETextSearcher searcher("Image");
+        int count = 0;
+        QBENCHMARK {
+            for(QTextBlock block = document.firstBlock(); block.isValid(); block = block.next())
+                count += searcher.findAll(block.text()).size();
+        }
+        Q_UNUSED(count)
+    }
+
+    void searcherMatchesDocumentFind()
+    {
+        QTextDocument document(m_text + "\nſome KELVIN \u212Aelvin image1 images image.");
+        const QList<QPair<QString, HPETextSearcher::Options>> searches({
+            { "image", HPETextSearcher::NoOptions },
+            { "Image", HPETextSearcher::CaseSensitive },
+            { "image", HPETextSearcher::WholeWords },
+            { "some", HPETextSearcher::NoOptions },
+            { "kelvin", HPETextSearcher::NoOptions },
+            { "x", HPETextSearcher::NoOptions },
+            { "](", HPETextSearcher::CaseSensitive },
+            { "\\[link (\\d+)\\]", HPETextSearcher::RegularExpression },
+            { "IMAGE-\\d", HPETextSearcher::RegularExpression | HPETextSearcher::WholeWords }
+        });
+        for(const QPair<QString, HPETextSearcher::Options>& search : searches)
+        {
+            HPETextSearcher searcher(search.first, search.second);
+            QVERIFY(searcher.isValid());
+            QTextDocument::FindFlags flags;
+            if(search.second & HPETextSearcher::CaseSensitive)
+                flags |= QTextDocument::FindCaseSensitively;
+            if(search.second & HPETextSearcher::WholeWords)
+                flags |= QTextDocument::FindWholeWords;
+            QRegularExpression pattern(search.second & HPETextSearcher::RegularExpression
+                                       ? search.first : QRegularExpression::escape(search.first));
+            QCOMPARE(matchesOf(document, searcher), matchesOf(document, pattern, flags));
+        }
+
+        //the previous match, and the replacement with captures
+        HPETextSearcher searcher("\\[link (\\d+)\\]\\((.+?)\\)", HPETextSearcher::RegularExpression);
+        const QString line = m_lines.at(4);
+        HPETextSearcher::Match match;
+        QVERIFY(searcher.findLast(line, line.size(), match));
+        QCOMPARE(searcher.replacement(line, match, "[\\2](\\1) \\\\"), QString("[https://example.com/4](4) \\"));
+        QVERIFY(!searcher.findLast(line, match.start, match));
+        QVERIFY(!HPETextSearcher("(", HPETextSearcher::RegularExpression).isValid());
+        QVERIFY(HPETextSearcher("^", HPETextSearcher::RegularExpression).findAll(line).isEmpty());
+    }
+
+    void editSeparately()
+    {
+        HPEMarkdownEditor editor;
+        editor.loadText(m_text);
+        QTextCursor cursor(editor.document()->findBlockByNumber(2500));
+        QBENCHMARK {
+            //the mutations of a formatting action on a few lines
+            for(int i = 0; i < 4; ++i)
+            {
+                cursor.insertText(" **");
+                cursor.movePosition(QTextCursor::NextBlock);
+            }
+        }
+    }
+
+    void editInTransaction()
+    {
+        HPEMarkdownEditor editor;
+        editor.loadText(m_text);
+        QTextCursor cursor(editor.document()->findBlockByNumber(2500));
+        QBENCHMARK {
+            editor.beginEdit();
+            for(int i = 0; i < 4; ++i)
+            {
+                cursor.insertText(" **");
+                cursor.movePosition(QTextCursor::NextBlock);
+            }
+            editor.commitEdit();
+        }
+    }
+
+    void transactionChangesOnce()
+    {
+        HPEMarkdownEditor editor;
+        editor.loadText(m_lines.mid(0, 100).join('\n'));
+        QTextDocument* document = editor.document();
+        const QString text = document->toPlainText();
+        const int links = editor.linkIndex()->count();
+        QSignalSpy changes(document, &QTextDocument::contentsChange);
+
+        //a commit without a transaction is ignored
+        QVERIFY(!editor.isEditing());
+        editor.commitEdit();
+        QVERIFY(!editor.isEditing());
+
+        //only the outermost transaction is committed
+        QTextCursor cursor(document->findBlockByNumber(10));
+        editor.beginEdit();
+        editor.beginEdit();
+        QVERIFY(editor.isEditing());
+        cursor.insertText(" **");
+        editor.commitEdit();
+        QVERIFY(editor.isEditing());
+        cursor.setPosition(document->findBlockByNumber(12).position());
+        cursor.insertText("[a](b) ");
+        QCOMPARE(changes.count(), 0);
+        editor.commitEdit();
+        QVERIFY(!editor.isEditing());
+
+        //one notification for the blocks from the first to the last mutation
+        QCOMPARE(changes.count(), 1);
+        QCOMPARE(changes.first().at(0).toInt(), document->findBlockByNumber(10).position());
+        QCOMPARE(editor.linkIndex()->count(), links + 1);
+
+        //and one undo step
+        document->undo();
+        QCOMPARE(document->toPlainText(), text);
+        QCOMPARE(editor.linkIndex()->count(), links);
+    }
+
+    void formattingChangesOnce()
+    {
+        const QString text = "first line\nsecond line";
+        HPEMarkdownEditor editor;
+        editor.loadText(text);
+        QTextDocument* document = editor.document();
+        QSignalSpy changes(document, &QTextDocument::contentsChange);
+
+        QTextCursor cursor(document->findBlockByNumber(1));
+        cursor.movePosition(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+        editor.setTextCursor(cursor);
+        editor.wrapSelectionWithString("**");
+        QCOMPARE(changes.count(), 1);
+        QCOMPARE(document->toPlainText(), QString("first line\n **second** line"));
+        document->undo();
+        QCOMPARE(document->toPlainText(), text);
+
+        changes.clear();
+        cursor = QTextCursor(document->firstBlock());
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        editor.setTextCursor(cursor);
+        editor.insertString("<!-- more -->");
+        QCOMPARE(changes.count(), 1);
+        QCOMPARE(document->toPlainText(), QString("first line <!-- more -->\nsecond line"));
+        document->undo();
+        QCOMPARE(document->toPlainText(), text);
+    }
+
+    void insertStringAtNewLine()
+    {
+        const QString longLine = QStringList({ m_lines.at(0), m_lines.at(1), m_lines.at(2) }).join(' ');
+        const QString text = longLine + "\nlast line";
+        HPEMarkdownEditor editor;
+        editor.resize(300, 200);
+        editor.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&editor));
+        editor.loadText(text);
+        QTextDocument* document = editor.document();
+        QVERIFY(document->firstBlock().layout()->lineCount() > 1);
+        QSignalSpy changes(document, &QTextDocument::contentsChange);
+
+        //on the first visual line of a wrapped line, the string goes after the whole line
+        QTextCursor cursor(document->firstBlock());
+        cursor.setPosition(10);
+        editor.setTextCursor(cursor);
+        editor.insertString("---", true);
+        QCOMPARE(changes.count(), 1);
+        QCOMPARE(document->toPlainText(), longLine + "\n---\nlast line");
+        QCOMPARE(editor.textCursor().block().text(), QString("---"));
+        document->undo();
+        QCOMPARE(document->toPlainText(), text);
+
+        //on the last line, it goes after it too
+        changes.clear();
+        cursor.setPosition(document->lastBlock().position() + 4);
+        editor.setTextCursor(cursor);
+        editor.insertString("---", true);
+        QCOMPARE(changes.count(), 1);
+        QCOMPARE(document->toPlainText(), text + "\n---");
+        QCOMPARE(editor.textCursor().block().text(), QString("---"));
+        document->undo();
+        QCOMPARE(document->toPlainText(), text);
+    }
+
+    void windowStaysDuringTransaction()
+    {
+        QTemporaryDir dir;
+        QFile file(dir.filePath("large.md"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(m_text.toUtf8());
+        file.close();
+
+        HPEMarkdownEditor editor;
+        editor.resize(400, 300);
+        editor.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&editor));
+        QVERIFY(editor.loadLargeFile(file.fileName()));
+        QCOMPARE(editor.lineCount(), qint64(m_lines.size()));
+        QVERIFY(editor.blockCount() < m_lines.size());
+
+        //scrolling to the end of the window moves it, but not inside a transaction
+        editor.beginEdit();
+        editor.verticalScrollBar()->setValue(editor.verticalScrollBar()->maximum());
+        QCoreApplication::processEvents();
+        QCOMPARE(editor.document()->firstBlock().text(), m_lines.first());
+        editor.commitEdit();
+
+        QVERIFY(QMetaObject::invokeMethod(&editor, "slideWindow"));
+        QVERIFY(editor.document()->firstBlock().text() != m_lines.first());
+        QCOMPARE(editor.lineCount(), qint64(m_lines.size()));
+    }
+
+    void rendererMatchesCommonMark()
+    {
+        const QList<QPair<QString, QString>> cases = {
+            //emphasis
+            { "*a **b** c*", "<p><em>a <strong>b</strong> c</em></p>\n" },
+            { "***x*** and **a *b* c**", "<p><em><strong>x</strong></em> and <strong>a <em>b</em> c</strong></p>\n" },
+            { "*foo**bar**baz*", "<p><em>foo<strong>bar</strong>baz</em></p>\n" },
+            { "_a_b_ foo_bar_ *a*b*", "<p><em>a_b</em> foo_bar_ <em>a</em>b*</p>\n" },
+            { "**a* and ~~del~~ ~one~", "<p>*<em>a</em> and <del>del</del> ~one~</p>\n" },
+            //lists
+            { "- a\n- b", "<ul>\n<li>a</li>\n<li>b</li>\n</ul>\n" },
+            { "-\ttab\n\tcontinued", "<ul>\n<li>tab\ncontinued</li>\n</ul>\n" },
+            { "1. one\n\n2. two", "<ol>\n<li><p>one</p>\n</li>\n<li><p>two</p>\n</li>\n</ol>\n" },
+            { "- [x] done\n- [ ] todo", "<ul>\n<li><input checked=\"\" disabled=\"\" type=\"checkbox\"> done</li>\n"
+                                        "<li><input disabled=\"\" type=\"checkbox\"> todo</li>\n</ul>\n" },
+            //code
+            { "```cpp\nint *a*;\n```", "<pre><code class=\"hljs language-cpp\">int *a*;\n</code></pre>\n" },
+            { "    indented *code*", "<pre><code>indented *code*\n</code></pre>\n" },
+            { "`*a*` and ``a ` b``", "<p><code>*a*</code> and <code>a ` b</code></p>\n" },
+            //math, kept for KaTeX
+            { "$x*y*z$ and $a<b$", "<p>$x*y*z$ and $a&lt;b$</p>\n" },
+            { "$5 and *x* $10", "<p>$5 and <em>x</em> $10</p>\n" },
+            { "$ *a* $ and $*b*$1", "<p>$ <em>a</em> $ and $<em>b</em>$1</p>\n" },
+            { "\\$c$ *d*", "<p>$c$ <em>d</em></p>\n" },
+            { "$$E=mc^2$$", "<p>$$E=mc^2$$</p>\n" },
+            //links
+            { "[a](https://a.b \"t\") and ![i](/i.png)",
+              "<p><a href=\"https://a.b\" title=\"t\">a</a> and <img src=\"/i.png\" alt=\"i\"></p>\n" },
+            { "[a][ref], [Ref][] and [ref]\n\n[ref]: https://r.r \"Title\"",
+              "<p><a href=\"https://r.r\" title=\"Title\">a</a>, <a href=\"https://r.r\" title=\"Title\">Ref</a>"
+              " and <a href=\"https://r.r\" title=\"Title\">ref</a></p>\n" },
+            { "[undefined] and [x](y", "<p>[undefined] and [x](y</p>\n" },
+            { "<https://a.b> and <a@b.c>",
+              "<p><a href=\"https://a.b\">https://a.b</a> and <a href=\"mailto:a@b.c\">a@b.c</a></p>\n" }
+        };
+        HPEMarkdownRenderer renderer;
+        for(const auto& sample : cases)
+            QCOMPARE(renderer.render(sample.first), sample.second);
+
+        //top-level elements carry their lines for the scroll synchronization
+        renderer.setLineAnchors(true);
+        QCOMPARE(renderer.render("# H\n\npara\n\n- a"),
+                 QString("<h1 data-line=\"0\" id=\"h\">H</h1>\n<p data-line=\"2\">para</p>\n"
+                         "<ul data-line=\"4\">\n<li>a</li>\n</ul>\n"));
+    }
+
+    void scannerFindsAllImages()
+    {
+        QString line("![a](1.png) text ![b](<2 2.png>) <img alt=x src='3.png'> [![c](4.png)](link) `![d](no.png)`");
+        QStringList sources;
+        HPELinkScanner scanner(line);
+        HPELinkScanner::Match match;
+        while(scanner.next(match))
+            if(match.kind != HPELinkScanner::Link)
+                sources.append(line.mid(match.urlStart, match.urlLength));
+        QCOMPARE(sources, QStringList({ "1.png", "2 2.png", "3.png", "4.png" }));
+    }
+};
+
+QTEST_MAIN(HPEBenchmark)
+
+#include "main.moc"